@@ -0,0 +1,173 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Flow state lookups under a mixed load: reader threads resolve flow ids to
+// ports (packet-in) and ports to gemports (packet-out) while one writer
+// keeps adding and removing flows. Compares the former std::map tables
+// under one mutex with FlowState. Flow ids must stay below 16384.
+//
+//   bench/flow_state_bench [readers] [milliseconds] [flows]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "FlowState.h"
+
+// The tables and locking FlowState replaced
+class MapFlowState {
+  public:
+    void add_flow(uint32_t flow_id, bool downstream, uint32_t port_no, uint32_t gemport_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (downstream) {
+            port_to_flows_[port_no].insert(flow_id);
+            flowid_to_gemport_[flow_id] = gemport_id;
+        } else {
+            flowid_to_port_[flow_id] = port_no;
+        }
+    }
+
+    void remove_flow(uint32_t flow_id, bool downstream, uint32_t port_no) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (downstream) {
+            flowid_to_gemport_.erase(flow_id);
+            port_to_flows_[port_no].erase(flow_id);
+            if (port_to_flows_[port_no].empty()) port_to_flows_.erase(port_no);
+        } else {
+            flowid_to_port_.erase(flow_id);
+        }
+    }
+
+    uint32_t port_of_flow(uint32_t flow_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<uint32_t, uint32_t>::const_iterator it = flowid_to_port_.find(flow_id);
+        return it != flowid_to_port_.end() ? it->second : 0;
+    }
+
+    bool gemport_of_port(uint32_t port_no, uint32_t* gemport_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<uint32_t, std::set<uint32_t> >::const_iterator it = port_to_flows_.find(port_no);
+        if (it == port_to_flows_.end() || it->second.empty()) {
+            return false;
+        }
+        std::map<uint32_t, uint32_t>::const_iterator fit = flowid_to_gemport_.find(*it->second.begin());
+        if (fit == flowid_to_gemport_.end()) {
+            return false;
+        }
+        *gemport_id = fit->second;
+        return true;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::map<uint32_t, uint32_t> flowid_to_port_;
+    std::map<uint32_t, uint32_t> flowid_to_gemport_;
+    std::map<uint32_t, std::set<uint32_t> > port_to_flows_;
+};
+
+static void add(MapFlowState& s, uint32_t flow_id, bool ds, uint32_t port_no, uint32_t gemport_id) {
+    s.add_flow(flow_id, ds, port_no, gemport_id);
+}
+
+static void remove(MapFlowState& s, uint32_t flow_id, bool ds, uint32_t port_no) {
+    s.remove_flow(flow_id, ds, port_no);
+}
+
+static void add(FlowState& s, uint32_t flow_id, bool ds, uint32_t port_no, uint32_t gemport_id) {
+    FlowState::Update(s).add_flow(flow_id, ds, port_no, gemport_id, flow_id);
+}
+
+static void remove(FlowState& s, uint32_t flow_id, bool ds, uint32_t port_no) {
+    FlowState::Update(s).remove_flow(flow_id, ds);
+}
+
+// Flow i has port 1000 + i and gemport 2000 + i, upstream and downstream
+template <typename S>
+static void run(const char* name, S& state, unsigned readers, unsigned ms, uint32_t flows) {
+    for (uint32_t i = 1; i <= flows; i++) {
+        add(state, i, false, 1000 + i, 2000 + i);
+        add(state, i, true, 1000 + i, 2000 + i);
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> lookups(0), updates(0), wrong(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < readers; r++) {
+        threads.push_back(std::thread([&, r]() {
+            uint64_t n = 0, bad = 0;
+            uint32_t i = r * 7919;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t flow_id = 1 + (i++ % flows);
+                uint32_t port_no = state.port_of_flow(flow_id);
+                uint32_t gemport_id;
+                if (port_no != 0 && port_no != 1000 + flow_id) bad++;
+                if (state.gemport_of_port(1000 + flow_id, &gemport_id) && gemport_id != 2000 + flow_id) bad++;
+                n += 2;
+            }
+            lookups += n;
+            wrong += bad;
+        }));
+    }
+    threads.push_back(std::thread([&]() {
+        uint64_t n = 0;
+        uint32_t i = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint32_t flow_id = 1 + (i++ % flows);
+            remove(state, flow_id, false, 1000 + flow_id);
+            remove(state, flow_id, true, 1000 + flow_id);
+            add(state, flow_id, false, 1000 + flow_id, 2000 + flow_id);
+            add(state, flow_id, true, 1000 + flow_id, 2000 + flow_id);
+            n += 4;
+        }
+        updates += n;
+    }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    double secs = ms / 1000.0;
+    std::cout << name << ": " << (uint64_t)(lookups / secs) << " lookups/s, "
+              << (uint64_t)(updates / secs) << " updates/s, "
+              << wrong << " wrong" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned readers = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+    unsigned ms = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    uint32_t flows = argc > 3 ? strtoul(argv[3], NULL, 10) : 8192;
+
+    std::cout << readers << " readers, 1 writer, " << flows << " flows" << std::endl;
+    {
+        MapFlowState state;
+        run("std::map + mutex", state, readers, ms, flows);
+    }
+    {
+        FlowState state(16383, 32768);
+        run("FlowState", state, readers, ms, flows);
+    }
+    return 0;
+}
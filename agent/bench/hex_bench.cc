@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Compares the OMCI hex decode of OmciMsgOut_ before the hex codec (sprintf,
+// strcat and strtol per byte, then malloc and memcpy) with hex_decode():
+//
+//   bench/hex_bench [message bytes] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "hex_codec.h"
+
+#define MAX_CHAR_LENGTH 20
+
+static volatile uint8_t sink;
+
+// The decode loop OmciMsgOut_ used to run
+static void legacy_decode(const std::string& pkt, size_t len) {
+    uint8_t arraySend[len];
+    char str1[MAX_CHAR_LENGTH];
+    char str2[MAX_CHAR_LENGTH];
+    memset(&arraySend, 0, len);
+
+    for (size_t idx1 = 0, idx2 = 0; idx1 < len * 2; idx1++, idx2++) {
+        sprintf(str1, "%c", pkt[idx1]);
+        sprintf(str2, "%c", pkt[++idx1]);
+        strcat(str1, str2);
+        arraySend[idx2] = strtol(str1, NULL, 16);
+    }
+
+    uint8_t* val = (uint8_t*)malloc(len);
+    memcpy(val, arraySend, len);
+    sink = val[len - 1];
+    free(val);
+}
+
+template <typename F>
+static void run(const char* name, unsigned long iterations, size_t len, F decode) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) {
+        decode();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << name << ": " << (uint64_t)(iterations / elapsed.count()) << " msg/s, "
+              << elapsed.count() * 1e9 / iterations << " ns/msg, "
+              << (uint64_t)(iterations * len * 2 / elapsed.count() / 1000000) << " MB/s of hex"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t len = argc > 1 ? strtoul(argv[1], NULL, 10) : 44;
+    unsigned long iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    std::vector<uint8_t> frame(len);
+    for (size_t i = 0; i < len; i++) {
+        frame[i] = (uint8_t)(i * 37 + 11);
+    }
+    std::string pkt(len * 2, '\0');
+    hex_encode(frame.data(), len, &pkt[0]);
+    // Voltha may send either case
+    for (size_t i = 0; i < pkt.size(); i += 3) {
+        pkt[i] = toupper(pkt[i]);
+    }
+
+    std::vector<uint8_t> out(len);
+    if (!hex_decode(pkt.data(), len, out.data()) || out != frame ||
+        !hex_decode_scalar(pkt.data(), len, out.data()) || out != frame) {
+        std::cout << "hex_decode mismatch" << std::endl;
+        return 1;
+    }
+
+    std::cout << len << " byte messages" << std::endl;
+    run("sprintf/strtol", iterations, len, [&]() { legacy_decode(pkt, len); });
+    run("hex_decode_scalar", iterations, len, [&]() {
+        hex_decode_scalar(pkt.data(), len, out.data());
+        sink = out[len - 1];
+    });
+    run("hex_decode", iterations, len, [&]() {
+        hex_decode(pkt.data(), len, out.data());
+        sink = out[len - 1];
+    });
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Heap allocations per indication from construction to the stream: the
+// former path (nested messages built with new, the indication copied into a
+// std::queue and copied again on pop) against IndicationQueue and its pool,
+// also with the queue serializing as the async stream has it. The load mixes
+// packet-in, OMCI and port statistics indications, built the way the BAL
+// callbacks build them. Allocations are counted by replacing malloc and its
+// kin, which operator new and gRPC core allocate with, after two warm-up
+// batches: the stream holds on to one batch while the next is queued.
+//
+//   bench/ind_alloc_bench [packet bytes] [indications]
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "IndicationQueue.h"
+
+#define BATCH 64
+
+static std::atomic<uint64_t> allocs(0);
+
+// glibc's own entry points, which the replacements forward to
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t align, size_t size);
+
+void* malloc(size_t size) {
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void* memalign(size_t align, size_t size) {
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(align, size);
+}
+
+void* aligned_alloc(size_t align, size_t size) {
+    return memalign(align, size);
+}
+
+int posix_memalign(void** p, size_t align, size_t size) {
+    *p = memalign(align, size);
+    return *p != NULL ? 0 : ENOMEM;
+}
+}
+
+static std::string pkt;
+static std::string omci(48, '\x0b');
+static uint64_t sink;
+
+static void fill_port_stats(openolt::PortStatistics* port_stats, unsigned long i) {
+    port_stats->set_intf_id(i % 16);
+    port_stats->set_rx_bytes(i * 1500);
+    port_stats->set_rx_packets(i);
+    port_stats->set_tx_bytes(i * 1000);
+    port_stats->set_tx_packets(i);
+    port_stats->set_timestamp(i);
+}
+
+static void fill_pkt_ind(openolt::PacketIndication* pkt_ind, unsigned long i) {
+    pkt_ind->set_intf_type("pon");
+    pkt_ind->set_intf_id(i % 16);
+    pkt_ind->set_gemport_id(1024 + i % 512);
+    pkt_ind->set_flow_id(1 + i % 16383);
+    pkt_ind->set_port_no(i % 4096);
+}
+
+static void __attribute__((noinline)) copy_path(std::queue<openolt::Indication>& q, unsigned long first) {
+    for (unsigned long i = first; i < first + BATCH; i++) {
+        openolt::Indication ind;
+        if (i % 4 == 0) {
+            openolt::OmciIndication* omci_ind = new openolt::OmciIndication;
+            omci_ind->set_intf_id(i % 16);
+            omci_ind->set_onu_id(i % 128);
+            omci_ind->set_pkt(omci.data(), omci.size());
+            ind.set_allocated_omci_ind(omci_ind);
+        } else if (i % 4 == 3) {
+            openolt::PortStatistics* port_stats = new openolt::PortStatistics;
+            fill_port_stats(port_stats, i);
+            ind.set_allocated_port_stats(port_stats);
+        } else {
+            openolt::PacketIndication* pkt_ind = new openolt::PacketIndication;
+            fill_pkt_ind(pkt_ind, i);
+            pkt_ind->set_pkt(pkt.data(), pkt.size());
+            ind.set_allocated_pkt_ind(pkt_ind);
+        }
+        q.push(ind);
+    }
+    while (!q.empty()) {
+        openolt::Indication ind = q.front();
+        q.pop();
+        sink += ind.ByteSizeLong();
+    }
+}
+
+static void __attribute__((noinline)) pool_path(IndicationQueue& q, std::vector<QueuedIndication>& batch,
+                                                unsigned long first) {
+    for (unsigned long i = first; i < first + BATCH; i++) {
+        if (i % 4 == 0) {
+            IndicationPtr ind = q.get(openolt::Indication::kOmciInd);
+            openolt::OmciIndication* omci_ind = ind->mutable_omci_ind();
+            omci_ind->set_intf_id(i % 16);
+            omci_ind->set_onu_id(i % 128);
+            omci_ind->mutable_pkt()->assign(omci.data(), omci.size());
+            q.push(std::move(ind));
+        } else if (i % 4 == 3) {
+            IndicationPtr ind = q.get(openolt::Indication::kPortStats);
+            fill_port_stats(ind->mutable_port_stats(), i);
+            q.push(std::move(ind));
+        } else {
+            IndicationPtr ind = q.get(openolt::Indication::kPktInd);
+            openolt::PacketIndication* pkt_ind = ind->mutable_pkt_ind();
+            fill_pkt_ind(pkt_ind, i);
+            pkt_ind->mutable_pkt()->assign(pkt.data(), pkt.size());
+            q.push(std::move(ind));
+        }
+    }
+    batch.clear();
+    size_t n = q.pop_batch(batch, BATCH, 0);
+    for (size_t i = 0; i < n; i++) {
+        sink += batch[i].wire != NULL ? batch[i].wire_len : batch[i].ind->ByteSizeLong();
+    }
+}
+
+template <typename F>
+static void run(const char* name, unsigned long count, F batch) {
+    batch(0);
+    batch(BATCH);
+
+    uint64_t before = allocs.load();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 2 * BATCH; i < count; i += BATCH) {
+        batch(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t n = allocs.load() - before;
+
+    std::cout << name << ": " << (double)n / (count - 2 * BATCH) << " allocs/ind, "
+              << (uint64_t)((count - 2 * BATCH) / elapsed.count()) << " ind/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t len = argc > 1 ? strtoul(argv[1], NULL, 10) : 256;
+    unsigned long count = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    if (count < 3 * BATCH) {
+        count = 3 * BATCH;
+    }
+
+    pkt.assign(len, '\xa5');
+    std::queue<openolt::Indication> copy_q;
+    IndicationQueue q;
+    IndicationQueue serializing_q(true);
+    std::vector<QueuedIndication> batch;
+    batch.reserve(BATCH);
+
+    std::cout << len << " byte packets" << std::endl;
+    run("copy", count, [&](unsigned long i) { copy_path(copy_q, i); });
+    run("pool", count, [&](unsigned long i) { pool_path(q, batch, i); });
+    run("pool, serialized on push", count, [&](unsigned long i) { pool_path(serializing_q, batch, i); });
+    std::cout << "pool " << q.pool_counters_to_str() << std::endl;
+    std::cout << "serializing pool " << serializing_q.pool_counters_to_str() << " (" << sink << ")" << std::endl;
+    return 0;
+}
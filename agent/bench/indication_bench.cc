@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures how fast the agent streams indications, to one subscriber or to
+// several at once. Start the simulator with a flood of packet indications,
+// waiting for as many streams as the client opens, then point this client
+// at it:
+//
+//   sim/openoltsim --ind-flood 1000000 --ind-subscribers 8 &
+//   bench/indication_bench 127.0.0.1:9191 1000000 8
+//
+// Each subscriber reports its rate and the indications it lost by falling
+// behind the journal, seen as gaps in Indication.seq.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+#include <openolt.grpc.pb.h>
+
+struct Result {
+    uint64_t received;
+    uint64_t lost;
+    uint64_t bytes;
+    double seconds;
+};
+
+static void subscribe(std::shared_ptr<grpc::Channel> channel, uint64_t expected, Result* result) {
+    std::unique_ptr<openolt::Openolt::Stub> stub = openolt::Openolt::NewStub(channel);
+
+    grpc::ClientContext context;
+    openolt::IndicationRequest request;
+    std::unique_ptr<grpc::ClientReader<openolt::Indication> > reader(
+        stub->EnableIndication(&context, request));
+
+    openolt::Indication ind;
+    uint64_t last_seq = 0;
+    std::chrono::steady_clock::time_point start;
+
+    *result = Result();
+    while (result->received + result->lost < expected && reader->Read(&ind)) {
+        if (last_seq != 0 && ind.seq() > last_seq + 1) {
+            result->lost += ind.seq() - last_seq - 1;
+        }
+        last_seq = ind.seq();
+        if (!ind.has_pkt_ind()) {
+            continue;
+        }
+        if (result->received == 0) {
+            start = std::chrono::steady_clock::now();
+        }
+        result->received++;
+        result->bytes += ind.ByteSizeLong();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result->seconds = elapsed.count();
+    context.TryCancel();
+}
+
+int main(int argc, char** argv) {
+    std::string target = argc > 1 ? argv[1] : "127.0.0.1:9191";
+    uint64_t expected = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    int subscribers = argc > 3 ? atoi(argv[3]) : 1;
+
+    // A channel per subscriber, as separate adapters would have
+    std::vector<Result> results(subscribers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < subscribers; i++) {
+        std::shared_ptr<grpc::Channel> channel =
+            grpc::CreateChannel(target, grpc::InsecureChannelCredentials());
+        threads.push_back(std::thread(subscribe, channel, expected, &results[i]));
+    }
+
+    uint64_t total = 0;
+    double slowest = 0;
+    bool complete = true;
+    for (int i = 0; i < subscribers; i++) {
+        threads[i].join();
+        const Result& r = results[i];
+        std::cout << "subscriber " << i << ": received " << r.received << " indications in "
+                  << r.seconds << " s: " << (uint64_t)(r.received / r.seconds) << " ind/s, "
+                  << (uint64_t)(r.bytes / r.seconds / 1000000) << " MB/s, lost " << r.lost << std::endl;
+        total += r.received;
+        slowest = r.seconds > slowest ? r.seconds : slowest;
+        complete = complete && r.received == expected;
+    }
+    if (subscribers > 1) {
+        std::cout << subscribers << " subscribers: " << (uint64_t)(total / slowest)
+                  << " ind/s delivered in all" << std::endl;
+    }
+    return complete ? 0 : 1;
+}
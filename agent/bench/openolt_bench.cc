@@ -0,0 +1,607 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// End-to-end load generator. It plays the adapter against a running agent,
+// sim/openoltsim or mock_bal/openolt, through a sequence of workloads and
+// reports the throughput and latency percentiles of every RPC of each:
+//
+//   mock_bal/openolt --mock-onus 32 --mock-pkt-in-rate 1000 &
+//   bench/openolt_bench --seconds 10 activate omci flow_churn packet_out
+//
+// The workloads, run in the order given (all of them by default):
+//   activate           --waves waves of: delete the ONUs activated before,
+//                      disable and enable every PON, activate up to --onus
+//                      ONUs discovered and wait for them to come up. The
+//                      ONUs of the last wave are left up for the workloads
+//                      after it. onu_activation is from ActivateOnu to the
+//                      ONU's indication.
+//   omci               one OMCI request at a time to each ONU that is up;
+//                      omci_round_trip is from OmciMsgOut to the response.
+//   flow_churn         FlowAdd then FlowRemove of --flows flows per thread.
+//   packet_out         OnuPacketOut to the ONUs that are up.
+//   uplink_packet_out  UplinkPacketOut to NNI 0.
+//   indications        nothing but the indication stream.
+//
+// An indication stream is read throughout; the indications each workload
+// received are reported after it. The timed workloads run --threads
+// threads, each on its own channel, for --seconds.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+#include <openolt.grpc.pb.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct bench_config {
+    std::string target;
+    unsigned threads;
+    unsigned seconds;
+    unsigned onus;
+    unsigned waves;
+    unsigned flows;
+    unsigned pkt_size;
+    unsigned pons;
+    unsigned timeout;
+};
+
+static bench_config config = { "127.0.0.1:9191", 4, 10, 64, 3, 64, 64, 0, 10 };
+
+static unsigned elapsed_us(Clock::time_point begin) {
+    return (unsigned)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count();
+}
+
+static uint32_t onu_key(uint32_t intf_id, uint32_t onu_id) {
+    return (intf_id << 16) | onu_id;
+}
+
+// Latencies of one thread, by RPC, merged once the thread is done
+class Recorder {
+  public:
+    void add(const std::string& rpc, unsigned us, bool ok) {
+        Samples& s = samples_[rpc];
+        s.us.push_back(us);
+        s.errors += !ok;
+    }
+
+    void merge(const Recorder& other) {
+        for (std::map<std::string, Samples>::const_iterator it = other.samples_.begin();
+             it != other.samples_.end(); ++it) {
+            Samples& s = samples_[it->first];
+            s.us.insert(s.us.end(), it->second.us.begin(), it->second.us.end());
+            s.errors += it->second.errors;
+        }
+    }
+
+    uint64_t errors() const {
+        uint64_t errors = 0;
+        for (std::map<std::string, Samples>::const_iterator it = samples_.begin(); it != samples_.end(); ++it) {
+            errors += it->second.errors;
+        }
+        return errors;
+    }
+
+    void report(double seconds) {
+        if (samples_.empty()) {
+            return;
+        }
+        printf("  %-20s %9s %7s %10s %9s %9s %9s %9s\n",
+               "rpc", "count", "errors", "rate/s", "p50 us", "p99 us", "p999 us", "max us");
+        for (std::map<std::string, Samples>::iterator it = samples_.begin(); it != samples_.end(); ++it) {
+            std::vector<unsigned>& us = it->second.us;
+            if (us.empty()) {
+                continue;
+            }
+            std::sort(us.begin(), us.end());
+            printf("  %-20s %9zu %7llu %10.0f %9u %9u %9u %9u\n",
+                   it->first.c_str(), us.size(), (unsigned long long)it->second.errors,
+                   us.size() / seconds, percentile(us, 500), percentile(us, 990),
+                   percentile(us, 999), us.back());
+        }
+    }
+
+  private:
+    struct Samples {
+        Samples() : errors(0) { }
+        std::vector<unsigned> us;
+        uint64_t errors;
+    };
+
+    static unsigned percentile(const std::vector<unsigned>& sorted, unsigned per_mille) {
+        return sorted[std::min(sorted.size() - 1, sorted.size() * per_mille / 1000)];
+    }
+
+    std::map<std::string, Samples> samples_;
+};
+
+// Reads the indication stream, counting indications by type, and keeps
+// what the workloads wait on: ONUs discovered, ONUs up and OMCI responses.
+class IndicationReader {
+  public:
+    struct Discovery {
+        uint32_t intf_id;
+        openolt::SerialNumber serial_number;
+    };
+
+    explicit IndicationReader(openolt::Openolt::Stub* stub) : stub_(stub), done_(false) { }
+
+    void start() {
+        thread_ = std::thread(&IndicationReader::run, this);
+    }
+
+    void stop() {
+        context_.TryCancel();
+        thread_.join();
+    }
+
+    // Counts since the last call
+    std::map<std::string, uint64_t> take_counts() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, uint64_t> counts;
+        counts.swap(counts_);
+        return counts;
+    }
+
+    std::vector<Discovery> take_discoveries() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Discovery> discoveries;
+        discoveries.swap(discoveries_);
+        return discoveries;
+    }
+
+    // Waits for up to timeout for a discovery, false if there was none
+    bool wait_discovery(Clock::duration timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this]() { return !discoveries_.empty() || done_; }) &&
+               !discoveries_.empty();
+    }
+
+    // When the ONU came up, or the epoch if it is not up
+    Clock::time_point wait_up(uint32_t key, Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, deadline, [this, key]() { return up_.count(key) || done_; });
+        std::map<uint32_t, Clock::time_point>::const_iterator it = up_.find(key);
+        return it == up_.end() ? Clock::time_point() : it->second;
+    }
+
+    std::vector<uint32_t> onus_up() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<uint32_t> keys;
+        for (std::map<uint32_t, Clock::time_point>::const_iterator it = up_.begin(); it != up_.end(); ++it) {
+            keys.push_back(it->first);
+        }
+        return keys;
+    }
+
+    uint64_t omci_responses(uint32_t key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return omci_[key];
+    }
+
+    // Waits for the ONU's OMCI response count to pass count
+    bool wait_omci(uint32_t key, uint64_t count, Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_until(lock, deadline, [this, key, count]() { return omci_[key] > count || done_; }) &&
+               omci_[key] > count;
+    }
+
+  private:
+    void run() {
+        openolt::IndicationRequest request;
+        openolt::Indication ind;
+        std::unique_ptr<grpc::ClientReader<openolt::Indication> > reader(
+            stub_->EnableIndication(&context_, request));
+
+        while (reader->Read(&ind)) {
+            const google::protobuf::FieldDescriptor* field =
+                openolt::Indication::descriptor()->FindFieldByNumber(ind.data_case());
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            counts_[field ? field->name() : "unknown"]++;
+            if (ind.has_onu_disc_ind()) {
+                Discovery disc = { ind.onu_disc_ind().intf_id(), ind.onu_disc_ind().serial_number() };
+                discoveries_.push_back(disc);
+            } else if (ind.has_onu_ind()) {
+                uint32_t key = onu_key(ind.onu_ind().intf_id(), ind.onu_ind().onu_id());
+                if (ind.onu_ind().oper_state() == "up") {
+                    up_.insert(std::make_pair(key, Clock::now()));
+                } else {
+                    up_.erase(key);
+                }
+            } else if (ind.has_omci_ind()) {
+                omci_[onu_key(ind.omci_ind().intf_id(), ind.omci_ind().onu_id())]++;
+            } else {
+                continue;
+            }
+            cv_.notify_all();
+        }
+        grpc::Status status = reader->Finish();
+        if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+            std::cout << "indication stream failed: " << status.error_message() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    openolt::Openolt::Stub* stub_;
+    grpc::ClientContext context_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_;
+    std::map<std::string, uint64_t> counts_;
+    std::vector<Discovery> discoveries_;
+    std::map<uint32_t, Clock::time_point> up_;
+    std::map<uint32_t, uint64_t> omci_;
+};
+
+struct ActiveOnu {
+    uint32_t intf_id;
+    uint32_t onu_id;
+    openolt::SerialNumber serial_number;
+};
+
+static std::unique_ptr<openolt::Openolt::Stub> new_stub(int n) {
+    // A channel of its own, so the threads do not share a connection
+    grpc::ChannelArguments args;
+    args.SetInt("bench.channel", n);
+    return openolt::Openolt::NewStub(
+        grpc::CreateCustomChannel(config.target, grpc::InsecureChannelCredentials(), args));
+}
+
+static grpc::Status onu_call(openolt::Openolt::Stub* stub, const ActiveOnu& onu, bool activate) {
+    grpc::ClientContext context;
+    openolt::Onu request;
+    openolt::Empty empty;
+
+    request.set_intf_id(onu.intf_id);
+    request.set_onu_id(onu.onu_id);
+    *request.mutable_serial_number() = onu.serial_number;
+    return activate ? stub->ActivateOnu(&context, request, &empty) :
+                      stub->DeleteOnu(&context, request, &empty);
+}
+
+static grpc::Status pon_call(openolt::Openolt::Stub* stub, uint32_t intf_id, bool enable) {
+    grpc::ClientContext context;
+    openolt::Interface request;
+    openolt::Empty empty;
+
+    request.set_intf_id(intf_id);
+    return enable ? stub->EnablePonIf(&context, request, &empty) :
+                    stub->DisablePonIf(&context, request, &empty);
+}
+
+static void activate(openolt::Openolt::Stub* stub, IndicationReader& reader,
+                     std::vector<ActiveOnu>& active, Recorder& recorder) {
+    Clock::time_point begin;
+
+    for (unsigned wave = 0; wave < config.waves; wave++) {
+        for (size_t i = 0; i < active.size(); i++) {
+            begin = Clock::now();
+            recorder.add("DeleteOnu", elapsed_us(begin), onu_call(stub, active[i], false).ok());
+        }
+        active.clear();
+
+        // Discoveries of ONUs activated before the PONs go down are stale
+        reader.take_discoveries();
+        for (uint32_t pon = 0; pon < config.pons; pon++) {
+            begin = Clock::now();
+            recorder.add("DisablePonIf", elapsed_us(begin), pon_call(stub, pon, false).ok());
+        }
+        reader.take_discoveries();
+        for (uint32_t pon = 0; pon < config.pons; pon++) {
+            begin = Clock::now();
+            recorder.add("EnablePonIf", elapsed_us(begin), pon_call(stub, pon, true).ok());
+        }
+
+        // ONUs are activated as they are discovered, until a second passes
+        // without a new one
+        std::set<std::string> seen;
+        std::vector<Clock::time_point> activated;
+        std::vector<uint32_t> next_onu_id(config.pons, 1);
+        while (active.size() < config.onus && reader.wait_discovery(std::chrono::seconds(1))) {
+            std::vector<IndicationReader::Discovery> discoveries = reader.take_discoveries();
+            for (size_t i = 0; i < discoveries.size() && active.size() < config.onus; i++) {
+                const IndicationReader::Discovery& disc = discoveries[i];
+                if (disc.intf_id >= config.pons ||
+                    !seen.insert(std::to_string(disc.intf_id) + disc.serial_number.SerializeAsString()).second) {
+                    continue;
+                }
+                ActiveOnu onu = { disc.intf_id, next_onu_id[disc.intf_id]++, disc.serial_number };
+                begin = Clock::now();
+                grpc::Status status = onu_call(stub, onu, true);
+                recorder.add("ActivateOnu", elapsed_us(begin), status.ok());
+                if (status.ok()) {
+                    active.push_back(onu);
+                    activated.push_back(begin);
+                }
+            }
+        }
+
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(config.timeout);
+        unsigned up = 0;
+        for (size_t i = 0; i < active.size(); i++) {
+            Clock::time_point when = reader.wait_up(onu_key(active[i].intf_id, active[i].onu_id), deadline);
+            bool ok = when != Clock::time_point();
+            unsigned us = ok ? (unsigned)std::chrono::duration_cast<std::chrono::microseconds>(
+                when - activated[i]).count() : elapsed_us(activated[i]);
+            recorder.add("onu_activation", us, ok);
+            up += ok;
+        }
+        std::cout << "  wave " << wave + 1 << ": " << active.size() << " ONUs activated, "
+                  << up << " up" << std::endl;
+    }
+}
+
+static std::vector<uint32_t> onus_or_none(IndicationReader& reader) {
+    std::vector<uint32_t> onus = reader.onus_up();
+    if (onus.empty()) {
+        std::cout << "  no ONU is up, run activate first" << std::endl;
+    }
+    return onus;
+}
+
+static void omci(openolt::Openolt::Stub* stub, IndicationReader& reader, uint32_t key, Recorder& recorder,
+                 Clock::time_point end) {
+    openolt::OmciMsg msg;
+    openolt::Empty empty;
+
+    msg.set_intf_id(key >> 16);
+    msg.set_onu_id(key & 0xffff);
+    // MIB upload of the ONU data ME, as hex
+    msg.set_pkt("00014d0a00020000000000000000000000000000000000000000000000000000000000000000000000000028");
+
+    uint64_t count = reader.omci_responses(key);
+    while (Clock::now() < end) {
+        grpc::ClientContext context;
+        Clock::time_point begin = Clock::now();
+        grpc::Status status = stub->OmciMsgOut(&context, msg, &empty);
+        recorder.add("OmciMsgOut", elapsed_us(begin), status.ok());
+        if (!status.ok()) {
+            continue;
+        }
+        bool ok = reader.wait_omci(key, count, begin + std::chrono::seconds(config.timeout));
+        recorder.add("omci_round_trip", elapsed_us(begin), ok);
+        if (!ok) {
+            // Another response may arrive late; start counting afresh
+            count = reader.omci_responses(key);
+        } else {
+            count++;
+        }
+    }
+}
+
+static void flow_churn(openolt::Openolt::Stub* stub, const std::vector<uint32_t>& onus, unsigned t,
+                       Recorder& recorder, Clock::time_point end) {
+    std::vector<openolt::Flow> flows(config.flows);
+
+    for (unsigned i = 0; i < config.flows; i++) {
+        uint32_t n = t * config.flows + i;
+        uint32_t key = onus.empty() ? onu_key(n % std::max(config.pons, 1u), 1 + n % 128) : onus[n % onus.size()];
+        openolt::Flow& flow = flows[i];
+        flow.set_access_intf_id(key >> 16);
+        flow.set_onu_id(key & 0xffff);
+        flow.set_flow_id(1 + n % 16383);
+        flow.set_flow_type("upstream");
+        flow.set_alloc_id(1024 + n % 512);
+        flow.set_gemport_id(1024 + n % 512);
+        flow.set_port_no(n);
+        flow.mutable_classifier()->set_o_vid(n % 4096);
+        flow.mutable_action()->mutable_cmd()->set_add_outer_tag(true);
+    }
+
+    while (Clock::now() < end) {
+        for (int remove = 0; remove < 2; remove++) {
+            for (size_t i = 0; i < flows.size(); i++) {
+                grpc::ClientContext context;
+                openolt::Empty empty;
+                Clock::time_point begin = Clock::now();
+                grpc::Status status = remove ? stub->FlowRemove(&context, flows[i], &empty) :
+                                               stub->FlowAdd(&context, flows[i], &empty);
+                recorder.add(remove ? "FlowRemove" : "FlowAdd", elapsed_us(begin), status.ok());
+            }
+        }
+    }
+}
+
+static void packet_out(openolt::Openolt::Stub* stub, const std::vector<uint32_t>& onus, bool uplink,
+                       unsigned t, Recorder& recorder, Clock::time_point end) {
+    openolt::OnuPacket onu_pkt;
+    openolt::UplinkPacket uplink_pkt;
+    openolt::Empty empty;
+    std::string pkt(config.pkt_size, '\xa5');
+
+    onu_pkt.set_pkt(pkt);
+    uplink_pkt.set_intf_id(0);
+    uplink_pkt.set_pkt(pkt);
+
+    for (uint32_t n = t; Clock::now() < end; n++) {
+        grpc::ClientContext context;
+        Clock::time_point begin = Clock::now();
+        grpc::Status status;
+        if (uplink) {
+            status = stub->UplinkPacketOut(&context, uplink_pkt, &empty);
+            recorder.add("UplinkPacketOut", elapsed_us(begin), status.ok());
+        } else {
+            onu_pkt.set_intf_id(onus[n % onus.size()] >> 16);
+            onu_pkt.set_onu_id(onus[n % onus.size()] & 0xffff);
+            status = stub->OnuPacketOut(&context, onu_pkt, &empty);
+            recorder.add("OnuPacketOut", elapsed_us(begin), status.ok());
+        }
+    }
+}
+
+// Runs fn(stub, thread, recorder) on --threads threads and merges what they
+// recorded
+template <typename F>
+static void run_threads(unsigned nthreads, Recorder& recorder, F fn) {
+    std::vector<Recorder> recorders(nthreads);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < nthreads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            std::unique_ptr<openolt::Openolt::Stub> stub = new_stub(t + 1);
+            fn(stub.get(), t, recorders[t]);
+        }));
+    }
+    for (unsigned t = 0; t < nthreads; t++) {
+        threads[t].join();
+        recorder.merge(recorders[t]);
+    }
+}
+
+static bool uint_arg(int argc, char** argv, int* i, const char* name, unsigned* value) {
+    if (strcmp(argv[*i], name) != 0 || *i + 1 >= argc) {
+        return false;
+    }
+    *value = strtoul(argv[++*i], NULL, 10);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> workloads;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            config.target = argv[++i];
+        } else if (uint_arg(argc, argv, &i, "--threads", &config.threads) ||
+                   uint_arg(argc, argv, &i, "--seconds", &config.seconds) ||
+                   uint_arg(argc, argv, &i, "--onus", &config.onus) ||
+                   uint_arg(argc, argv, &i, "--waves", &config.waves) ||
+                   uint_arg(argc, argv, &i, "--flows", &config.flows) ||
+                   uint_arg(argc, argv, &i, "--pkt-size", &config.pkt_size) ||
+                   uint_arg(argc, argv, &i, "--pons", &config.pons) ||
+                   uint_arg(argc, argv, &i, "--timeout", &config.timeout)) {
+            continue;
+        } else if (argv[i][0] == '-') {
+            std::cout << "usage: " << argv[0] << " [--target host:port] [--threads n] [--seconds n]"
+                      << " [--onus n] [--waves n] [--flows n] [--pkt-size n] [--pons n] [--timeout s]"
+                      << " [activate|omci|flow_churn|packet_out|uplink_packet_out|indications]..."
+                      << std::endl;
+            return 2;
+        } else {
+            workloads.push_back(argv[i]);
+        }
+    }
+    if (workloads.empty()) {
+        const char* all[] = { "activate", "omci", "flow_churn", "packet_out", "uplink_packet_out", "indications" };
+        workloads.assign(all, all + sizeof(all) / sizeof(all[0]));
+    }
+    config.threads = std::max(config.threads, 1u);
+
+    std::unique_ptr<openolt::Openolt::Stub> stub = new_stub(0);
+    IndicationReader reader(stub.get());
+    uint64_t errors = 0;
+
+    {
+        grpc::ClientContext context;
+        openolt::Empty empty;
+        openolt::DeviceInfo info;
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(config.timeout));
+        grpc::Status status = stub->GetDeviceInfo(&context, empty, &info);
+        if (!status.ok()) {
+            std::cout << "GetDeviceInfo from " << config.target << " failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (config.pons == 0) {
+            config.pons = info.pon_ports();
+        }
+        std::cout << config.target << ": " << info.vendor() << " " << info.model() << ", "
+                  << config.pons << " PONs" << std::endl;
+    }
+    reader.start();
+
+    std::vector<ActiveOnu> active;
+    for (size_t w = 0; w < workloads.size(); w++) {
+        const std::string& workload = workloads[w];
+        Recorder recorder;
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::seconds(config.seconds);
+
+        std::cout << workload << ":" << std::endl;
+        reader.take_counts();
+        if (workload == "activate") {
+            activate(stub.get(), reader, active, recorder);
+        } else if (workload == "omci") {
+            std::vector<uint32_t> onus = onus_or_none(reader);
+            run_threads(std::min((size_t)config.threads, onus.size()), recorder,
+                [&](openolt::Openolt::Stub* stub, unsigned t, Recorder& recorder) {
+                    // Each ONU has one request in flight; the thread's ONUs share its channel
+                    std::vector<std::thread> onu_threads;
+                    std::vector<Recorder> onu_recorders(onus.size());
+                    for (size_t i = t; i < onus.size(); i += config.threads) {
+                        onu_threads.push_back(std::thread([&, i]() {
+                            omci(stub, reader, onus[i], onu_recorders[i], end);
+                        }));
+                    }
+                    for (size_t i = 0; i < onu_threads.size(); i++) {
+                        onu_threads[i].join();
+                    }
+                    for (size_t i = t; i < onus.size(); i += config.threads) {
+                        recorder.merge(onu_recorders[i]);
+                    }
+                });
+        } else if (workload == "flow_churn") {
+            std::vector<uint32_t> onus = reader.onus_up();
+            run_threads(config.threads, recorder,
+                [&](openolt::Openolt::Stub* stub, unsigned t, Recorder& recorder) {
+                    flow_churn(stub, onus, t, recorder, end);
+                });
+        } else if (workload == "packet_out" || workload == "uplink_packet_out") {
+            bool uplink = workload == "uplink_packet_out";
+            std::vector<uint32_t> onus = uplink ? std::vector<uint32_t>() : onus_or_none(reader);
+            run_threads(uplink || !onus.empty() ? config.threads : 0, recorder,
+                [&](openolt::Openolt::Stub* stub, unsigned t, Recorder& recorder) {
+                    packet_out(stub, onus, uplink, t, recorder, end);
+                });
+        } else if (workload == "indications") {
+            std::this_thread::sleep_until(end);
+        } else {
+            std::cout << "  unknown workload" << std::endl;
+            errors++;
+            continue;
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "  " << seconds << " s" << std::endl;
+        recorder.report(seconds);
+        std::map<std::string, uint64_t> counts = reader.take_counts();
+        for (std::map<std::string, uint64_t>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+            printf("  %-20s %9llu %18.0f/s\n", it->first.c_str(), (unsigned long long)it->second,
+                   it->second / seconds);
+        }
+        errors += recorder.errors();
+    }
+
+    reader.stop();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Packet-out payload handling in packets/sec: the former copy path
+// (std::string by value, malloc, memcpy, free) against PktOutData, both in
+// place and through the pool. The send stand-in copies the payload once,
+// as bcmbal_pkt_send() does into its message.
+//
+//   bench/pkt_out_bench [packet bytes] [packets]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "PktBufPool.h"
+
+static char bal_msg[65536];
+
+static void __attribute__((noinline)) pkt_send(const char* data, uint32_t len) {
+    memcpy(bal_msg, data, len);
+}
+
+static void __attribute__((noinline)) copy_path(uint32_t intf_id, const std::string pkt) {
+    uint8_t* val = (uint8_t*)malloc(pkt.size());
+    memcpy(val, (uint8_t*)pkt.data(), pkt.size());
+    pkt_send((const char*)val, pkt.size());
+    free(val);
+}
+
+static void __attribute__((noinline)) zero_copy_path(PktBufPool* pool, uint32_t intf_id,
+                                                     const std::string& pkt) {
+    PktOutData data(pool, pkt);
+    pkt_send(data.data(), data.size());
+}
+
+template <typename F>
+static void run(const char* name, unsigned long packets, F send) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < packets; i++) {
+        send(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << name << ": " << (uint64_t)(packets / elapsed.count()) << " pkt/s, "
+              << elapsed.count() * 1e9 / packets << " ns/pkt" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t len = argc > 1 ? strtoul(argv[1], NULL, 10) : 512;
+    unsigned long packets = argc > 2 ? strtoul(argv[2], NULL, 10) : 5000000;
+
+    std::string pkt(len, '\xa5');
+    // Alignment no std::string payload meets, so every packet takes the pool
+    PktBufPool pooled(64, 2048, 4096);
+
+    std::cout << len << " byte packets" << std::endl;
+    run("copy", packets, [&](unsigned long i) { copy_path(i % 16, pkt); });
+    run("zero copy", packets, [&](unsigned long i) { zero_copy_path(NULL, i % 16, pkt); });
+    run("pool fallback", packets, [&](unsigned long i) { zero_copy_path(&pooled, i % 16, pkt); });
+    std::cout << "pool misses " << pooled.misses() << std::endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Compares the mutex based Queue<T> with the lock-free RingQueue<T> under
+// the indication path's access pattern: several producer threads (BAL
+// callbacks) and a single consumer (the EnableIndication writer).
+//
+// usage: queue_bench [producers] [items_per_producer]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Queue.h"
+#include "RingQueue.h"
+
+struct BenchMsg {
+    uint64_t seq;
+    char payload[56];
+};
+
+template <typename Q>
+static double run(Q& q, int producers, int items) {
+    std::vector<std::thread> threads;
+    uint64_t total = (uint64_t)producers * items;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(std::thread([&q, items, p]() {
+            BenchMsg msg = { };
+            for (int i = 0; i < items; i++) {
+                msg.seq = ((uint64_t)p << 32) | i;
+                q.push(msg);
+            }
+        }));
+    }
+
+    BenchMsg msg;
+    for (uint64_t n = 0; n < total; n++) {
+        q.pop(msg);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    return total / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    int items = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    std::cout << "producers " << producers << ", items/producer " << items << std::endl;
+
+    {
+        Queue<BenchMsg> q;
+        std::cout << "Queue<T>                    "
+                  << (uint64_t)run(q, producers, items) << " msgs/sec" << std::endl;
+    }
+    {
+        RingQueue<BenchMsg> q(16384, RING_OVERFLOW_BLOCK);
+        std::cout << "RingQueue<T> (block)        "
+                  << (uint64_t)run(q, producers, items) << " msgs/sec" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,259 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Unary RPC load generator. Each client thread issues RPCs back to back on
+// its own channel and records their latency:
+//
+//   sim/openoltsim &
+//   bench/rpc_bench 127.0.0.1:9191 flow_add 8 100000
+//
+// rpc is one of heartbeat, flow_add, omci or packet_out, or packet_out_stream
+// to send the packets over one PacketOut stream per thread; its latency is
+// that of a stream write. flow_add_batch sends FlowAddBatch requests of
+// [batch size] flows (default 64) and also reports flows/s:
+//
+//   bench/rpc_bench 127.0.0.1:9191 flow_add_batch 4 1000 128
+//
+// Under any other rpc, one more thread sends a heartbeat every 10 ms and
+// their latency is reported as well, to show whether slow handlers hold up
+// the rest of the server.
+//
+// Build the agent with -DASYNC_SERVER=0 to compare against the synchronous
+// server.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+#include <openolt.grpc.pb.h>
+
+enum bench_rpc {
+    RPC_HEARTBEAT, RPC_FLOW_ADD, RPC_FLOW_ADD_BATCH, RPC_OMCI, RPC_PACKET_OUT, RPC_PACKET_OUT_STREAM
+};
+
+static uint32_t flow_batch_size = 64;
+
+static void make_flow(openolt::Flow* flow, uint32_t n) {
+    flow->set_access_intf_id(n % 16);
+    flow->set_onu_id(1 + n % 128);
+    flow->set_flow_id(1 + n % 16383);
+    flow->set_flow_type("upstream");
+    flow->set_alloc_id(1024 + n % 512);
+    flow->set_gemport_id(1024 + n % 512);
+    flow->mutable_classifier()->set_o_vid(n % 4096);
+    flow->mutable_action()->mutable_cmd()->set_add_outer_tag(true);
+}
+
+static grpc::Status call(openolt::Openolt::Stub* stub, bench_rpc rpc, uint32_t n) {
+    grpc::ClientContext context;
+    openolt::Empty empty;
+
+    switch (rpc) {
+    case RPC_FLOW_ADD: {
+        openolt::Flow flow;
+        make_flow(&flow, n);
+        return stub->FlowAdd(&context, flow, &empty);
+    }
+    case RPC_FLOW_ADD_BATCH: {
+        openolt::Flows flows;
+        openolt::FlowResults results;
+        for (uint32_t i = 0; i < flow_batch_size; i++) {
+            make_flow(flows.add_flows(), n * flow_batch_size + i);
+        }
+        grpc::Status status = stub->FlowAddBatch(&context, flows, &results);
+        for (int i = 0; status.ok() && i < results.results_size(); i++) {
+            if (results.results(i).code() != grpc::StatusCode::OK) {
+                status = grpc::Status(grpc::StatusCode::INTERNAL, results.results(i).message());
+            }
+        }
+        return status;
+    }
+    case RPC_OMCI: {
+        openolt::OmciMsg omci;
+        omci.set_intf_id(n % 16);
+        omci.set_onu_id(1 + n % 128);
+        omci.set_pkt(std::string(80, 'a'));
+        return stub->OmciMsgOut(&context, omci, &empty);
+    }
+    case RPC_PACKET_OUT: {
+        openolt::OnuPacket pkt;
+        pkt.set_intf_id(n % 16);
+        pkt.set_onu_id(1 + n % 128);
+        pkt.set_pkt(std::string(64, '\xa5'));
+        return stub->OnuPacketOut(&context, pkt, &empty);
+    }
+    default: {
+        openolt::Heartbeat heartbeat;
+        return stub->HeartbeatCheck(&context, empty, &heartbeat);
+    }
+    }
+}
+
+// Sends count packets over a PacketOut stream. Returns the number of packets
+// reported failed, or count if the stream itself failed.
+static uint32_t stream_packets(openolt::Openolt::Stub* stub, uint32_t first, uint32_t count,
+                               std::vector<uint32_t>& latency_us) {
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientReaderWriter<openolt::PacketOutMsg, openolt::PacketOutResult> > stream(
+        stub->PacketOut(&context));
+    openolt::PacketOutMsg msg;
+    openolt::OnuPacket* pkt = msg.mutable_onu_pkt();
+    pkt->set_pkt(std::string(64, '\xa5'));
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n = first + i;
+        msg.set_seq(n);
+        pkt->set_intf_id(n % 16);
+        pkt->set_onu_id(1 + n % 128);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        if (!stream->Write(msg)) {
+            break;
+        }
+        latency_us.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    }
+    stream->WritesDone();
+
+    uint32_t failed = 0;
+    openolt::PacketOutResult result;
+    while (stream->Read(&result)) {
+        failed++;
+    }
+    return stream->Finish().ok() ? failed : count;
+}
+
+static std::unique_ptr<openolt::Openolt::Stub> new_stub(const std::string& target, int n) {
+    // A channel per thread so the threads do not share a connection
+    grpc::ChannelArguments args;
+    args.SetInt("bench.thread", n);
+    return openolt::Openolt::NewStub(
+        grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args));
+}
+
+static void print_latency(const std::vector<uint32_t>& sorted) {
+    std::cout << "latency us p50 " << sorted[sorted.size() / 2]
+              << " p99 " << sorted[sorted.size() * 99 / 100]
+              << " max " << sorted.back();
+}
+
+int main(int argc, char** argv) {
+    std::string target = argc > 1 ? argv[1] : "127.0.0.1:9191";
+    std::string rpc_name = argc > 2 ? argv[2] : "heartbeat";
+    int nthreads = argc > 3 ? atoi(argv[3]) : 4;
+    uint32_t per_thread = argc > 4 ? strtoul(argv[4], NULL, 10) / nthreads : 25000;
+    if (argc > 5) {
+        flow_batch_size = strtoul(argv[5], NULL, 10);
+    }
+
+    bench_rpc rpc = RPC_HEARTBEAT;
+    if (rpc_name == "flow_add") {
+        rpc = RPC_FLOW_ADD;
+    } else if (rpc_name == "flow_add_batch") {
+        rpc = RPC_FLOW_ADD_BATCH;
+    } else if (rpc_name == "omci") {
+        rpc = RPC_OMCI;
+    } else if (rpc_name == "packet_out") {
+        rpc = RPC_PACKET_OUT;
+    } else if (rpc_name == "packet_out_stream") {
+        rpc = RPC_PACKET_OUT_STREAM;
+    }
+
+    std::vector<std::vector<uint32_t> > latency_us(nthreads);
+    std::vector<uint32_t> errors(nthreads, 0);
+    std::vector<std::thread> threads;
+    std::atomic<bool> done(false);
+    std::vector<uint32_t> heartbeat_us;
+    std::thread heartbeat;
+
+    if (rpc != RPC_HEARTBEAT) {
+        heartbeat = std::thread([&]() {
+            std::unique_ptr<openolt::Openolt::Stub> stub = new_stub(target, nthreads);
+            while (!done.load()) {
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                call(stub.get(), RPC_HEARTBEAT, 0);
+                heartbeat_us.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 0; t < nthreads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            std::unique_ptr<openolt::Openolt::Stub> stub = new_stub(target, t);
+
+            latency_us[t].reserve(per_thread);
+            if (rpc == RPC_PACKET_OUT_STREAM) {
+                errors[t] = stream_packets(stub.get(), t * per_thread, per_thread, latency_us[t]);
+                return;
+            }
+            for (uint32_t i = 0; i < per_thread; i++) {
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                grpc::Status status = call(stub.get(), rpc, t * per_thread + i);
+                latency_us[t].push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                if (!status.ok()) {
+                    errors[t]++;
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < nthreads; t++) {
+        threads[t].join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    done = true;
+    if (heartbeat.joinable()) {
+        heartbeat.join();
+    }
+
+    std::vector<uint32_t> all;
+    uint64_t failed = 0;
+    for (int t = 0; t < nthreads; t++) {
+        all.insert(all.end(), latency_us[t].begin(), latency_us[t].end());
+        failed += errors[t];
+    }
+    if (all.empty()) {
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << rpc_name << ": " << all.size() << " rpcs from " << nthreads << " threads in "
+              << elapsed.count() << " s: " << (uint64_t)(all.size() / elapsed.count()) << " rpc/s";
+    if (rpc == RPC_FLOW_ADD_BATCH) {
+        std::cout << ", " << (uint64_t)(all.size() * flow_batch_size / elapsed.count()) << " flows/s";
+    }
+    std::cout << ", ";
+    print_latency(all);
+    std::cout << ", errors " << failed << std::endl;
+    if (!heartbeat_us.empty()) {
+        std::sort(heartbeat_us.begin(), heartbeat_us.end());
+        std::cout << "heartbeat: " << heartbeat_us.size() << " rpcs, ";
+        print_latency(heartbeat_us);
+        std::cout << std::endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "FastLog.h"
+
+FastLog fastLog;
+
+FastLogSite::FastLogSite(int level, uintptr_t log_id, const char* fmt, unsigned rate, unsigned burst) :
+    level(level), log_id(log_id), fmt(fmt),
+    interval_ns_(rate ? 1000000000ULL / rate : 0),
+    tolerance_ns_(burst > 1 ? (burst - 1) * interval_ns_ : 0),
+    tat_ns_(0), suppressed_(0), suppressed_total_(0) {
+    std::lock_guard<std::mutex> lock(fastLog.mutex_);
+    next_ = fastLog.sites_;
+    fastLog.sites_ = this;
+}
+
+FastLog::FastLog() : sites_(NULL), retired_logged_(0), retired_dropped_(0), written_(0) {
+}
+
+void FastLog::set_sink(const Sink& sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = sink;
+}
+
+FastLog::RingHandle::RingHandle() : ring(new Ring()) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->logged = 0;
+    ring->dropped = 0;
+    ring->retired = false;
+
+    {
+        std::lock_guard<std::mutex> lock(fastLog.mutex_);
+        fastLog.rings_.push_back(ring);
+    }
+    fastLog.start();
+}
+
+// The formatter deletes the ring once it has drained it
+FastLog::RingHandle::~RingHandle() {
+    ring->retired.store(true, std::memory_order_release);
+}
+
+FastLog::Ring* FastLog::thread_ring() {
+    static thread_local RingHandle handle;
+    return handle.ring;
+}
+
+void FastLog::put_arg(Record& rec, const char* value) {
+    size_t len = value ? strnlen(value, FAST_LOG_STRING_MAX) : 0;
+
+    if (value == NULL) {
+        put_raw(rec, ARG_POINTER, (uint64_t)0);
+    } else if (rec.size + 2 + len <= FAST_LOG_ARGS_SIZE) {
+        rec.args[rec.size] = ARG_STRING;
+        rec.args[rec.size + 1] = (char)len;
+        memcpy(rec.args + rec.size + 2, value, len);
+        rec.size += 2 + len;
+    }
+}
+
+void FastLog::start() {
+    std::call_once(started_, [this]() { std::thread(&FastLog::run, this).detach(); });
+}
+
+void FastLog::run() {
+    std::chrono::steady_clock::time_point summary = std::chrono::steady_clock::now();
+
+    for (;;) {
+        flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(FAST_LOG_FLUSH_MS));
+
+        if (std::chrono::steady_clock::now() - summary >= std::chrono::seconds(FAST_LOG_SUMMARY_PERIOD)) {
+            summarize();
+            summary = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+// Moves the records of every ring to batch, and deletes the rings of
+// threads that exited once they are empty
+size_t FastLog::drain(std::vector<Record>& batch) {
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+
+    for (size_t i = 0; i < rings.size(); i++) {
+        Ring* ring = rings[i];
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++) {
+            batch.push_back(ring->records[tail % FAST_LOG_RING_SIZE]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        if (retired) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            retired_logged_ += ring->logged.load(std::memory_order_relaxed);
+            retired_dropped_ += ring->dropped.load(std::memory_order_relaxed);
+            rings_.erase(std::find(rings_.begin(), rings_.end(), ring));
+            delete ring;
+        }
+    }
+    return batch.size();
+}
+
+void FastLog::flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    std::vector<Record> batch;
+    std::string text;
+
+    if (drain(batch) == 0) {
+        return;
+    }
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Record& a, const Record& b) { return a.ts_ns < b.ts_ns; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < batch.size(); i++) {
+        format(batch[i], text);
+        if (sink_) {
+            sink_(batch[i].site->level, batch[i].site->log_id, text.c_str());
+        } else {
+            std::cout << text;
+        }
+    }
+    written_.fetch_add(batch.size(), std::memory_order_relaxed);
+}
+
+// Replays the format with the recorded arguments, one conversion at a time
+void FastLog::format(const Record& rec, std::string& out) const {
+    const char* p = rec.site->fmt;
+    size_t pos = 0;
+    char buf[256];
+
+    out.clear();
+    while (*p) {
+        if (*p != '%') {
+            out += *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p += 2;
+            continue;
+        }
+
+        // The conversion, its length modifiers dropped
+        std::string spec(1, '%');
+        const char* q = p + 1;
+        while (*q && strchr("#0- +'123456789.", *q)) {
+            spec += *q++;
+        }
+        while (*q && strchr("hlLqjzt", *q)) {
+            q++;
+        }
+        char conv = *q;
+        if (conv == '\0' || pos >= rec.size) {
+            out.append(p, q - p + (conv ? 1 : 0));
+            p = q + (conv ? 1 : 0);
+            continue;
+        }
+        p = q + 1;
+
+        char type = rec.args[pos];
+        uint64_t raw = 0;
+        std::string str;
+        if (type == ARG_STRING) {
+            size_t len = (unsigned char)rec.args[pos + 1];
+            str.assign(rec.args + pos + 2, len);
+            pos += 2 + len;
+        } else {
+            memcpy(&raw, rec.args + pos + 1, sizeof(raw));
+            pos += 1 + sizeof(raw);
+        }
+        double real;
+        memcpy(&real, &raw, sizeof(real));
+
+        switch (conv) {
+        case 'd':
+        case 'i':
+            spec += "ll";
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), type == ARG_DOUBLE ? (long long)real : (long long)raw);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            spec += "ll";
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(),
+                     type == ARG_DOUBLE ? (unsigned long long)real : (unsigned long long)raw);
+            break;
+        case 'c':
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), (int)raw);
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), type == ARG_DOUBLE ? real : (double)(int64_t)raw);
+            break;
+        case 's':
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), type == ARG_STRING ? str.c_str() : "(null)");
+            break;
+        case 'p':
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), (void*)(uintptr_t)raw);
+            break;
+        default:
+            spec += conv;
+            snprintf(buf, sizeof(buf), "%s", spec.c_str());
+            break;
+        }
+        out += buf;
+    }
+}
+
+// One message per site that suppressed any since the last summary, with
+// the site's level and log id
+void FastLog::summarize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (FastLogSite* site = sites_; site != NULL; site = site->next_) {
+        uint64_t n = site->suppressed_.exchange(0, std::memory_order_relaxed);
+        if (n == 0) {
+            continue;
+        }
+        site->suppressed_total_ += n;
+
+        std::string fmt(site->fmt);
+        while (!fmt.empty() && fmt[fmt.size() - 1] == '\n') {
+            fmt.erase(fmt.size() - 1);
+        }
+        std::ostringstream text;
+        text << "suppressed " << n << " messages like \"" << fmt << "\" in the last "
+             << FAST_LOG_SUMMARY_PERIOD << "s\n";
+        if (sink_) {
+            sink_(site->level, site->log_id, text.str().c_str());
+        } else {
+            std::cout << text.str();
+        }
+    }
+}
+
+void FastLog::get_counters(fast_log_counters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    counters->logged = retired_logged_;
+    counters->dropped = retired_dropped_;
+    for (size_t i = 0; i < rings_.size(); i++) {
+        counters->logged += rings_[i]->logged.load(std::memory_order_relaxed);
+        counters->dropped += rings_[i]->dropped.load(std::memory_order_relaxed);
+    }
+    counters->suppressed = 0;
+    for (FastLogSite* site = sites_; site != NULL; site = site->next_) {
+        counters->suppressed += site->suppressed_total_ + site->suppressed_.load(std::memory_order_relaxed);
+    }
+    counters->written = written_.load(std::memory_order_relaxed);
+}
+
+std::string FastLog::counters_to_str() {
+    fast_log_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "logged " << c.logged
+        << " suppressed " << c.suppressed
+        << " dropped " << c.dropped
+        << " written " << c.written;
+    return out.str();
+}
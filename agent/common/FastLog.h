@@ -0,0 +1,249 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_FAST_LOG_H_
+#define OPENOLT_FAST_LOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Messages each call site may log per second, and in a burst above that.
+// FAST_LOG_RATE 0 lifts the limit.
+#ifndef FAST_LOG_RATE
+#define FAST_LOG_RATE 50
+#endif
+#ifndef FAST_LOG_BURST
+#define FAST_LOG_BURST 100
+#endif
+
+// Records each thread can have waiting for the formatter, and the bytes of
+// arguments a record holds. Strings are cut at FAST_LOG_STRING_MAX.
+#define FAST_LOG_RING_SIZE 1024
+#define FAST_LOG_ARGS_SIZE 104
+#define FAST_LOG_STRING_MAX 48
+
+// The formatter looks for records every FAST_LOG_FLUSH_MS when idle, and
+// reports the messages call sites suppressed every FAST_LOG_SUMMARY_PERIOD
+// seconds
+#define FAST_LOG_FLUSH_MS 10
+#define FAST_LOG_SUMMARY_PERIOD 10
+
+struct fast_log_counters {
+    uint64_t logged;        // records taken by the rings
+    uint64_t suppressed;    // over the rate of their call site
+    uint64_t dropped;       // ring full
+    uint64_t written;       // formatted and handed to the sink
+};
+
+// A log statement. Constructed once, as a static at the statement, and the
+// id of its format in the records.
+class FastLogSite {
+  public:
+    FastLogSite(int level, uintptr_t log_id, const char* fmt,
+                unsigned rate = FAST_LOG_RATE, unsigned burst = FAST_LOG_BURST);
+
+    FastLogSite(const FastLogSite&) = delete;
+    FastLogSite& operator=(const FastLogSite&) = delete;
+
+    // Token bucket as a virtual scheduling time: a message is let through
+    // unless the bucket would then be more than burst messages ahead of now
+    bool admit(uint64_t now_ns) {
+        if (interval_ns_ == 0) {
+            return true;
+        }
+        uint64_t tat = tat_ns_.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t base = tat > now_ns ? tat : now_ns;
+            if (base - now_ns > tolerance_ns_) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (tat_ns_.compare_exchange_weak(tat, base + interval_ns_, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    const int level;
+    const uintptr_t log_id;     // whatever the sink takes for one
+    const char* const fmt;
+
+  private:
+    friend class FastLog;
+
+    uint64_t interval_ns_;
+    uint64_t tolerance_ns_;
+    std::atomic<uint64_t> tat_ns_;
+    std::atomic<uint64_t> suppressed_;
+    uint64_t suppressed_total_;     // formatter only
+    FastLogSite* next_;
+};
+
+// Logging for hot paths. log() stores the site and the raw arguments into
+// a ring of the calling thread, without formatting or locking; a thread of
+// its own formats the records, in time order, and hands them to the sink.
+// Arguments are numbers, enums, pointers and C strings, the latter copied.
+// The format is printf's without '*' widths; integers print right whatever
+// length modifier the format gives them.
+//
+// Each site is rate limited. What it suppressed is reported as one message
+// every FAST_LOG_SUMMARY_PERIOD.
+class FastLog {
+  public:
+    typedef std::function<void(int level, uintptr_t log_id, const char* text)> Sink;
+
+    FastLog();
+
+    FastLog(const FastLog&) = delete;
+    FastLog& operator=(const FastLog&) = delete;
+
+    // Where messages go; to stdout until set
+    void set_sink(const Sink& sink);
+
+    template <typename... Args>
+    void log(FastLogSite& site, Args... args) {
+        uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (!site.admit(now)) {
+            return;
+        }
+        Ring* ring = thread_ring();
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->tail.load(std::memory_order_acquire) == FAST_LOG_RING_SIZE) {
+            bump(ring->dropped);
+            return;
+        }
+        Record& rec = ring->records[head % FAST_LOG_RING_SIZE];
+        rec.site = &site;
+        rec.ts_ns = now;
+        rec.size = 0;
+        put(rec, args...);
+        ring->head.store(head + 1, std::memory_order_release);
+        bump(ring->logged);
+    }
+
+    // Formats what the rings hold now, on the calling thread
+    void flush();
+
+    void get_counters(fast_log_counters* counters);
+    std::string counters_to_str();
+
+  private:
+    enum {
+        ARG_INT = 'i',
+        ARG_UINT = 'u',
+        ARG_DOUBLE = 'f',
+        ARG_STRING = 's',
+        ARG_POINTER = 'p',
+    };
+
+    struct Record {
+        const FastLogSite* site;
+        uint64_t ts_ns;
+        uint32_t size;
+        char args[FAST_LOG_ARGS_SIZE];
+    };
+
+    // One producer, the thread, and one consumer, the formatter
+    struct Ring {
+        Record records[FAST_LOG_RING_SIZE];
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> logged;
+        std::atomic<uint64_t> dropped;
+        std::atomic<bool> retired;      // the thread exited
+    };
+
+    struct RingHandle {
+        RingHandle();
+        ~RingHandle();
+        Ring* ring;
+    };
+
+    static Ring* thread_ring();
+    static void bump(std::atomic<uint64_t>& value) {
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void put(Record& rec) {}
+
+    template <typename T, typename... Args>
+    static void put(Record& rec, T arg, Args... args) {
+        put_arg(rec, arg);
+        put(rec, args...);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    put_arg(Record& rec, T value) {
+        put_raw(rec, ARG_INT, (int64_t)value);
+    }
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    put_arg(Record& rec, T value) {
+        put_raw(rec, ARG_UINT, (uint64_t)value);
+    }
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type put_arg(Record& rec, T value) {
+        put_raw(rec, ARG_INT, (int64_t)value);
+    }
+    static void put_arg(Record& rec, double value) {
+        put_raw(rec, ARG_DOUBLE, value);
+    }
+    static void put_arg(Record& rec, const void* value) {
+        put_raw(rec, ARG_POINTER, (uint64_t)(uintptr_t)value);
+    }
+    static void put_arg(Record& rec, const char* value);
+
+    template <typename T>
+    static void put_raw(Record& rec, char type, T value) {
+        if (rec.size + 1 + sizeof(value) <= FAST_LOG_ARGS_SIZE) {
+            rec.args[rec.size] = type;
+            memcpy(rec.args + rec.size + 1, &value, sizeof(value));
+            rec.size += 1 + sizeof(value);
+        }
+    }
+
+    void start();
+    void run();
+    size_t drain(std::vector<Record>& batch);
+    void format(const Record& rec, std::string& out) const;
+    void summarize();
+
+    std::once_flag started_;
+    std::mutex mutex_;              // rings_, sites_ and the sink
+    std::mutex flush_mutex_;        // one formatter at a time
+    std::vector<Ring*> rings_;
+    FastLogSite* sites_;
+    Sink sink_;
+    uint64_t retired_logged_;
+    uint64_t retired_dropped_;
+    std::atomic<uint64_t> written_;
+
+    friend class FastLogSite;
+};
+
+extern FastLog fastLog;
+
+#endif
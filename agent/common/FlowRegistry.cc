@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FlowRegistry.h"
+
+FlowRegistry::FlowRegistry(uint32_t max_flow_id) :
+    max_flow_id_(max_flow_id), entries_(((size_t)max_flow_id + 1) * 2), count_(0) {
+    size_t words = (entries_ + 63) / 64;
+    words_ = new std::atomic<uint64_t>[words];
+    for (size_t i = 0; i < words; i++) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+FlowRegistry::~FlowRegistry() {
+    delete[] words_;
+}
+
+void FlowRegistry::add(uint32_t flow_id, bool downstream) {
+    size_t i;
+    if (!entry(flow_id, downstream, &i)) {
+        return;
+    }
+    uint64_t bit = 1ULL << (i % 64);
+    if (!(words_[i / 64].fetch_or(bit, std::memory_order_relaxed) & bit)) {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FlowRegistry::remove(uint32_t flow_id, bool downstream) {
+    size_t i;
+    if (!entry(flow_id, downstream, &i)) {
+        return;
+    }
+    uint64_t bit = 1ULL << (i % 64);
+    if (words_[i / 64].fetch_and(~bit, std::memory_order_relaxed) & bit) {
+        count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool FlowRegistry::contains(uint32_t flow_id, bool downstream) const {
+    size_t i;
+    return entry(flow_id, downstream, &i) &&
+        (words_[i / 64].load(std::memory_order_relaxed) >> (i % 64) & 1);
+}
+
+size_t FlowRegistry::scan(uint32_t* cursor, size_t max_entries, size_t max_flows,
+                          std::vector<FlowKey>* flows) const {
+    size_t found = 0;
+    size_t i = *cursor < entries_ ? *cursor : 0;
+
+    for (size_t n = 0; n < max_entries && n < entries_ && found < max_flows; ) {
+        // Skips the rest of an empty word at once
+        uint64_t word = words_[i / 64].load(std::memory_order_relaxed) >> (i % 64);
+        if (word == 0) {
+            size_t skip = 64 - i % 64;
+            n += skip;
+            i += skip;
+        } else {
+            if (word & 1) {
+                FlowKey flow = { (uint32_t)(i / 2), (i % 2) != 0 };
+                flows->push_back(flow);
+                found++;
+            }
+            n++;
+            i++;
+        }
+        if (i >= entries_) {
+            i = 0;
+        }
+    }
+    *cursor = (uint32_t)i;
+    return found;
+}
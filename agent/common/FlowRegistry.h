@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_FLOW_REGISTRY_H_
+#define OPENOLT_FLOW_REGISTRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct FlowKey {
+    uint32_t flow_id;
+    bool downstream;
+};
+
+// The flows BAL holds, every flow id from 0 to max_flow_id in both
+// directions, whatever else the flow carries. A bit per flow, set and
+// cleared with atomic operations, so neither the flow paths nor the flow
+// statistics sweep ever wait on each other.
+class FlowRegistry {
+  public:
+    explicit FlowRegistry(uint32_t max_flow_id);
+    ~FlowRegistry();
+
+    FlowRegistry(const FlowRegistry&) = delete;
+    FlowRegistry& operator=(const FlowRegistry&) = delete;
+
+    // Flow ids out of range are ignored
+    void add(uint32_t flow_id, bool downstream);
+    void remove(uint32_t flow_id, bool downstream);
+    bool contains(uint32_t flow_id, bool downstream) const;
+
+    // Appends up to max_flows flows found in at most max_entries entries,
+    // two per flow id, starting at entry *cursor. Advances *cursor past the
+    // last entry looked at, wrapping around at the end, so repeated calls
+    // sweep all flows at a bounded cost per call.
+    size_t scan(uint32_t* cursor, size_t max_entries, size_t max_flows,
+                std::vector<FlowKey>* flows) const;
+
+    size_t size() const { return count_.load(std::memory_order_relaxed); }
+
+  private:
+    bool entry(uint32_t flow_id, bool downstream, size_t* index) const {
+        *index = (size_t)flow_id * 2 + downstream;
+        return flow_id <= max_flow_id_;
+    }
+
+    uint32_t max_flow_id_;
+    size_t entries_;
+    std::atomic<uint64_t>* words_;
+    std::atomic<size_t> count_;
+};
+
+#endif
@@ -0,0 +1,297 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "FlowState.h"
+
+static const uint32_t EMPTY_KEY = 0xffffffff;
+static const uint32_t TOMBSTONE_KEY = 0xfffffffe;
+
+static inline uint64_t pack(uint32_t key, uint32_t value) {
+    return ((uint64_t)key << 32) | value;
+}
+
+FlowTable::FlowTable(size_t slots, bool multi) :
+    multi_(multi), live_(0), used_(0) {
+    size_t n = 16;
+    shift_ = 28;
+    while (n < slots) {
+        n <<= 1;
+        shift_--;
+    }
+    mask_ = n - 1;
+    slots_ = new std::atomic<uint64_t>[n];
+    for (size_t i = 0; i < n; i++) {
+        slots_[i].store(pack(EMPTY_KEY, 0), std::memory_order_relaxed);
+    }
+}
+
+FlowTable::~FlowTable() {
+    delete[] slots_;
+}
+
+bool FlowTable::find(uint32_t key, uint32_t* value) const {
+    size_t i = home(key);
+    for (size_t n = 0; n <= mask_; n++, i = (i + 1) & mask_) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        uint32_t k = slot >> 32;
+        if (k == EMPTY_KEY) {
+            return false;
+        }
+        if (k == key) {
+            *value = (uint32_t)slot;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FlowTable::insert(uint32_t key, uint32_t value) {
+    size_t limit = (mask_ + 1) / 4 * 3;
+    size_t tombstone = mask_ + 1;
+    size_t i = home(key);
+    for (size_t n = 0; n <= mask_; n++, i = (i + 1) & mask_) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        uint32_t k = slot >> 32;
+        if (k == EMPTY_KEY) {
+            break;
+        }
+        if (k == TOMBSTONE_KEY) {
+            if (tombstone > mask_) {
+                tombstone = i;
+            }
+        } else if (k == key && (!multi_ || (uint32_t)slot == value)) {
+            slots_[i].store(pack(key, value), std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    if (live_ >= limit) {
+        return false;
+    }
+    if (tombstone <= mask_) {
+        i = tombstone;
+    } else if (used_ >= limit) {
+        // Out of empty slots, only tombstones are left to reclaim
+        rebuild();
+        return insert(key, value);
+    } else {
+        used_++;
+    }
+    slots_[i].store(pack(key, value), std::memory_order_relaxed);
+    live_++;
+    return true;
+}
+
+void FlowTable::erase(uint32_t key, uint32_t value) {
+    size_t i = home(key);
+    for (size_t n = 0; n <= mask_; n++, i = (i + 1) & mask_) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        uint32_t k = slot >> 32;
+        if (k == EMPTY_KEY) {
+            return;
+        }
+        if (k == key && (!multi_ || (uint32_t)slot == value)) {
+            // The end of a probe run needs no tombstone
+            uint64_t next = slots_[(i + 1) & mask_].load(std::memory_order_relaxed);
+            if ((uint32_t)(next >> 32) == EMPTY_KEY) {
+                slots_[i].store(pack(EMPTY_KEY, 0), std::memory_order_relaxed);
+                used_--;
+            } else {
+                slots_[i].store(pack(TOMBSTONE_KEY, 0), std::memory_order_relaxed);
+            }
+            live_--;
+            return;
+        }
+    }
+}
+
+void FlowTable::rebuild() {
+    std::vector<uint64_t> entries;
+    entries.reserve(live_);
+    for (size_t i = 0; i <= mask_; i++) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        uint32_t k = slot >> 32;
+        if (k != EMPTY_KEY && k != TOMBSTONE_KEY) {
+            entries.push_back(slot);
+        }
+        slots_[i].store(pack(EMPTY_KEY, 0), std::memory_order_relaxed);
+    }
+    live_ = 0;
+    used_ = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        insert(entries[i] >> 32, (uint32_t)entries[i]);
+    }
+}
+
+FlowState::FlowState(uint32_t max_flow_id, size_t slots) :
+    seq_(0),
+    max_flow_id_(max_flow_id),
+    port_flows_(slots, true),
+    port_alloc_(slots, false) {
+    size_t n = ((size_t)max_flow_id + 1) * 2;
+    void* mem = NULL;
+    if (posix_memalign(&mem, alignof(FlowSlot), n * sizeof(FlowSlot)) != 0) {
+        throw std::bad_alloc();
+    }
+    flows_ = (FlowSlot*)mem;
+    for (size_t i = 0; i < n; i++) {
+        new (&flows_[i]) FlowSlot();
+        flows_[i].version.store(0, std::memory_order_relaxed);
+        flows_[i].valid.store(0, std::memory_order_relaxed);
+    }
+}
+
+FlowState::~FlowState() {
+    free(flows_);
+}
+
+// Only ever called by the writer holding writer_
+void FlowState::publish(FlowSlot* slot, bool valid, uint32_t port_no,
+                        uint32_t gemport_id, uint64_t cookie) {
+    uint32_t version = slot->version.load(std::memory_order_relaxed);
+    slot->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->port_no.store(port_no, std::memory_order_relaxed);
+    slot->gemport_id.store(gemport_id, std::memory_order_relaxed);
+    slot->cookie.store(cookie, std::memory_order_relaxed);
+    slot->valid.store(valid, std::memory_order_relaxed);
+    slot->version.store(version + 2, std::memory_order_release);
+}
+
+// An update holds the writer lock and keeps the sequence odd while it runs
+FlowState::Update::Update(FlowState& state) :
+    state_(state), lock_(state.writer_) {
+    state_.seq_.store(state_.seq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+FlowState::Update::~Update() {
+    state_.seq_.store(state_.seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool FlowState::Update::add_flow(uint32_t flow_id, bool downstream, uint32_t port_no,
+                                 uint32_t gemport_id, uint64_t cookie) {
+    FlowSlot* slot = state_.flow_slot(flow_id, downstream);
+    if (slot == NULL) {
+        return false;
+    }
+
+    if (downstream) {
+        uint32_t old_port = slot->port_no.load(std::memory_order_relaxed);
+        if (slot->valid.load(std::memory_order_relaxed) && old_port != port_no) {
+            state_.port_flows_.erase(old_port, flow_id);
+        }
+        if (!state_.port_flows_.insert(port_no, flow_id)) {
+            return false;
+        }
+    }
+    publish(slot, true, port_no, gemport_id, cookie);
+    return true;
+}
+
+void FlowState::Update::remove_flow(uint32_t flow_id, bool downstream) {
+    FlowSlot* slot = state_.flow_slot(flow_id, downstream);
+    if (slot == NULL || !slot->valid.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    if (downstream) {
+        state_.port_flows_.erase(slot->port_no.load(std::memory_order_relaxed), flow_id);
+    }
+    publish(slot, false, 0, 0, 0);
+}
+
+bool FlowState::Update::set_alloc(uint32_t port_no, uint32_t alloc_id) {
+    return state_.port_alloc_.insert(port_no, alloc_id);
+}
+
+void FlowState::Update::remove_alloc(uint32_t port_no) {
+    state_.port_alloc_.erase(port_no);
+}
+
+unsigned FlowState::read_begin() const {
+    unsigned seq;
+    while ((seq = seq_.load(std::memory_order_acquire)) & 1) {
+        std::this_thread::yield();
+    }
+    return seq;
+}
+
+bool FlowState::read_retry(unsigned seq) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq_.load(std::memory_order_relaxed) != seq;
+}
+
+bool FlowState::find_flow(uint32_t flow_id, bool downstream, FlowEntry* flow) const {
+    const FlowSlot* slot = flow_slot(flow_id, downstream);
+    if (slot == NULL) {
+        return false;
+    }
+
+    uint32_t version;
+    bool valid;
+    do {
+        while ((version = slot->version.load(std::memory_order_acquire)) & 1) {
+            std::this_thread::yield();
+        }
+        valid = slot->valid.load(std::memory_order_relaxed);
+        flow->port_no = slot->port_no.load(std::memory_order_relaxed);
+        flow->gemport_id = slot->gemport_id.load(std::memory_order_relaxed);
+        flow->cookie = slot->cookie.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (slot->version.load(std::memory_order_relaxed) != version);
+
+    flow->flow_id = flow_id;
+    flow->downstream = downstream;
+    return valid;
+}
+
+uint32_t FlowState::port_of_flow(uint32_t flow_id) const {
+    FlowEntry flow;
+    return find_flow(flow_id, false, &flow) ? flow.port_no : 0;
+}
+
+bool FlowState::gemport_of_port(uint32_t port_no, uint32_t* gemport_id) const {
+    FlowEntry flow;
+    uint32_t flow_id;
+    bool found;
+    unsigned seq;
+    do {
+        seq = read_begin();
+        found = port_flows_.find(port_no, &flow_id) && find_flow(flow_id, true, &flow);
+    } while (read_retry(seq));
+    if (found) {
+        *gemport_id = flow.gemport_id;
+    }
+    return found;
+}
+
+uint32_t FlowState::alloc_of_port(uint32_t port_no) const {
+    uint32_t alloc_id;
+    bool found;
+    unsigned seq;
+    do {
+        seq = read_begin();
+        found = port_alloc_.find(port_no, &alloc_id);
+    } while (read_retry(seq));
+    return found ? alloc_id : 0;
+}
@@ -0,0 +1,150 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_FLOW_STATE_H_
+#define OPENOLT_FLOW_STATE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Open addressing table of uint32_t keys to uint32_t values with linear
+// probing. Each slot packs its key and value into one 64 bit word, so a
+// reader never sees half of an entry. In multi mode a key may hold several
+// values, one slot per (key, value) pair. Writers must be serialized;
+// readers may run alongside a writer but must validate what they read (see
+// FlowState). Keys 0xfffffffe and 0xffffffff are reserved.
+class FlowTable {
+  public:
+    FlowTable(size_t slots, bool multi);
+    ~FlowTable();
+
+    FlowTable(const FlowTable&) = delete;
+    FlowTable& operator=(const FlowTable&) = delete;
+
+    // Finds the value of key, or any one of its values in multi mode
+    bool find(uint32_t key, uint32_t* value) const;
+
+    // Sets the value of key, or adds (key, value) in multi mode. Returns
+    // false if the table is full.
+    bool insert(uint32_t key, uint32_t value);
+
+    // Removes key, or only (key, value) in multi mode
+    void erase(uint32_t key, uint32_t value = 0);
+
+    size_t size() const { return live_; }
+
+  private:
+    size_t home(uint32_t key) const { return (uint32_t)(key * 2654435761u) >> shift_; }
+    void rebuild();
+
+    std::atomic<uint64_t>* slots_;
+    size_t mask_;
+    unsigned shift_;
+    bool multi_;
+    size_t live_;
+    size_t used_;   // live entries plus tombstones
+};
+
+// A flow as the packet paths see it
+struct FlowEntry {
+    uint32_t flow_id;
+    uint32_t port_no;
+    uint32_t gemport_id;
+    uint64_t cookie;
+    bool downstream;
+};
+
+// Flow id, logical port and alloc id mappings of the flows and schedulers
+// programmed through this agent. Flows live in an array indexed by flow id
+// and direction, each entry published under its own version so a lookup
+// is a single indexed read. The port tables are open addressing tables of
+// the given number of slots, each holding up to three quarters of that,
+// read under a sequence lock over the whole state. No lookup takes a lock;
+// they retry if an update ran alongside them. Updates go through an
+// Update, which serializes writers and publishes the port table changes
+// together when it ends.
+class FlowState {
+  public:
+    FlowState(uint32_t max_flow_id, size_t slots);
+    ~FlowState();
+
+    FlowState(const FlowState&) = delete;
+    FlowState& operator=(const FlowState&) = delete;
+
+    class Update {
+      public:
+        explicit Update(FlowState& state);
+        ~Update();
+
+        Update(const Update&) = delete;
+        Update& operator=(const Update&) = delete;
+
+        // Return false if the flow id is out of range or a table is full
+        bool add_flow(uint32_t flow_id, bool downstream, uint32_t port_no,
+                      uint32_t gemport_id, uint64_t cookie);
+        void remove_flow(uint32_t flow_id, bool downstream);
+        bool set_alloc(uint32_t port_no, uint32_t alloc_id);
+        void remove_alloc(uint32_t port_no);
+
+      private:
+        FlowState& state_;
+        std::lock_guard<std::mutex> lock_;
+    };
+
+    bool find_flow(uint32_t flow_id, bool downstream, FlowEntry* flow) const;
+
+    // Logical port of an upstream flow, 0 if unknown
+    uint32_t port_of_flow(uint32_t flow_id) const;
+
+    // Gemport of any downstream flow of port_no
+    bool gemport_of_port(uint32_t port_no, uint32_t* gemport_id) const;
+
+    // Alloc id of the downstream scheduler of port_no, 0 if unknown
+    uint32_t alloc_of_port(uint32_t port_no) const;
+
+  private:
+    // One entry per cache line half. version is odd while the entry is
+    // being written and 0 while it was never set.
+    struct alignas(32) FlowSlot {
+        std::atomic<uint32_t> version;
+        std::atomic<uint32_t> port_no;
+        std::atomic<uint32_t> gemport_id;
+        std::atomic<uint32_t> valid;
+        std::atomic<uint64_t> cookie;
+    };
+
+    FlowSlot* flow_slot(uint32_t flow_id, bool downstream) const {
+        return flow_id <= max_flow_id_ ? &flows_[flow_id * 2 + downstream] : NULL;
+    }
+    static void publish(FlowSlot* slot, bool valid, uint32_t port_no,
+                        uint32_t gemport_id, uint64_t cookie);
+
+    unsigned read_begin() const;
+    bool read_retry(unsigned seq) const;
+
+    std::mutex writer_;
+    std::atomic<unsigned> seq_;
+
+    uint32_t max_flow_id_;
+    FlowSlot* flows_;
+    FlowTable port_flows_;  // port_no -> downstream flow_ids
+    FlowTable port_alloc_;  // port_no -> alloc_id
+};
+
+#endif
@@ -0,0 +1,194 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "IndicationBus.h"
+
+IndicationBus::IndicationBus(IndicationQueue& queue, IndicationJournal& journal) :
+    queue_(queue), journal_(journal), stopping_(false), waiting_(false),
+    subscriptions_(0), skipped_(0), published_(0) {
+}
+
+IndicationBus::~IndicationBus() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void IndicationBus::start() {
+    std::call_once(started_, [this]() { thread_ = std::thread(&IndicationBus::publish, this); });
+}
+
+void IndicationBus::subscribe(const IndicationSubscriber* subscriber) {
+    start();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.push_back(subscriber);
+        subscriptions_++;
+    }
+    cv_.notify_one();
+}
+
+void IndicationBus::unsubscribe(const IndicationSubscriber* subscriber) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(std::find(subscribers_.begin(), subscribers_.end(), subscriber));
+        skipped_ += subscriber->skipped_;
+    }
+    // The fastest subscriber may be gone
+    cv_.notify_one();
+}
+
+// A subscriber moved its cursor, the publisher may be waiting for that
+void IndicationBus::advanced() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!waiting_) {
+            return;
+        }
+    }
+    cv_.notify_one();
+}
+
+// Whether even the fastest subscriber is IND_BUS_LEAD records behind.
+// Called with mutex_ held, while there are subscribers.
+bool IndicationBus::behind() const {
+    uint64_t fastest = 0;
+
+    for (size_t i = 0; i < subscribers_.size(); i++) {
+        fastest = std::max(fastest, subscribers_[i]->read_seq_.load(std::memory_order_acquire));
+    }
+    return journal_.next_seq() >= fastest + IND_BUS_LEAD;
+}
+
+// Journals the bytes the producer serialized in push(). An indication that
+// was not serialized is encoded here.
+void IndicationBus::publish() {
+    std::vector<QueuedIndication> batch;
+    std::string scratch;
+
+    batch.reserve(IND_BUS_BATCH);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiting_ = true;
+            cv_.wait(lock, [this]() { return stopping_ || subscribers_.empty() || !behind(); });
+            waiting_ = false;
+            if (stopping_) {
+                return;
+            }
+        }
+
+        batch.clear();
+        size_t n = queue_.pop_batch(batch, IND_BUS_BATCH, 1);
+        for (size_t i = 0; i < n; i++) {
+            const QueuedIndication& ind = batch[i];
+            uint32_t kind = ind.ind->data_case();
+            uint32_t flags = 0;
+
+            if (kind == openolt::Indication::kPortStats && ind.ind->port_stats().delta()) {
+                flags = JOURNAL_STATS_DELTA;
+            }
+
+            if (ind.wire == NULL) {
+                ind.ind->SerializeToString(&scratch);
+                journal_.append((const uint8_t*)scratch.data(), scratch.size(), kind, flags);
+            } else {
+                journal_.append(ind.wire, ind.wire_len, kind, flags);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        published_ += n;
+    }
+}
+
+void IndicationBus::get_counters(ind_bus_counters* counters) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    counters->published = published_;
+    counters->subscribers = subscribers_.size();
+    counters->subscriptions = subscriptions_;
+    counters->skipped = skipped_;
+}
+
+std::string IndicationBus::counters_to_str() const {
+    ind_bus_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "published " << c.published << " subscribers " << c.subscribers
+        << " subscriptions " << c.subscriptions << " skipped " << c.skipped;
+    return out.str();
+}
+
+IndicationSubscriber::IndicationSubscriber(IndicationBus& bus, uint64_t after, uint64_t kinds,
+                                           bool deltas) :
+    bus_(bus), cursor_(bus.journal().seek(after)), read_seq_(cursor_.seq), kinds_(kinds),
+    exclude_(deltas ? 0 : JOURNAL_STATS_DELTA), delivered_(0), skipped_(0) {
+    bus_.subscribe(this);
+}
+
+IndicationSubscriber::~IndicationSubscriber() {
+    bus_.unsubscribe(this);
+}
+
+size_t IndicationSubscriber::next(std::vector<JournalRecord>& out, size_t max, int timeout) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+
+    for (;;) {
+        uint64_t skipped = 0;
+        size_t n = bus_.journal().read(&cursor_, kinds_, exclude_, &out, max, &skipped);
+        read_seq_.store(cursor_.seq, std::memory_order_release);
+        bus_.advanced();
+        if (skipped > 0) {
+            std::cout << "Indication subscriber fell behind, lost " << skipped
+                      << " indications" << std::endl;
+            skipped_ += skipped;
+        }
+        // Filtered out records move the cursor too, wait for the next ones
+        if (n > 0 || !bus_.journal().wait(cursor_, deadline)) {
+            return n;
+        }
+    }
+}
+
+void IndicationSubscriber::delivered(uint64_t seq) {
+    // A filtered stream passed over indications the others may never have
+    // had, so only an unfiltered one moves the journal's delivered mark
+    if (kinds_ == 0) {
+        bus_.journal().delivered(seq);
+    }
+    delivered_++;
+}
+
+std::string IndicationSubscriber::counters_to_str() const {
+    std::ostringstream out;
+    out << "delivered " << delivered_ << " skipped " << skipped_ << " at " << cursor_.seq;
+    return out.str();
+}
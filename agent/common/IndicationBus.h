@@ -0,0 +1,138 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_INDICATION_BUS_H_
+#define OPENOLT_INDICATION_BUS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IndicationJournal.h"
+#include "IndicationQueue.h"
+
+// Indications the publisher moves from the queue to the journal at a time,
+// and how far it may get ahead of the fastest subscriber
+#define IND_BUS_BATCH 64
+#define IND_BUS_LEAD  1024
+
+struct ind_bus_counters {
+    uint64_t published;
+    uint64_t subscribers;   // subscribed now
+    uint64_t subscriptions; // ever made
+    uint64_t skipped;       // records subscribers lost to overwrites
+};
+
+class IndicationSubscriber;
+
+// Fans the indication queue out to any number of subscribers, each an
+// EnableIndication stream. Once started, a publisher thread moves
+// indications off the queue, in its priority order, into the journal;
+// every subscriber then reads the journal through a cursor of its own.
+//
+// With no subscriber everything is journaled as it comes, so what happens
+// while Voltha is away is kept for it to replay, up to what the journal
+// holds. Otherwise the publisher keeps pace with the fastest subscriber,
+// at most IND_BUS_LEAD indications ahead of it, so a burst backs up on the
+// queue and its per-class limits decide what is dropped, as with a single
+// stream. Slower subscribers fall behind in the journal and lose what the
+// ring overwrites; neither the publisher nor the others wait for them. The
+// queue must serialize.
+class IndicationBus {
+  public:
+    IndicationBus(IndicationQueue& queue, IndicationJournal& journal);
+    ~IndicationBus();
+
+    IndicationBus(const IndicationBus&) = delete;
+    IndicationBus& operator=(const IndicationBus&) = delete;
+
+    // Starts the publisher, before the first indication is pushed
+    void start();
+
+    IndicationJournal& journal() { return journal_; }
+
+    void get_counters(ind_bus_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    friend class IndicationSubscriber;
+
+    void subscribe(const IndicationSubscriber* subscriber);
+    void unsubscribe(const IndicationSubscriber* subscriber);
+    void advanced();
+    bool behind() const;
+    void publish();
+
+    IndicationQueue& queue_;
+    IndicationJournal& journal_;
+    std::once_flag started_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+    bool waiting_;
+    std::vector<const IndicationSubscriber*> subscribers_;
+    uint64_t subscriptions_;
+    uint64_t skipped_;
+    uint64_t published_;
+};
+
+// One reader of the bus, for as long as it exists. Not thread safe, each
+// stream has its own.
+class IndicationSubscriber {
+  public:
+    // Starts after sequence number after, see IndicationJournal::seek(),
+    // keeping the kinds of indication in the mask kinds, a bit per
+    // Indication::DataCase, or all of them if kinds is 0. Unless deltas,
+    // PortStatistics deltas are passed over.
+    IndicationSubscriber(IndicationBus& bus, uint64_t after, uint64_t kinds, bool deltas);
+    ~IndicationSubscriber();
+
+    IndicationSubscriber(const IndicationSubscriber&) = delete;
+    IndicationSubscriber& operator=(const IndicationSubscriber&) = delete;
+
+    // Waits up to timeout seconds for indications, then copies up to max of
+    // them into out. Returns the number copied; out may hold more entries,
+    // kept for reuse.
+    size_t next(std::vector<JournalRecord>& out, size_t max, int timeout);
+
+    // Notes that the indication seq was written to the stream. Only an
+    // unfiltered subscriber marks it delivered in the journal.
+    void delivered(uint64_t seq);
+
+    uint64_t skipped() const { return skipped_; }
+    std::string counters_to_str() const;
+
+  private:
+    friend class IndicationBus;
+
+    IndicationBus& bus_;
+    IndicationJournal::Cursor cursor_;
+    std::atomic<uint64_t> read_seq_;    // cursor_.seq, for the publisher
+    uint64_t kinds_;
+    uint32_t exclude_;
+    uint64_t delivered_;
+    uint64_t skipped_;
+};
+
+extern IndicationBus indBus;
+
+#endif
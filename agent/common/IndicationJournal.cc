@@ -0,0 +1,306 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "IndicationJournal.h"
+
+#define JOURNAL_MAGIC       0x314c4e524a544c4fULL   // "OLTJRNL1"
+#define JOURNAL_VERSION     3
+#define JOURNAL_HEADER_SIZE 4096
+#define JOURNAL_MIN_SIZE    (64 * 1024)
+#define JOURNAL_WRAP        0xffffffffu
+
+// First page of the mapping; the records follow it
+struct IndicationJournal::Header {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t capacity;      // bytes of records
+    uint64_t first_seq;     // oldest record, next_seq if there is none
+    uint64_t next_seq;
+    uint64_t head;          // offset of the oldest record
+    uint64_t tail;          // offset of the next record
+};
+
+// Precedes the encoded indication, which is padded to 8 bytes. A record
+// with len JOURNAL_WRAP, or less room than a Record left before the end of
+// the ring, means the next record is at offset 0.
+struct IndicationJournal::Record {
+    uint64_t seq;
+    uint32_t len;
+    uint16_t kind;
+    uint16_t flags;
+};
+
+static inline size_t record_size(size_t len) {
+    return 16 + ((len + 7) & ~(size_t)7);
+}
+
+IndicationJournal::IndicationJournal(const std::string& path, size_t size) :
+    header_(NULL), records_(NULL), mapped_(0), durable_(false),
+    delivered_(0), appended_(0), evicted_(0) {
+    size = size < JOURNAL_MIN_SIZE ? JOURNAL_MIN_SIZE : (size + 7) & ~(size_t)7;
+
+    durable_ = !path.empty() && map(path, size);
+    if (!durable_) {
+        if (!path.empty()) {
+            std::cout << "Indication journal: cannot map " << path
+                      << ", keeping the journal in memory" << std::endl;
+        }
+        void* p = mmap(NULL, JOURNAL_HEADER_SIZE + size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            std::cout << "Indication journal: out of memory, not journaling" << std::endl;
+            return;
+        }
+        header_ = (Header*)p;
+        records_ = (uint8_t*)p + JOURNAL_HEADER_SIZE;
+        mapped_ = JOURNAL_HEADER_SIZE + size;
+    }
+
+    Header* h = header_;
+    if (h->magic != JOURNAL_MAGIC || h->version != JOURNAL_VERSION || h->capacity != size ||
+        h->head > size || h->tail > size || h->next_seq == 0 || h->first_seq > h->next_seq) {
+        memset(h, 0, sizeof(*h));
+        h->magic = JOURNAL_MAGIC;
+        h->version = JOURNAL_VERSION;
+        h->capacity = size;
+        h->first_seq = 1;
+        h->next_seq = 1;
+    } else {
+        std::cout << "Indication journal: resuming at sequence " << h->next_seq
+                  << ", " << h->next_seq - h->first_seq << " records held" << std::endl;
+    }
+    // What an earlier run did not deliver is only replayed on request
+    delivered_ = h->next_seq - 1;
+}
+
+IndicationJournal::~IndicationJournal() {
+    if (header_ != NULL) {
+        munmap(header_, mapped_);
+    }
+}
+
+bool IndicationJournal::map(const std::string& path, size_t size) {
+    size_t total = JOURNAL_HEADER_SIZE + size;
+    struct stat st;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || ((size_t)st.st_size != total && ftruncate(fd, total) != 0)) {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    header_ = (Header*)p;
+    records_ = (uint8_t*)p + JOURNAL_HEADER_SIZE;
+    mapped_ = total;
+    return true;
+}
+
+IndicationJournal::Record* IndicationJournal::record_at(uint64_t* pos) const {
+    if (header_->capacity - *pos < sizeof(Record)) {
+        *pos = 0;
+    }
+    Record* rec = (Record*)(records_ + *pos);
+    if (rec->len == JOURNAL_WRAP) {
+        *pos = 0;
+        rec = (Record*)records_;
+    }
+    return rec;
+}
+
+void IndicationJournal::evict() {
+    uint64_t pos = header_->head;
+    Record* rec = record_at(&pos);
+
+    header_->head = pos + record_size(rec->len);
+    header_->first_seq++;
+    evicted_++;
+    if (header_->first_seq == header_->next_seq) {
+        header_->head = header_->tail = 0;
+    }
+}
+
+uint64_t IndicationJournal::append(const uint8_t* data, size_t len, uint32_t kind,
+                                   uint32_t flags) {
+    size_t need = record_size(len);
+
+    if (header_ == NULL || need + sizeof(Record) > header_->capacity) {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Header* h = header_;
+    // Free space runs from tail to head, around the end of the ring
+    for (;;) {
+        if (h->first_seq == h->next_seq) {
+            h->head = h->tail = 0;
+            break;
+        }
+        if (h->head == h->tail) {
+            evict();
+        } else if (h->head > h->tail) {
+            if (h->tail + need <= h->head) {
+                break;
+            }
+            evict();
+        } else if (h->tail + need <= h->capacity) {
+            break;
+        } else if (need <= h->head) {
+            if (h->capacity - h->tail >= sizeof(Record)) {
+                ((Record*)(records_ + h->tail))->len = JOURNAL_WRAP;
+            }
+            h->tail = 0;
+            break;
+        } else {
+            evict();
+        }
+    }
+
+    Record* rec = (Record*)(records_ + h->tail);
+    rec->seq = h->next_seq;
+    rec->len = len;
+    rec->kind = kind;
+    rec->flags = flags;
+    memcpy(rec + 1, data, len);
+    h->tail += need;
+    appended_++;
+    uint64_t seq = h->next_seq++;
+
+    lock.unlock();
+    appended_cv_.notify_all();
+    return seq;
+}
+
+void IndicationJournal::delivered(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (seq > delivered_) {
+        delivered_ = seq;
+    }
+}
+
+IndicationJournal::Cursor IndicationJournal::seek(uint64_t after) {
+    Cursor cursor = { 0, 0 };
+
+    if (header_ == NULL) {
+        return cursor;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Header* h = header_;
+    uint64_t from = (after ? after : delivered_) + 1;
+
+    if (from > h->next_seq) {
+        std::cout << "Indication journal: nothing after " << after
+                  << ", the journal ends at " << h->next_seq - 1 << std::endl;
+        from = h->next_seq;
+    }
+    if (from < h->first_seq) {
+        std::cout << "Indication journal: indications " << from << " to " << h->first_seq - 1
+                  << " are no longer held, starting from " << h->first_seq << std::endl;
+        from = h->first_seq;
+    }
+    cursor.pos = h->head;
+    for (cursor.seq = h->first_seq; cursor.seq < from; cursor.seq++) {
+        Record* rec = record_at(&cursor.pos);
+        cursor.pos += record_size(rec->len);
+    }
+    return cursor;
+}
+
+size_t IndicationJournal::read(Cursor* cursor, uint64_t kinds, uint32_t exclude,
+                               std::vector<JournalRecord>* out, size_t max, uint64_t* skipped) {
+    size_t n = 0;
+
+    if (header_ == NULL) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Header* h = header_;
+    // The oldest record is always at head, wherever the ring was reset
+    if (cursor->seq <= h->first_seq) {
+        *skipped += h->first_seq - cursor->seq;
+        cursor->seq = h->first_seq;
+        cursor->pos = h->head;
+    }
+    while (n < max && cursor->seq < h->next_seq) {
+        Record* rec = record_at(&cursor->pos);
+        if ((kinds == 0 || (rec->kind < 64 && (kinds & (1ULL << rec->kind)))) &&
+            (rec->flags & exclude) == 0) {
+            if (out->size() <= n) {
+                out->resize(n + 1);
+            }
+            JournalRecord& copy = (*out)[n++];
+            copy.seq = rec->seq;
+            copy.kind = rec->kind;
+            copy.data.assign((const char*)(rec + 1), rec->len);
+        }
+        cursor->pos += record_size(rec->len);
+        cursor->seq++;
+    }
+    return n;
+}
+
+bool IndicationJournal::wait(const Cursor& cursor, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (header_ == NULL) {
+        appended_cv_.wait_until(lock, deadline);
+        return false;
+    }
+    return appended_cv_.wait_until(lock, deadline, [&]() { return header_->next_seq > cursor.seq; });
+}
+
+uint64_t IndicationJournal::next_seq() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return header_ != NULL ? header_->next_seq : 0;
+}
+
+void IndicationJournal::get_counters(ind_journal_counters* counters) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    counters->appended = appended_;
+    counters->evicted = evicted_;
+    counters->first_seq = header_ != NULL ? header_->first_seq : 0;
+    counters->next_seq = header_ != NULL ? header_->next_seq : 0;
+}
+
+std::string IndicationJournal::counters_to_str() const {
+    ind_journal_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << (durable_ ? "file" : "memory")
+        << " seq " << c.first_seq << "-" << c.next_seq
+        << " appended " << c.appended << " evicted " << c.evicted;
+    return out.str();
+}
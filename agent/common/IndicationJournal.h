@@ -0,0 +1,123 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_INDICATION_JOURNAL_H_
+#define OPENOLT_INDICATION_JOURNAL_H_
+
+#include <cstddef>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Record flags. The record is PortStatistics delta-encoded against the
+// readings sent before it, which only streams that asked for stats_delta
+// can add up.
+#define JOURNAL_STATS_DELTA 0x1
+
+struct ind_journal_counters {
+    uint64_t appended;
+    uint64_t evicted;       // records overwritten to make room
+    uint64_t first_seq;     // oldest record held
+    uint64_t next_seq;
+};
+
+// A record copied out of the journal. data keeps its capacity when the
+// record is reused for another.
+struct JournalRecord {
+    uint64_t seq;
+    uint32_t kind;
+    std::string data;
+};
+
+// The indications sent to Voltha, encoded, in a fixed size ring of records
+// numbered by a sequence that only ever grows. New records overwrite the
+// oldest. The ring lives in a memory mapped file, so it and the sequence
+// survive a restart of the agent; when the file cannot be used it lives in
+// anonymous memory instead.
+//
+// Readers go through the records with a Cursor each, at their own pace, so
+// a reconnecting adapter can start after the last sequence number it
+// received. A reader that falls behind by more than the ring holds loses
+// the records overwritten meanwhile, and only those.
+class IndicationJournal {
+  public:
+    // Next record to read
+    struct Cursor {
+        uint64_t seq;
+        uint64_t pos;
+    };
+
+    IndicationJournal(const std::string& path, size_t size);
+    ~IndicationJournal();
+
+    IndicationJournal(const IndicationJournal&) = delete;
+    IndicationJournal& operator=(const IndicationJournal&) = delete;
+
+    // Returns the sequence number of the new record, 0 if len does not fit
+    // in the journal at all. kind, below 64, and the JOURNAL_* flags are for
+    // readers to filter on.
+    uint64_t append(const uint8_t* data, size_t len, uint32_t kind, uint32_t flags = 0);
+
+    // Notes that records up to seq reached a stream that takes every kind
+    void delivered(uint64_t seq);
+
+    // A cursor at the record after sequence number after or, if after is 0,
+    // at the first one not delivered since the agent started
+    Cursor seek(uint64_t after);
+
+    // Copies up to max records at the cursor into out, which grows as needed,
+    // and moves the cursor past them. Records whose kind is not in the mask
+    // kinds (bit 1 << kind) are passed over, 0 takes all, and so are records
+    // with any of the flags in exclude. Returns the number copied and adds
+    // the number of records lost to overwrites to *skipped.
+    size_t read(Cursor* cursor, uint64_t kinds, uint32_t exclude, std::vector<JournalRecord>* out,
+                size_t max, uint64_t* skipped);
+
+    // Waits until deadline for a record at or after the cursor
+    bool wait(const Cursor& cursor, std::chrono::steady_clock::time_point deadline);
+
+    // Sequence number the next record will get
+    uint64_t next_seq() const;
+
+    bool durable() const { return durable_; }
+
+    void get_counters(ind_journal_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    struct Header;
+    struct Record;
+
+    bool map(const std::string& path, size_t size);
+    Record* record_at(uint64_t* pos) const;
+    void evict();
+
+    mutable std::mutex mutex_;
+    std::condition_variable appended_cv_;
+    Header* header_;
+    uint8_t* records_;
+    size_t mapped_;
+    bool durable_;
+    uint64_t delivered_;
+    uint64_t appended_;
+    uint64_t evicted_;
+};
+
+#endif
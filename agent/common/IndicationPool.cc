@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include "IndicationPool.h"
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::OneofDescriptor;
+
+void IndicationRecycler::operator()(openolt::Indication* ind) const {
+    if (pool != NULL) {
+        pool->put(ind);
+    } else {
+        delete ind;
+    }
+}
+
+IndicationPool::IndicationPool(size_t depth) : allocated_(0), reused_(0), freed_(0) {
+    const OneofDescriptor* data = openolt::Indication::descriptor()->FindOneofByName("data");
+
+    for (int i = 0; data != NULL && i < data->field_count(); i++) {
+        const FieldDescriptor* field = data->field(i);
+        if ((size_t)field->number() >= lists_.size()) {
+            FreeList none = { NULL, NULL };
+            lists_.resize(field->number() + 1, none);
+        }
+        lists_[field->number()].field = field;
+        lists_[field->number()].free =
+            new RingQueue<openolt::Indication*>(depth, RING_OVERFLOW_DROP_NEWEST);
+    }
+}
+
+IndicationPool::~IndicationPool() {
+    for (size_t i = 0; i < lists_.size(); i++) {
+        openolt::Indication* ind;
+        while (lists_[i].free != NULL && lists_[i].free->try_pop(ind)) {
+            delete ind;
+        }
+        delete lists_[i].free;
+    }
+}
+
+IndicationPtr IndicationPool::get(openolt::Indication::DataCase data) {
+    FreeList* list = free_list(data);
+    openolt::Indication* ind;
+
+    if (list != NULL && list->free->try_pop(ind)) {
+        reused_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        ind = new openolt::Indication;
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return IndicationPtr(ind, IndicationRecycler(this));
+}
+
+// Clear() on the indication itself would delete the data member, so only
+// the data member is cleared, which keeps its string capacity.
+void IndicationPool::put(openolt::Indication* ind) {
+    if (ind == NULL) {
+        return;
+    }
+
+    FreeList* list = free_list(ind->data_case());
+    ind->clear_seq();
+    if (list != NULL) {
+        ind->GetReflection()->MutableMessage(ind, list->field)->Clear();
+        if (list->free->try_push(std::move(ind))) {
+            return;
+        }
+    }
+    freed_.fetch_add(1, std::memory_order_relaxed);
+    delete ind;
+}
+
+void IndicationPool::get_counters(ind_pool_counters* counters) const {
+    counters->allocated = allocated_.load(std::memory_order_relaxed);
+    counters->reused = reused_.load(std::memory_order_relaxed);
+    counters->freed = freed_.load(std::memory_order_relaxed);
+}
+
+std::string IndicationPool::counters_to_str() const {
+    ind_pool_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "allocated " << c.allocated << " reused " << c.reused << " freed " << c.freed;
+    return out.str();
+}
@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_INDICATION_POOL_H_
+#define OPENOLT_INDICATION_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <openolt.grpc.pb.h>
+#include "RingQueue.h"
+
+// Indications kept for reuse per kind of indication
+#define IND_POOL_DEPTH 1024
+
+struct ind_pool_counters {
+    uint64_t allocated;     // indications built from scratch
+    uint64_t reused;        // indications handed out again
+    uint64_t freed;         // indications deleted, their free list full
+};
+
+class IndicationPool;
+
+// Gives the indication back to its pool when the owner lets go of it
+struct IndicationRecycler {
+    IndicationPool* pool;
+
+    IndicationRecycler() : pool(NULL) {}
+    explicit IndicationRecycler(IndicationPool* p) : pool(p) {}
+    void operator()(openolt::Indication* ind) const;
+};
+
+// An indication on its way from a producer to the stream. Move-only: there
+// is exactly one owner at a time, from get() to the write.
+typedef std::unique_ptr<openolt::Indication, IndicationRecycler> IndicationPtr;
+
+// Recycled indications, kept with their data member still allocated. An
+// indication given back is cleared in place and filed by the kind of data
+// it holds, so the next get() of that kind returns one whose mutable_*()
+// accessor, and the string buffers under it, need no allocation. Only
+// nested messages below the data member (alarm details, serial numbers)
+// are rebuilt each time. get() and put() may be called from any thread.
+class IndicationPool {
+  public:
+    explicit IndicationPool(size_t depth = IND_POOL_DEPTH);
+    ~IndicationPool();
+
+    IndicationPool(const IndicationPool&) = delete;
+    IndicationPool& operator=(const IndicationPool&) = delete;
+
+    // An empty indication, set to carry data if one such is free
+    IndicationPtr get(openolt::Indication::DataCase data);
+    void put(openolt::Indication* ind);
+
+    void get_counters(ind_pool_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    struct FreeList {
+        const google::protobuf::FieldDescriptor* field;
+        RingQueue<openolt::Indication*>* free;
+    };
+
+    FreeList* free_list(int data) {
+        return data > 0 && (size_t)data < lists_.size() && lists_[data].free != NULL ?
+            &lists_[data] : NULL;
+    }
+
+    std::vector<FreeList> lists_;   // by data field number
+    std::atomic<uint64_t> allocated_;
+    std::atomic<uint64_t> reused_;
+    std::atomic<uint64_t> freed_;
+};
+
+#endif
@@ -0,0 +1,242 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "IndicationQueue.h"
+#include "Metrics.h"
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+IndicationQueue::IndicationQueue(bool serialize) :
+    wire_pool_(serialize ? new PktBufPool(IND_WIRE_BUFS, IND_WIRE_BUF_SIZE, 1) : NULL),
+    cur_(0), credit_(IND_CLASS_CONTROL_WEIGHT) {
+    static const size_t depth[IND_CLASS_MAX] = {
+        IND_CLASS_CONTROL_DEPTH, IND_CLASS_OMCI_DEPTH,
+        IND_CLASS_PKT_IN_DEPTH, IND_CLASS_STATS_DEPTH };
+    static const unsigned weight[IND_CLASS_MAX] = {
+        IND_CLASS_CONTROL_WEIGHT, IND_CLASS_OMCI_WEIGHT,
+        IND_CLASS_PKT_IN_WEIGHT, IND_CLASS_STATS_WEIGHT };
+    static const ring_overflow_policy policy[IND_CLASS_MAX] = {
+        RING_OVERFLOW_BLOCK, RING_OVERFLOW_BLOCK,
+        RING_OVERFLOW_DROP_OLDEST, RING_OVERFLOW_DROP_OLDEST };
+
+    for (int c = 0; c < IND_CLASS_MAX; c++) {
+        lanes_[c].ring = new RingQueue<QueuedIndication>(depth[c], policy[c]);
+        lanes_[c].weight = weight[c];
+        lanes_[c].pushed = 0;
+        lanes_[c].popped = 0;
+        lanes_[c].wait_ns_total = 0;
+        lanes_[c].wait_ns_max = 0;
+        lanes_[c].logged_drops = 0;
+        lanes_[c].logged_ns = 0;
+    }
+}
+
+IndicationQueue::~IndicationQueue() {
+    for (int c = 0; c < IND_CLASS_MAX; c++) {
+        delete lanes_[c].ring;
+    }
+    delete wire_pool_;
+}
+
+ind_class IndicationQueue::classify(const openolt::Indication& ind) {
+    switch (ind.data_case()) {
+    case openolt::Indication::kOmciInd:
+        return IND_CLASS_OMCI;
+    case openolt::Indication::kPktInd:
+        return IND_CLASS_PKT_IN;
+    case openolt::Indication::kPortStats:
+    case openolt::Indication::kFlowStats:
+        return IND_CLASS_STATS;
+    default:
+        return IND_CLASS_CONTROL;
+    }
+}
+
+const char* IndicationQueue::class_name(ind_class c) {
+    switch (c) {
+    case IND_CLASS_CONTROL: return "control";
+    case IND_CLASS_OMCI:    return "omci";
+    case IND_CLASS_PKT_IN:  return "pkt_in";
+    case IND_CLASS_STATS:   return "stats";
+    default:                return "unknown";
+    }
+}
+
+// The encoding Write() would produce, in a buffer of pool
+static void serialize(const openolt::Indication& ind, PktBufPool* pool, QueuedIndication* entry) {
+    size_t len = ind.ByteSizeLong();
+    uint8_t* buf = pool->get(len);
+
+    if (buf == NULL) {
+        return;     // left for the consumer to encode
+    }
+    ind.SerializeWithCachedSizesToArray(buf);
+    entry->wire = buf;
+    entry->wire_len = len;
+    entry->wire_pool = pool;
+}
+
+// Reports the evictions of lane c since the last report, at most once a
+// second
+void IndicationQueue::log_drops(ind_class c) {
+    Lane& lane = lanes_[c];
+    int64_t now = now_ns();
+    int64_t last = lane.logged_ns.load(std::memory_order_relaxed);
+
+    if (now - last < 1000000000LL ||
+        !lane.logged_ns.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        return;
+    }
+    uint64_t dropped = lane.ring->dropped();
+    uint64_t before = lane.logged_drops.exchange(dropped, std::memory_order_relaxed);
+    std::cout << "Indication queue: " << class_name(c) << " lane full, evicted "
+              << dropped - before << " indications" << std::endl;
+}
+
+// Evictions from the lanes that evict show up in the lane's dropped counter
+// and the log.
+bool IndicationQueue::enqueue(IndicationPtr ind) {
+    ind_class c = classify(*ind);
+    Lane& lane = lanes_[c];
+    QueuedIndication entry;
+
+    if (wire_pool_ != NULL) {
+        serialize(*ind, wire_pool_, &entry);
+    }
+    entry.ind = std::move(ind);
+    entry.enqueued_ns = now_ns();
+    lane.pushed.fetch_add(1, std::memory_order_relaxed);
+    bool pushed = lane.ring->push(std::move(entry));
+    if (lane.ring->dropped() != lane.logged_drops.load(std::memory_order_relaxed)) {
+        log_drops(c);
+    }
+    return pushed;
+}
+
+bool IndicationQueue::push(IndicationPtr ind) {
+    bool pushed = enqueue(std::move(ind));
+    notifier_.notify();
+    return pushed;
+}
+
+size_t IndicationQueue::push_batch(std::vector<IndicationPtr>& inds) {
+    size_t pushed = 0;
+
+    for (size_t i = 0; i < inds.size(); i++) {
+        pushed += enqueue(std::move(inds[i])) ? 1 : 0;
+    }
+    if (!inds.empty()) {
+        inds.clear();
+        notifier_.notify();
+    }
+    return pushed;
+}
+
+// The queue.indication.<class>.wait histograms, registered on the first pop
+// rather than in the constructor, which may run before metrics is built
+static int wait_histogram(int c) {
+    static const std::vector<int> ids = []() {
+        std::vector<int> ids;
+        for (int i = 0; i < IND_CLASS_MAX; i++) {
+            ids.push_back(metrics.histogram(std::string("queue.indication.") +
+                                            IndicationQueue::class_name((ind_class)i) + ".wait"));
+        }
+        return ids;
+    }();
+    return ids[c];
+}
+
+// Weighted round robin: take up to weight indications from the current lane,
+// then move on. An empty lane forfeits the rest of its turn.
+bool IndicationQueue::try_pop(QueuedIndication& ind) {
+    for (int i = 0; i <= IND_CLASS_MAX; i++) {
+        Lane& lane = lanes_[cur_];
+        if (credit_ > 0 && lane.ring->try_pop(ind)) {
+            credit_--;
+            uint64_t wait = (uint64_t)(now_ns() - ind.enqueued_ns);
+            lane.popped.fetch_add(1, std::memory_order_relaxed);
+            lane.wait_ns_total.fetch_add(wait, std::memory_order_relaxed);
+            if (wait > lane.wait_ns_max.load(std::memory_order_relaxed)) {
+                lane.wait_ns_max.store(wait, std::memory_order_relaxed);
+            }
+            metrics.record(wait_histogram(cur_), wait);
+            return true;
+        }
+        cur_ = (cur_ + 1) % IND_CLASS_MAX;
+        credit_ = lanes_[cur_].weight;
+    }
+    return false;
+}
+
+bool IndicationQueue::pop(QueuedIndication& ind, int timeout) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+
+    return notifier_.wait_until(deadline, [&]() { return try_pop(ind); });
+}
+
+size_t IndicationQueue::pop_batch(std::vector<QueuedIndication>& out, size_t max, int timeout) {
+    size_t n = 0;
+
+    out.push_back(QueuedIndication());
+    if (!pop(out.back(), timeout)) {
+        out.pop_back();
+        return 0;
+    }
+    for (n = 1; n < max; n++) {
+        out.push_back(QueuedIndication());
+        if (!try_pop(out.back())) {
+            out.pop_back();
+            break;
+        }
+    }
+    return n;
+}
+
+void IndicationQueue::get_counters(ind_class c, ind_class_counters* counters) const {
+    const Lane& lane = lanes_[c];
+
+    counters->pushed = lane.pushed.load(std::memory_order_relaxed);
+    counters->popped = lane.popped.load(std::memory_order_relaxed);
+    counters->dropped = lane.ring->dropped();
+    counters->depth = lane.ring->size();
+    counters->wait_ns_total = lane.wait_ns_total.load(std::memory_order_relaxed);
+    counters->wait_ns_max = lane.wait_ns_max.load(std::memory_order_relaxed);
+}
+
+std::string IndicationQueue::counters_to_str() const {
+    std::ostringstream out;
+
+    for (int c = 0; c < IND_CLASS_MAX; c++) {
+        ind_class_counters cnt;
+        get_counters((ind_class)c, &cnt);
+        uint64_t avg_us = cnt.popped ? cnt.wait_ns_total / cnt.popped / 1000 : 0;
+        out << (c ? ", " : "") << class_name((ind_class)c)
+            << " depth " << cnt.depth
+            << " pushed " << cnt.pushed
+            << " dropped " << cnt.dropped
+            << " wait avg/max us " << avg_us << "/" << cnt.wait_ns_max / 1000;
+    }
+    return out.str();
+}
@@ -0,0 +1,192 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_INDICATION_QUEUE_H_
+#define OPENOLT_INDICATION_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <openolt.grpc.pb.h>
+#include "IndicationPool.h"
+#include "PktBufPool.h"
+#include "RingQueue.h"
+
+// Priority classes of the indication pipeline, highest priority first.
+enum ind_class {
+    IND_CLASS_CONTROL,  // olt/intf/onu state changes, discovery, alarms
+    IND_CLASS_OMCI,
+    IND_CLASS_PKT_IN,
+    IND_CLASS_STATS,
+    IND_CLASS_MAX
+};
+
+// Per-lane depth and drain weight. The weight is the number of indications
+// taken from a lane per round of the drain while other lanes are busy. A
+// full control or OMCI lane blocks its producers until the consumer makes
+// room, so state changes and OMCI responses are never lost; a full
+// packet-in or stats lane evicts its oldest entry.
+#define IND_CLASS_CONTROL_DEPTH 4096
+#define IND_CLASS_OMCI_DEPTH    4096
+#define IND_CLASS_PKT_IN_DEPTH  8192
+#define IND_CLASS_STATS_DEPTH   1024
+
+#define IND_CLASS_CONTROL_WEIGHT 8
+#define IND_CLASS_OMCI_WEIGHT    4
+#define IND_CLASS_PKT_IN_WEIGHT  2
+#define IND_CLASS_STATS_WEIGHT   1
+
+// Buffers a serializing queue encodes into. Larger indications, and any
+// beyond the pool's count, are encoded into heap buffers instead.
+#define IND_WIRE_BUFS     2048
+#define IND_WIRE_BUF_SIZE 2048
+
+struct ind_class_counters {
+    uint64_t pushed;
+    uint64_t popped;
+    uint64_t dropped;
+    uint64_t depth;
+    uint64_t wait_ns_total;
+    uint64_t wait_ns_max;
+};
+
+// An indication on the queue. wire holds its encoding, wire_len bytes in a
+// buffer of wire_pool, when the queue serializes on push, and is NULL
+// otherwise. The buffer goes back to the pool with the entry.
+struct QueuedIndication {
+    IndicationPtr ind;
+    uint8_t* wire;
+    size_t wire_len;
+    PktBufPool* wire_pool;
+    int64_t enqueued_ns;
+
+    QueuedIndication() : wire(NULL), wire_len(0), wire_pool(NULL), enqueued_ns(0) {}
+    ~QueuedIndication() {
+        release();
+    }
+    QueuedIndication(QueuedIndication&& other) :
+        ind(std::move(other.ind)), wire(other.wire), wire_len(other.wire_len),
+        wire_pool(other.wire_pool), enqueued_ns(other.enqueued_ns) {
+        other.wire = NULL;
+    }
+    QueuedIndication& operator=(QueuedIndication&& other) {
+        if (this != &other) {
+            release();
+            ind = std::move(other.ind);
+            wire = other.wire;
+            wire_len = other.wire_len;
+            wire_pool = other.wire_pool;
+            enqueued_ns = other.enqueued_ns;
+            other.wire = NULL;
+        }
+        return *this;
+    }
+
+  private:
+    void release() {
+        if (wire != NULL) {
+            wire_pool->put(wire);
+            wire = NULL;
+        }
+    }
+};
+
+// The indication queue, split into one lock-free ring per priority class.
+// Any thread may push; a single consumer drains the lanes with a weighted
+// round robin so a burst in one class (typically packet-in) delays the
+// others by at most a few indications. Indications come from the queue's
+// pool through get() and go back to it once popped and released, so in
+// steady state building and queueing one allocates nothing. A serializing
+// queue also encodes each indication in push(), on the producer's thread,
+// into a pooled buffer, leaving the consumer only bytes to copy.
+class IndicationQueue {
+  public:
+    explicit IndicationQueue(bool serialize = false);
+    ~IndicationQueue();
+
+    IndicationQueue(const IndicationQueue&) = delete;
+    IndicationQueue& operator=(const IndicationQueue&) = delete;
+
+    // An empty indication to fill in and push, set up for data
+    IndicationPtr get(openolt::Indication::DataCase data) {
+        return pool_.get(data);
+    }
+
+    // Takes ownership of ind. May block while its lane is full, see above.
+    // Returns false if an indication was dropped because the lane is full.
+    bool push(IndicationPtr ind);
+
+    // Pushes every indication of inds, leaving inds empty, and wakes the
+    // consumer once. Returns the number not dropped.
+    size_t push_batch(std::vector<IndicationPtr>& inds);
+
+    // Waits up to timeout seconds for an indication. Returns false if there
+    // was none. Single consumer only.
+    bool pop(QueuedIndication& ind, int timeout);
+
+    // Waits up to timeout seconds for at least one indication, then takes
+    // every ready indication, up to max, in drain order. Returns the number
+    // appended to out. Single consumer only.
+    size_t pop_batch(std::vector<QueuedIndication>& out, size_t max, int timeout);
+
+    static ind_class classify(const openolt::Indication& ind);
+    static const char* class_name(ind_class c);
+
+    void get_counters(ind_class c, ind_class_counters* counters) const;
+    std::string counters_to_str() const;
+    void get_pool_counters(ind_pool_counters* counters) const {
+        pool_.get_counters(counters);
+    }
+    std::string pool_counters_to_str() const {
+        return pool_.counters_to_str() + ", wire buffer misses " + std::to_string(wire_misses());
+    }
+    // Encodings that did not fit a pooled buffer
+    uint64_t wire_misses() const {
+        return wire_pool_ != NULL ? wire_pool_->misses() : 0;
+    }
+
+  private:
+    struct Lane {
+        RingQueue<QueuedIndication>* ring;
+        unsigned weight;
+        std::atomic<uint64_t> pushed;
+        std::atomic<uint64_t> popped;
+        std::atomic<uint64_t> wait_ns_total;
+        std::atomic<uint64_t> wait_ns_max;
+        std::atomic<uint64_t> logged_drops;
+        std::atomic<int64_t> logged_ns;
+    };
+
+    bool enqueue(IndicationPtr ind);
+    void log_drops(ind_class c);
+    bool try_pop(QueuedIndication& ind);
+
+    // Declared before the lanes so that they outlive the indications in them
+    PktBufPool* wire_pool_;
+    IndicationPool pool_;
+    Lane lanes_[IND_CLASS_MAX];
+    RingNotifier notifier_;
+
+    // Drain state, owned by the consumer
+    unsigned cur_;
+    unsigned credit_;
+};
+
+#endif
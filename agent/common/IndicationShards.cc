@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include "IndicationShards.h"
+#include "Metrics.h"
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void update_max(std::atomic<uint64_t>& max, uint64_t value) {
+    if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+    }
+}
+
+IndicationShards::IndicationShards(unsigned shards, size_t depth) :
+    bufs_(IND_SHARD_BUFS, IND_SHARD_BUF_SIZE, 64), stopping_(false) {
+    for (unsigned i = 0; i < (shards ? shards : 1); i++) {
+        Shard* shard = new Shard;
+        shard->ring = new RingQueue<Entry>(depth, RING_OVERFLOW_DROP_NEWEST);
+        shard->packets = new RingQueue<Entry>(depth, RING_OVERFLOW_DROP_NEWEST);
+        shard->overflow_size = 0;
+        shard->submitted = 0;
+        shard->overflowed = 0;
+        shard->handled = 0;
+        shard->wait_ns_total = 0;
+        shard->wait_ns_max = 0;
+        shard->run_ns_max = 0;
+        shards_.push_back(shard);
+    }
+}
+
+IndicationShards::~IndicationShards() {
+    stopping_ = true;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (shards_[i]->thread.joinable()) {
+            shards_[i]->thread.join();
+        }
+        Entry entry;
+        while (next(shards_[i], &entry)) {
+            bufs_.put(entry.buf);
+        }
+        delete shards_[i]->ring;
+        delete shards_[i]->packets;
+        delete shards_[i];
+    }
+}
+
+void IndicationShards::start() {
+    for (size_t i = 0; i < shards_.size(); i++) {
+        shards_[i]->thread = std::thread(&IndicationShards::serve, this, shards_[i]);
+    }
+}
+
+bool IndicationShards::copy(Entry* entry, Handler handler, const void* obj, size_t len,
+                            const void* extra, size_t extra_len, size_t extra_ptr_offset) {
+    size_t extra_at = (len + 7) & ~(size_t)7;
+
+    entry->handler = handler;
+    entry->buf = bufs_.get(extra != NULL ? extra_at + extra_len : len);
+    if (entry->buf == NULL) {
+        return false;
+    }
+    memcpy(entry->buf, obj, len);
+    if (extra != NULL) {
+        uint8_t* copy = entry->buf + extra_at;
+        memcpy(copy, extra, extra_len);
+        memcpy(entry->buf + extra_ptr_offset, &copy, sizeof(copy));
+    }
+    entry->enqueued_ns = now_ns();
+    return true;
+}
+
+bool IndicationShards::submit(unsigned key, Handler handler, const void* obj, size_t len,
+                              const void* extra, size_t extra_len, size_t extra_ptr_offset) {
+    std::call_once(started_, [this]() { start(); });
+
+    Shard* shard = shards_[key % shards_.size()];
+    Entry entry;
+
+    if (!copy(&entry, handler, obj, len, extra, extra_len, extra_ptr_offset)) {
+        return false;
+    }
+    shard->submitted.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(shard->overflow_mutex);
+        if (!shard->overflow.empty() || !shard->ring->try_push(std::move(entry))) {
+            shard->overflow.push_back(entry);
+            shard->overflow_size.store(shard->overflow.size(), std::memory_order_release);
+            shard->overflowed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    shard->notifier.notify();
+    return true;
+}
+
+bool IndicationShards::submit_packet(unsigned key, Handler handler, const void* obj, size_t len,
+                                     const void* extra, size_t extra_len, size_t extra_ptr_offset) {
+    std::call_once(started_, [this]() { start(); });
+
+    Shard* shard = shards_[key % shards_.size()];
+    Entry entry;
+
+    if (!copy(&entry, handler, obj, len, extra, extra_len, extra_ptr_offset)) {
+        return false;
+    }
+    shard->submitted.fetch_add(1, std::memory_order_relaxed);
+    if (!shard->packets->push(std::move(entry))) {
+        bufs_.put(entry.buf);
+        return false;
+    }
+    shard->notifier.notify();
+    return true;
+}
+
+// The oldest state indication, from the ring and then from the overflow,
+// which only holds newer ones; a packet only if there is none
+bool IndicationShards::next(Shard* shard, Entry* entry) {
+    if (shard->ring->try_pop(*entry)) {
+        return true;
+    }
+    if (shard->overflow_size.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(shard->overflow_mutex);
+        if (!shard->overflow.empty()) {
+            *entry = shard->overflow.front();
+            shard->overflow.pop_front();
+            shard->overflow_size.store(shard->overflow.size(), std::memory_order_release);
+            return true;
+        }
+    }
+    return shard->packets->try_pop(*entry);
+}
+
+void IndicationShards::serve(Shard* shard) {
+    int wait_metric = metrics.histogram("queue.shard.wait");
+    int run_metric = metrics.histogram("shard.handler");
+    Entry entry;
+
+    while (!stopping_) {
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        if (!shard->notifier.wait_until(deadline, [&]() { return next(shard, &entry); })) {
+            continue;
+        }
+        int64_t start = now_ns();
+        entry.handler(entry.buf);
+        int64_t end = now_ns();
+        bufs_.put(entry.buf);
+
+        uint64_t wait = (uint64_t)(start - entry.enqueued_ns);
+        shard->wait_ns_total.fetch_add(wait, std::memory_order_relaxed);
+        update_max(shard->wait_ns_max, wait);
+        update_max(shard->run_ns_max, (uint64_t)(end - start));
+        metrics.record(wait_metric, wait);
+        metrics.record(run_metric, (uint64_t)(end - start));
+        shard->handled.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IndicationShards::get_counters(unsigned i, ind_shard_counters* counters) const {
+    const Shard* shard = shards_[i % shards_.size()];
+
+    counters->submitted = shard->submitted.load(std::memory_order_relaxed);
+    counters->dropped = shard->packets->dropped();
+    counters->overflowed = shard->overflowed.load(std::memory_order_relaxed);
+    counters->handled = shard->handled.load(std::memory_order_relaxed);
+    counters->depth = shard->ring->size() + shard->overflow_size.load(std::memory_order_relaxed) +
+        shard->packets->size();
+    counters->wait_us_total = shard->wait_ns_total.load(std::memory_order_relaxed) / 1000;
+    counters->wait_us_max = shard->wait_ns_max.load(std::memory_order_relaxed) / 1000;
+    counters->run_us_max = shard->run_ns_max.load(std::memory_order_relaxed) / 1000;
+}
+
+std::string IndicationShards::counters_to_str() const {
+    std::ostringstream out;
+
+    for (unsigned i = 0; i < size(); i++) {
+        ind_shard_counters c;
+        get_counters(i, &c);
+        out << (i ? ", " : "") << "shard " << i
+            << " depth " << c.depth
+            << " handled " << c.handled
+            << " dropped " << c.dropped
+            << " overflowed " << c.overflowed
+            << " wait avg/max us " << (c.handled ? c.wait_us_total / c.handled : 0) << "/" << c.wait_us_max
+            << " run max us " << c.run_us_max;
+    }
+    out << ", buffer misses " << bufs_.misses();
+    return out.str();
+}
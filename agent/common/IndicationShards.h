@@ -0,0 +1,127 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_INDICATION_SHARDS_H_
+#define OPENOLT_INDICATION_SHARDS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PktBufPool.h"
+#include "RingQueue.h"
+
+// Copies of up to IND_SHARD_BUF_SIZE bytes, object and payload together,
+// come from a pool of IND_SHARD_BUFS buffers; larger ones, and any once the
+// pool runs dry in a burst, from the heap
+#define IND_SHARD_BUF_SIZE 2560
+#define IND_SHARD_BUFS     2048
+
+struct ind_shard_counters {
+    uint64_t submitted;
+    uint64_t dropped;       // packets, the packet ring full
+    uint64_t overflowed;    // state indications queued on the heap, the ring full
+    uint64_t handled;
+    uint64_t depth;
+    uint64_t wait_us_total; // from submit() until the handler ran
+    uint64_t wait_us_max;
+    uint64_t run_us_max;    // in the handler
+};
+
+// Takes raw driver indications off the driver's callback threads. A
+// callback only copies the indication into a buffer and queues it on a
+// shard, chosen by a key such as the PON interface, so it returns in
+// bounded time whatever handling the indication needs. Each shard has a
+// worker thread that runs the handlers in the order the indications came
+// in, so the indications of one key stay in order. Workers start on first
+// use.
+//
+// Packet-in, which comes in storms, has a ring of its own per shard that
+// the worker only serves while no other indication waits, so state changes
+// never queue behind packets. Packets are dropped when their ring is full;
+// other indications never are, past a full ring they wait on the heap.
+class IndicationShards {
+  public:
+    typedef void (*Handler)(void* obj);
+
+    IndicationShards(unsigned shards, size_t depth);
+    ~IndicationShards();
+
+    IndicationShards(const IndicationShards&) = delete;
+    IndicationShards& operator=(const IndicationShards&) = delete;
+
+    // Copies len bytes at obj and has handler run on the copy by the worker
+    // of shard key % size(). If extra is not NULL, extra_len bytes at extra
+    // are copied after obj and the pointer at extra_ptr_offset in the copy
+    // of obj set to them. Returns false only if there was no memory for the
+    // copy.
+    bool submit(unsigned key, Handler handler, const void* obj, size_t len,
+                const void* extra = NULL, size_t extra_len = 0, size_t extra_ptr_offset = 0);
+
+    // As submit(), for a packet-in. Returns false if the shard's packet
+    // ring was full and the packet dropped.
+    bool submit_packet(unsigned key, Handler handler, const void* obj, size_t len,
+                       const void* extra = NULL, size_t extra_len = 0, size_t extra_ptr_offset = 0);
+
+    unsigned size() const { return shards_.size(); }
+
+    void get_counters(unsigned shard, ind_shard_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    struct Entry {
+        Handler handler;
+        uint8_t* buf;
+        int64_t enqueued_ns;
+    };
+
+    struct Shard {
+        RingQueue<Entry>* ring;
+        RingQueue<Entry>* packets;
+        // Indications past a full ring, newer than any in it. Producers
+        // queue on the ring only while this is empty, under mutex.
+        std::mutex overflow_mutex;
+        std::deque<Entry> overflow;
+        std::atomic<size_t> overflow_size;
+        RingNotifier notifier;
+        std::thread thread;
+        std::atomic<uint64_t> submitted;
+        std::atomic<uint64_t> overflowed;
+        std::atomic<uint64_t> handled;
+        std::atomic<uint64_t> wait_ns_total;
+        std::atomic<uint64_t> wait_ns_max;
+        std::atomic<uint64_t> run_ns_max;
+    };
+
+    void start();
+    bool copy(Entry* entry, Handler handler, const void* obj, size_t len,
+              const void* extra, size_t extra_len, size_t extra_ptr_offset);
+    bool next(Shard* shard, Entry* entry);
+    void serve(Shard* shard);
+
+    PktBufPool bufs_;
+    std::vector<Shard*> shards_;
+    std::once_flag started_;
+    std::atomic<bool> stopping_;
+};
+
+#endif
@@ -0,0 +1,296 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "Metrics.h"
+
+Metrics metrics;
+
+Metrics::Metrics() : retired_histograms_(METRICS_MAX), retired_counters_(METRICS_MAX, 0) {
+}
+
+int Metrics::find_or_add(std::vector<std::string>& names, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string>::iterator it = std::find(names.begin(), names.end(), name);
+    if (it != names.end()) {
+        return it - names.begin();
+    }
+    if (names.size() == METRICS_MAX) {
+        std::cout << "WARNING: no room for metric " << name << std::endl;
+        return -1;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+int Metrics::histogram(const std::string& name) {
+    return find_or_add(histogram_names_, name);
+}
+
+int Metrics::counter(const std::string& name) {
+    return find_or_add(counter_names_, name);
+}
+
+Metrics::ThreadHandle::ThreadHandle() : block(new ThreadBlock()) {
+    std::lock_guard<std::mutex> lock(metrics.mutex_);
+    metrics.threads_.push_back(block);
+}
+
+Metrics::ThreadHandle::~ThreadHandle() {
+    std::lock_guard<std::mutex> lock(metrics.mutex_);
+    metrics.fold(block, metrics.retired_histograms_, metrics.retired_counters_);
+    metrics.threads_.erase(std::find(metrics.threads_.begin(), metrics.threads_.end(), block));
+    for (int i = 0; i < METRICS_MAX; i++) {
+        delete block->histograms[i].load(std::memory_order_relaxed);
+    }
+    delete block;
+}
+
+Metrics::ThreadBlock* Metrics::thread_block() {
+    static thread_local ThreadHandle handle;
+    return handle.block;
+}
+
+void Metrics::record(int id, uint64_t ns) {
+    if (id < 0) {
+        return;
+    }
+    ThreadBlock* block = thread_block();
+    Histogram* h = block->histograms[id].load(std::memory_order_relaxed);
+    if (h == NULL) {
+        h = new Histogram();
+        block->histograms[id].store(h, std::memory_order_release);
+    }
+    bump(h->buckets[bucket(ns)], 1);
+    bump(h->count, 1);
+    bump(h->sum_ns, ns);
+    if (ns > h->max_ns.load(std::memory_order_relaxed)) {
+        h->max_ns.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::add(int id, uint64_t n) {
+    if (id >= 0) {
+        bump(thread_block()->counters[id], n);
+    }
+}
+
+void Metrics::add_source(const Source& source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sources_.push_back(source);
+}
+
+// Adds the thread's blocks to histograms and counters. Call locked.
+void Metrics::fold(const ThreadBlock* block, std::vector<metrics_histogram>& histograms,
+                   std::vector<uint64_t>& counters) {
+    for (int i = 0; i < METRICS_MAX; i++) {
+        counters[i] += block->counters[i].load(std::memory_order_relaxed);
+
+        const Histogram* h = block->histograms[i].load(std::memory_order_acquire);
+        if (h == NULL) {
+            continue;
+        }
+        metrics_histogram& out = histograms[i];
+        if (out.buckets.empty()) {
+            out.count = out.sum_ns = out.max_ns = 0;
+            out.buckets.assign(METRICS_BUCKETS, 0);
+        }
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            out.buckets[b] += h->buckets[b].load(std::memory_order_relaxed);
+        }
+        out.count += h->count.load(std::memory_order_relaxed);
+        out.sum_ns += h->sum_ns.load(std::memory_order_relaxed);
+        out.max_ns = std::max(out.max_ns, (uint64_t)h->max_ns.load(std::memory_order_relaxed));
+    }
+}
+
+static bool has_prefix(const std::string& name, const std::string& prefix) {
+    return name.compare(0, prefix.size(), prefix) == 0;
+}
+
+void Metrics::snapshot(std::vector<metrics_histogram>* histograms, metrics_counters* counters,
+                       const std::string& prefix) {
+    std::vector<metrics_histogram> merged;
+    std::vector<uint64_t> totals;
+    std::vector<std::string> histogram_names;
+    std::vector<std::string> counter_names;
+    std::vector<Source> sources;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        merged = retired_histograms_;
+        totals = retired_counters_;
+        for (size_t i = 0; i < threads_.size(); i++) {
+            fold(threads_[i], merged, totals);
+        }
+        histogram_names = histogram_names_;
+        counter_names = counter_names_;
+        sources = sources_;
+    }
+
+    histograms->clear();
+    for (size_t i = 0; i < histogram_names.size(); i++) {
+        if (!merged[i].buckets.empty() && merged[i].count > 0 && has_prefix(histogram_names[i], prefix)) {
+            histograms->push_back(merged[i]);
+            histograms->back().name = histogram_names[i];
+        }
+    }
+    counters->clear();
+    for (size_t i = 0; i < counter_names.size(); i++) {
+        if (has_prefix(counter_names[i], prefix)) {
+            counters->push_back(std::make_pair(counter_names[i], totals[i]));
+        }
+    }
+    metrics_counters sourced;
+    for (size_t i = 0; i < sources.size(); i++) {
+        sources[i](&sourced);
+    }
+    for (size_t i = 0; i < sourced.size(); i++) {
+        if (has_prefix(sourced[i].first, prefix)) {
+            counters->push_back(sourced[i]);
+        }
+    }
+
+    std::sort(histograms->begin(), histograms->end(),
+              [](const metrics_histogram& a, const metrics_histogram& b) { return a.name < b.name; });
+    std::sort(counters->begin(), counters->end());
+}
+
+uint64_t Metrics::bucket_upper(int bucket) {
+    if (bucket < (2 << METRICS_SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    int shift = (bucket >> METRICS_SUB_BUCKET_BITS) - 1;
+    uint64_t sub = (bucket & ((1 << METRICS_SUB_BUCKET_BITS) - 1)) + (1 << METRICS_SUB_BUCKET_BITS);
+    return ((sub + 1) << shift) - 1;
+}
+
+uint64_t Metrics::percentile(const metrics_histogram& h, double q) {
+    if (h.count == 0 || h.buckets.empty()) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(q * h.count);
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += h.buckets[b];
+        if (seen > rank) {
+            uint64_t lower = b ? bucket_upper(b - 1) + 1 : 0;
+            return std::min((lower + bucket_upper(b)) / 2, h.max_ns);
+        }
+    }
+    return h.max_ns;
+}
+
+std::string Metrics::to_text(const std::string& prefix) {
+    std::vector<metrics_histogram> histograms;
+    metrics_counters counters;
+    std::ostringstream out;
+    char line[256];
+
+    snapshot(&histograms, &counters, prefix);
+    for (size_t i = 0; i < histograms.size(); i++) {
+        const metrics_histogram& h = histograms[i];
+        snprintf(line, sizeof(line),
+                 "%s count %llu avg_us %.1f p50_us %.1f p90_us %.1f p99_us %.1f p999_us %.1f max_us %.1f\n",
+                 h.name.c_str(), (unsigned long long)h.count, h.sum_ns / 1000.0 / h.count,
+                 percentile(h, 0.5) / 1000.0, percentile(h, 0.9) / 1000.0, percentile(h, 0.99) / 1000.0,
+                 percentile(h, 0.999) / 1000.0, h.max_ns / 1000.0);
+        out << line;
+    }
+    for (size_t i = 0; i < counters.size(); i++) {
+        out << counters[i].first << " " << counters[i].second << "\n";
+    }
+    return out.str();
+}
+
+bool Metrics::serve_text(const std::string& address) {
+    size_t colon = address.rfind(':');
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(address.substr(colon + 1).c_str()));
+    if (colon == std::string::npos ||
+        inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+        std::cout << "ERROR: bad metrics address " << address << std::endl;
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        std::cout << "ERROR: cannot serve metrics on " << address << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    std::thread(&Metrics::serve, this, fd).detach();
+    std::cout << "Serving metrics on http://" << address << "/" << std::endl;
+    return true;
+}
+
+// Answers each request with to_text() of the metrics whose names start with
+// the request path, e.g. GET /rpc. for those of the RPCs
+void Metrics::serve(int fd) {
+    for (;;) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0) {
+            continue;
+        }
+        struct timeval timeout = { 2, 0 };
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        char request[1024];
+        ssize_t n = recv(conn, request, sizeof(request) - 1, 0);
+        std::string prefix;
+        if (n > 0) {
+            request[n] = '\0';
+            const char* path = strchr(request, '/');
+            if (path != NULL) {
+                prefix.assign(path + 1, strcspn(path + 1, " ?\r\n"));
+            }
+        }
+
+        std::string body = to_text(prefix);
+        std::ostringstream response;
+        response << "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " << body.size()
+                 << "\r\n\r\n" << body;
+        std::string bytes = response.str();
+        for (size_t sent = 0; sent < bytes.size(); ) {
+            ssize_t m = send(conn, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+            if (m <= 0) {
+                break;
+            }
+            sent += m;
+        }
+        close(conn);
+    }
+}
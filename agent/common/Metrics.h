@@ -0,0 +1,170 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_METRICS_H_
+#define OPENOLT_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// At most METRICS_MAX histograms and as many counters can be registered
+#define METRICS_MAX 128
+
+// Histograms are HDR style: values below 2^(METRICS_SUB_BUCKET_BITS + 1) ns
+// have a bucket each, each power of two above that is split into
+// 2^METRICS_SUB_BUCKET_BITS buckets, so a bucket is at most 1/16 of its
+// value wide. Values from 2^METRICS_MAX_BITS ns, about 18 minutes, go to the
+// last bucket.
+#define METRICS_SUB_BUCKET_BITS 4
+#define METRICS_MAX_BITS 40
+#define METRICS_BUCKETS ((METRICS_MAX_BITS - METRICS_SUB_BUCKET_BITS + 1) << METRICS_SUB_BUCKET_BITS)
+
+struct metrics_histogram {
+    std::string name;
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    std::vector<uint64_t> buckets;      // METRICS_BUCKETS counts
+};
+
+typedef std::vector<std::pair<std::string, uint64_t> > metrics_counters;
+
+// Latency histograms and event counters. Each thread records into blocks
+// of its own, without locks or shared cache lines; snapshot() merges the
+// blocks of all threads when asked, along with those of threads that have
+// exited. Histogram blocks are allocated on a thread's first record into
+// them.
+class Metrics {
+  public:
+    typedef std::function<void(metrics_counters* out)> Source;
+
+    Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Registers a histogram or counter, or finds the one of the same name.
+    // Returns its id, -1 if there are already METRICS_MAX of them.
+    int histogram(const std::string& name);
+    int counter(const std::string& name);
+
+    // Cheap enough for any path; a negative id is ignored
+    void record(int id, uint64_t ns);
+    void add(int id, uint64_t n = 1);
+
+    // Adds counters kept elsewhere, e.g. those of a queue, to snapshot()
+    void add_source(const Source& source);
+
+    // Histograms and counters with names starting with prefix. Histograms
+    // that never recorded anything are left out.
+    void snapshot(std::vector<metrics_histogram>* histograms, metrics_counters* counters,
+                  const std::string& prefix = "");
+
+    // Value below which q of the histogram's values fall, as the middle of
+    // their bucket
+    static uint64_t percentile(const metrics_histogram& h, double q);
+    static uint64_t bucket_upper(int bucket);
+
+    // One line per histogram and counter
+    std::string to_text(const std::string& prefix = "");
+
+    // Serves to_text() over HTTP on a thread of its own, e.g. on
+    // "127.0.0.1:9192". Returns false if it cannot listen on address.
+    bool serve_text(const std::string& address);
+
+    static int bucket(uint64_t ns) {
+        if (ns < (2ULL << METRICS_SUB_BUCKET_BITS)) {
+            return (int)ns;
+        }
+        int msb = 63 - __builtin_clzll(ns);
+        if (msb >= METRICS_MAX_BITS) {
+            return METRICS_BUCKETS - 1;
+        }
+        int shift = msb - METRICS_SUB_BUCKET_BITS;
+        return (shift << METRICS_SUB_BUCKET_BITS) + (int)(ns >> shift);
+    }
+
+  private:
+    struct Histogram {
+        std::atomic<uint64_t> buckets[METRICS_BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum_ns;
+        std::atomic<uint64_t> max_ns;
+    };
+
+    // The blocks of one thread. Only the thread writes them, with relaxed
+    // loads and stores, so snapshot() may read them at any time.
+    struct ThreadBlock {
+        std::atomic<Histogram*> histograms[METRICS_MAX];
+        std::atomic<uint64_t> counters[METRICS_MAX];
+    };
+
+    // Registers the thread's block on its first record and folds it into
+    // retired_ when the thread exits
+    struct ThreadHandle {
+        ThreadHandle();
+        ~ThreadHandle();
+        ThreadBlock* block;
+    };
+
+    static ThreadBlock* thread_block();
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    int find_or_add(std::vector<std::string>& names, const std::string& name);
+    void fold(const ThreadBlock* block, std::vector<metrics_histogram>& histograms,
+              std::vector<uint64_t>& counters);
+    void serve(int fd);
+
+    std::mutex mutex_;
+    std::vector<std::string> histogram_names_;
+    std::vector<std::string> counter_names_;
+    std::vector<ThreadBlock*> threads_;
+    std::vector<metrics_histogram> retired_histograms_;
+    std::vector<uint64_t> retired_counters_;
+    std::vector<Source> sources_;
+};
+
+extern Metrics metrics;
+
+// Records the time from its construction to its destruction
+class MetricsTimer {
+  public:
+    explicit MetricsTimer(int id) : id_(id), start_(std::chrono::steady_clock::now()) {}
+    ~MetricsTimer() {
+        metrics.record(id_, elapsed_ns());
+    }
+
+    uint64_t elapsed_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+    }
+
+  private:
+    int id_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif
@@ -0,0 +1,286 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "OnuTracer.h"
+#include "Metrics.h"
+#include "core.h"
+
+OnuTracer onuTracer(ONU_TRACE_PONS, ONU_TRACE_ONUS, ONU_TRACE_RING_SIZE);
+
+static const uint64_t pending_max_age_ns = (uint64_t)ONU_TRACE_PENDING_MAX_AGE * 1000000000ULL;
+
+static inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The onu_activation.<stage> histograms, registered on first use rather
+// than in the constructor, which may run before metrics is built
+static int stage_histogram(onu_stage stage) {
+    static const std::vector<int> ids = []() {
+        std::vector<int> ids;
+        for (int i = 0; i < ONU_STAGE_MAX; i++) {
+            ids.push_back(metrics.histogram(std::string("onu_activation.") +
+                                            OnuTracer::stage_name((onu_stage)i)));
+        }
+        return ids;
+    }();
+    return ids[stage];
+}
+
+OnuTracer::OnuTracer(unsigned pons, unsigned onus, size_t ring_size) :
+    pons_(pons), onus_(onus), timelines_(pons * onus), head_(0), activations_(0), expired_(0) {
+    size_t size = 1;
+    while (size < ring_size) {
+        size <<= 1;
+    }
+    ring_ = std::vector<Event>(size);
+    mask_ = size - 1;
+
+    for (size_t i = 0; i < timelines_.size(); i++) {
+        for (int s = 0; s < ONU_STAGE_MAX; s++) {
+            timelines_[i].at[s].store(0, std::memory_order_relaxed);
+        }
+    }
+    for (size_t i = 0; i < ring_.size(); i++) {
+        ring_[i].seq.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* OnuTracer::stage_name(onu_stage stage) {
+    switch (stage) {
+        case ONU_STAGE_DISCOVERED: return "discovered";
+        case ONU_STAGE_ACTIVATE: return "activate";
+        case ONU_STAGE_UP: return "up";
+        case ONU_STAGE_OMCI_OUT: return "omci_out";
+        case ONU_STAGE_OMCI_IN: return "omci_in";
+        case ONU_STAGE_TCONTS: return "tconts";
+        case ONU_STAGE_FLOW: return "flow";
+        case ONU_STAGE_DOWN: return "down";
+        default: return "unknown";
+    }
+}
+
+uint64_t OnuTracer::serial_key(const char* vendor_id, const char* vendor_specific) {
+    uint32_t id = 0;
+    uint32_t specific = 0;
+    memcpy(&id, vendor_id, 4);
+    memcpy(&specific, vendor_specific, 4);
+    return (uint64_t)id << 32 | specific;
+}
+
+void OnuTracer::append(uint32_t intf_id, uint32_t onu_id, onu_stage stage, uint64_t ts_ns) {
+    uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Event& event = ring_[index & mask_];
+
+    event.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.ts_ns.store(ts_ns, std::memory_order_relaxed);
+    event.what.store(intf_id << 20 | onu_id << 4 | stage, std::memory_order_relaxed);
+    event.seq.store(2 * index + 2, std::memory_order_release);
+}
+
+void OnuTracer::reached(Timeline& timeline, onu_stage stage, uint64_t ts_ns) {
+    uint64_t unset = 0;
+    if (!timeline.at[stage].compare_exchange_strong(unset, ts_ns, std::memory_order_relaxed)) {
+        return;
+    }
+    uint64_t start = timeline.at[ONU_STAGE_DISCOVERED].load(std::memory_order_relaxed);
+    if (start == 0) {
+        start = timeline.at[ONU_STAGE_ACTIVATE].load(std::memory_order_relaxed);
+    }
+    if (start != 0 && stage != ONU_STAGE_DISCOVERED && ts_ns >= start) {
+        metrics.record(stage_histogram(stage), ts_ns - start);
+    }
+    if (stage == ONU_STAGE_FLOW && timeline.at[ONU_STAGE_ACTIVATE].load(std::memory_order_relaxed) != 0) {
+        activations_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Drops the discoveries older than ONU_TRACE_PENDING_MAX_AGE. Called with
+// pending_mutex_ held.
+void OnuTracer::expire_pending(uint64_t now) {
+    std::map<std::pair<uint32_t, uint64_t>, uint64_t>::iterator it = pending_.begin();
+    while (it != pending_.end()) {
+        if (now - it->second > pending_max_age_ns) {
+            pending_.erase(it++);
+            expired_++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void OnuTracer::discovered(uint32_t intf_id, const char* vendor_id, const char* vendor_specific) {
+    std::pair<uint32_t, uint64_t> key(intf_id, serial_key(vendor_id, vendor_specific));
+    uint64_t now = now_ns();
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+
+    // BAL repeats the discovery of an ONU until it is activated; its
+    // time to service counts from the first, unless that one is so old
+    // the ONU must have gone and come back since
+    std::map<std::pair<uint32_t, uint64_t>, uint64_t>::iterator it = pending_.find(key);
+    if (it != pending_.end()) {
+        if (now - it->second > pending_max_age_ns) {
+            it->second = now;
+            expired_++;
+        }
+        return;
+    }
+    if (pending_.size() >= ONU_TRACE_PENDING_MAX) {
+        expire_pending(now);
+    }
+    if (pending_.size() < ONU_TRACE_PENDING_MAX) {
+        pending_.insert(std::make_pair(key, now));
+    }
+}
+
+void OnuTracer::expire() {
+    uint64_t now = now_ns();
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    expire_pending(now);
+}
+
+void OnuTracer::activate(uint32_t intf_id, uint32_t onu_id, const char* vendor_id,
+                         const char* vendor_specific) {
+    uint64_t now = now_ns();
+    uint64_t discovered = 0;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        std::map<std::pair<uint32_t, uint64_t>, uint64_t>::iterator it =
+            pending_.find(std::make_pair(intf_id, serial_key(vendor_id, vendor_specific)));
+        if (it != pending_.end()) {
+            discovered = it->second;
+            pending_.erase(it);
+        }
+    }
+    if (!valid(intf_id, onu_id)) {
+        return;
+    }
+
+    Timeline& t = timeline(intf_id, onu_id);
+    for (int s = 0; s < ONU_STAGE_MAX; s++) {
+        t.at[s].store(0, std::memory_order_relaxed);
+    }
+    if (discovered != 0) {
+        t.at[ONU_STAGE_DISCOVERED].store(discovered, std::memory_order_relaxed);
+        append(intf_id, onu_id, ONU_STAGE_DISCOVERED, discovered);
+    }
+    reached(t, ONU_STAGE_ACTIVATE, now);
+    append(intf_id, onu_id, ONU_STAGE_ACTIVATE, now);
+}
+
+void OnuTracer::trace(uint32_t intf_id, uint32_t onu_id, onu_stage stage) {
+    if (!valid(intf_id, onu_id)) {
+        return;
+    }
+    uint64_t now = now_ns();
+    if (stage != ONU_STAGE_DOWN) {
+        reached(timeline(intf_id, onu_id), stage, now);
+    }
+    append(intf_id, onu_id, stage, now);
+}
+
+std::string OnuTracer::trace_json(uint32_t intf_id, uint32_t onu_id) const {
+    std::vector<std::pair<uint64_t, onu_stage> > events;
+    uint32_t onu = intf_id << 20 | onu_id << 4;
+
+    for (size_t i = 0; i < ring_.size(); i++) {
+        const Event& event = ring_[i];
+        uint64_t seq = event.seq.load(std::memory_order_acquire);
+        if (seq == 0 || (seq & 1)) {
+            continue;
+        }
+        uint64_t ts_ns = event.ts_ns.load(std::memory_order_relaxed);
+        uint32_t what = event.what.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.seq.load(std::memory_order_relaxed) != seq) {
+            continue;   // rewritten while read
+        }
+        if ((what & ~0xfU) == onu) {
+            events.push_back(std::make_pair(ts_ns, (onu_stage)(what & 0xf)));
+        }
+    }
+    std::sort(events.begin(), events.end());
+
+    // Times are in microseconds from the ONU's first event
+    uint64_t origin = events.empty() ? 0 : events.front().first;
+    uint64_t start = 0;
+    std::ostringstream out;
+    char line[256];
+
+    snprintf(line, sizeof(line),
+             "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"PON %u\"}},\n"
+             "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"ONU %u\"}}",
+             intf_id, intf_id, intf_id, onu_id, onu_id);
+    out << line;
+    for (size_t i = 0; i < events.size(); i++) {
+        uint64_t ts_ns = events[i].first;
+        onu_stage stage = events[i].second;
+        snprintf(line, sizeof(line),
+                 ",\n{\"name\":\"%s\",\"cat\":\"onu\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+                 stage_name(stage), (ts_ns - origin) / 1000.0, intf_id, onu_id);
+        out << line;
+
+        // A span per activation, to its first flow
+        if (stage == ONU_STAGE_DISCOVERED || (stage == ONU_STAGE_ACTIVATE && start == 0)) {
+            start = ts_ns;
+        } else if (stage == ONU_STAGE_FLOW && start != 0) {
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\":\"time_to_service\",\"cat\":\"onu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                     "\"pid\":%u,\"tid\":%u}",
+                     (start - origin) / 1000.0, (ts_ns - start) / 1000.0, intf_id, onu_id);
+            out << line;
+            start = 0;
+        } else if (stage == ONU_STAGE_DOWN) {
+            start = 0;
+        }
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+void OnuTracer::get_counters(onu_trace_counters* counters) const {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+
+    counters->traced = head;
+    counters->overwritten = head > ring_.size() ? head - ring_.size() : 0;
+    counters->activations = activations_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    counters->pending = pending_.size();
+    counters->expired = expired_;
+}
+
+std::string OnuTracer::counters_to_str() const {
+    onu_trace_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "traced " << c.traced
+        << " overwritten " << c.overwritten
+        << " activations " << c.activations
+        << " pending " << c.pending
+        << " expired " << c.expired;
+    return out.str();
+}
@@ -0,0 +1,131 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_ONU_TRACER_H_
+#define OPENOLT_ONU_TRACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Stages of an ONU's way from power-on to service, in their usual order
+enum onu_stage {
+    ONU_STAGE_DISCOVERED,   // OnuDiscoveryIndication
+    ONU_STAGE_ACTIVATE,     // ActivateOnu_
+    ONU_STAGE_UP,           // OnuIndication, oper state up
+    ONU_STAGE_OMCI_OUT,     // OmciMsgOut_
+    ONU_STAGE_OMCI_IN,      // OmciIndication
+    ONU_STAGE_TCONTS,       // CreateTconts_
+    ONU_STAGE_FLOW,         // FlowAdd_
+    ONU_STAGE_DOWN,         // OnuIndication, oper state down, or DeleteOnu_
+    ONU_STAGE_MAX
+};
+
+struct onu_trace_counters {
+    uint64_t traced;            // events put in the ring
+    uint64_t overwritten;       // events the ring lost to newer ones
+    uint64_t activations;       // ONUs that got from activation to a flow
+    uint64_t pending;           // ONUs discovered and not activated yet
+    uint64_t expired;           // discoveries forgotten for their age
+};
+
+// Timestamps the stages of every ONU's activation, keyed by (intf_id,
+// onu_id), into a ring of events that writers claim with a single atomic
+// add and readers copy under a per slot sequence number, so tracing never
+// locks. The first time an ONU reaches each stage after its activation,
+// the time since its discovery (or its activation, when the agent did not
+// see it discovered) goes into the onu_activation.<stage> histogram of
+// Metrics; onu_activation.flow is thus the time to service.
+//
+// A discovered ONU has no onu_id yet: its discovery is held by serial
+// number until ActivateOnu_ gives it one, or for ONU_TRACE_PENDING_MAX_AGE
+// seconds at most.
+class OnuTracer {
+  public:
+    OnuTracer(unsigned pons, unsigned onus, size_t ring_size);
+
+    OnuTracer(const OnuTracer&) = delete;
+    OnuTracer& operator=(const OnuTracer&) = delete;
+
+    // vendor_id and vendor_specific are the first 4 bytes of each
+    void discovered(uint32_t intf_id, const char* vendor_id, const char* vendor_specific);
+    void activate(uint32_t intf_id, uint32_t onu_id, const char* vendor_id, const char* vendor_specific);
+
+    // Forgets the discoveries of ONUs that were never activated
+    void expire();
+
+    // Any stage but ONU_STAGE_DISCOVERED and ONU_STAGE_ACTIVATE. ONUs out of
+    // range are ignored.
+    void trace(uint32_t intf_id, uint32_t onu_id, onu_stage stage);
+
+    // The ONU's events still in the ring, in trace event format JSON
+    std::string trace_json(uint32_t intf_id, uint32_t onu_id) const;
+
+    static const char* stage_name(onu_stage stage);
+
+    void get_counters(onu_trace_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    // Written under a sequence number: odd while a writer fills it in,
+    // 2 * (index + 1) once event index is in
+    struct Event {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> ts_ns;
+        std::atomic<uint32_t> what;     // intf_id << 20 | onu_id << 4 | stage
+    };
+
+    // First time of each stage in the ONU's current activation, 0 if not
+    // reached yet. ONU_STAGE_DISCOVERED or ONU_STAGE_ACTIVATE starts it.
+    struct Timeline {
+        std::atomic<uint64_t> at[ONU_STAGE_MAX];
+    };
+
+    static uint64_t serial_key(const char* vendor_id, const char* vendor_specific);
+
+    bool valid(uint32_t intf_id, uint32_t onu_id) const {
+        return intf_id < pons_ && onu_id < onus_;
+    }
+    Timeline& timeline(uint32_t intf_id, uint32_t onu_id) {
+        return timelines_[intf_id * onus_ + onu_id];
+    }
+
+    void append(uint32_t intf_id, uint32_t onu_id, onu_stage stage, uint64_t ts_ns);
+    void reached(Timeline& timeline, onu_stage stage, uint64_t ts_ns);
+    void expire_pending(uint64_t now);
+
+    unsigned pons_;
+    unsigned onus_;
+    std::vector<Timeline> timelines_;
+    std::vector<Event> ring_;
+    size_t mask_;
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> activations_;
+
+    // Discovery times by (intf_id, serial number)
+    mutable std::mutex pending_mutex_;
+    std::map<std::pair<uint32_t, uint64_t>, uint64_t> pending_;
+    uint64_t expired_;
+};
+
+extern OnuTracer onuTracer;
+
+#endif
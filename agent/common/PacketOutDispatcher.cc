@@ -0,0 +1,124 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Metrics.h"
+#include "PacketOutDispatcher.h"
+
+PacketOutDispatcher pktOutDispatcher;
+
+void PacketOutResults::submitted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_++;
+}
+
+void PacketOutResults::completed(uint64_t seq, const Status& status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!status.ok()) {
+        failed_.push_back(openolt::PacketOutResult());
+        failed_.back().set_seq(seq);
+        failed_.back().set_code(status.error_code());
+        failed_.back().set_message(status.error_message());
+    }
+    if (--pending_ == 0) {
+        idle_.notify_all();
+    }
+}
+
+bool PacketOutResults::take_failed(std::vector<openolt::PacketOutResult>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_.empty()) {
+        return false;
+    }
+    out.swap(failed_);
+    failed_.clear();
+    return true;
+}
+
+void PacketOutResults::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+PacketOutDispatcher::PacketOutDispatcher() :
+    queue_(PKT_OUT_QUEUE_DEPTH, RING_OVERFLOW_BLOCK), workers_(PKT_OUT_WORKERS) {
+}
+
+void PacketOutDispatcher::submit(PacketOutResults* results, openolt::PacketOutMsg& msg) {
+    std::call_once(started_, [this]() { std::thread(&PacketOutDispatcher::run, this).detach(); });
+
+    Job job;
+    job.results = results;
+    job.msg.Swap(&msg);
+    job.enqueued = std::chrono::steady_clock::now();
+    results->submitted();
+    queue_.push(std::move(job));
+}
+
+// The worker key: PONs count up from the first worker, uplinks down from
+// the last
+unsigned PacketOutDispatcher::destination(const openolt::PacketOutMsg& msg) {
+    if (msg.has_uplink_pkt()) {
+        return ~msg.uplink_pkt().intf_id();
+    }
+    return msg.onu_pkt().intf_id();
+}
+
+Status PacketOutDispatcher::send(const openolt::PacketOutMsg& msg) {
+    switch (msg.pkt_case()) {
+    case openolt::PacketOutMsg::kOnuPkt:
+        return OnuPacketOut_(
+            msg.onu_pkt().intf_id(),
+            msg.onu_pkt().onu_id(),
+            msg.onu_pkt().port_no(),
+            msg.onu_pkt().pkt());
+    case openolt::PacketOutMsg::kUplinkPkt:
+        return UplinkPacketOut_(
+            msg.uplink_pkt().intf_id(),
+            msg.uplink_pkt().pkt());
+    default:
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "no packet");
+    }
+}
+
+void PacketOutDispatcher::run() {
+    int wait_metric = metrics.histogram("queue.packet_out.wait");
+    std::vector<Job> batch;
+
+    batch.reserve(PKT_OUT_BATCH_SIZE);
+
+    for (;;) {
+        batch.clear();
+        batch.push_back(Job());
+        queue_.pop(batch.back());
+        while (batch.size() < PKT_OUT_BATCH_SIZE) {
+            batch.push_back(Job());
+            if (!queue_.try_pop(batch.back())) {
+                batch.pop_back();
+                break;
+            }
+        }
+
+        workers_.run(batch.size(),
+            [&batch](size_t i) { return destination(batch[i].msg); },
+            [&batch, wait_metric](size_t i) {
+                Job& job = batch[i];
+                metrics.record(wait_metric, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - job.enqueued).count());
+                job.results->completed(job.msg.seq(), send(job.msg));
+            });
+    }
+}
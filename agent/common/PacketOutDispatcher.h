@@ -0,0 +1,89 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_PACKET_OUT_DISPATCHER_H_
+#define OPENOLT_PACKET_OUT_DISPATCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <openolt.grpc.pb.h>
+#include "core.h"
+#include "RingQueue.h"
+#include "WorkerPool.h"
+
+// Outcome of the packets one PacketOut stream submitted. The dispatcher
+// reports each packet here; the stream collects the failures.
+class PacketOutResults {
+  public:
+    PacketOutResults() : pending_(0) {}
+
+    void submitted();
+    void completed(uint64_t seq, const Status& status);
+
+    // Moves the failures reported so far to out. Returns false if none.
+    bool take_failed(std::vector<openolt::PacketOutResult>& out);
+
+    // Waits until every submitted packet has completed
+    void wait_idle();
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    uint64_t pending_;
+    std::vector<openolt::PacketOutResult> failed_;
+};
+
+// Sends the packets of all PacketOut streams. A dispatcher thread takes up
+// to PKT_OUT_BATCH_SIZE queued packets at a time and hands them to a pool
+// of PKT_OUT_WORKERS workers keyed by destination interface, so the
+// packets of different PONs go out in parallel while those of one
+// interface keep their arrival order. BAL has no batch send: each worker
+// still sends its packets one bcmbal_pkt_send() at a time.
+class PacketOutDispatcher {
+  public:
+    PacketOutDispatcher();
+
+    PacketOutDispatcher(const PacketOutDispatcher&) = delete;
+    PacketOutDispatcher& operator=(const PacketOutDispatcher&) = delete;
+
+    // Queues msg, swapping its contents out. Blocks while the queue is full.
+    void submit(PacketOutResults* results, openolt::PacketOutMsg& msg);
+
+  private:
+    struct Job {
+        PacketOutResults* results;
+        openolt::PacketOutMsg msg;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    static unsigned destination(const openolt::PacketOutMsg& msg);
+    static Status send(const openolt::PacketOutMsg& msg);
+    void run();
+
+    RingQueue<Job> queue_;
+    WorkerPool workers_;
+    std::once_flag started_;
+};
+
+extern PacketOutDispatcher pktOutDispatcher;
+
+#endif
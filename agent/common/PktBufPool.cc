@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <cstring>
+
+#include "PktBufPool.h"
+
+PktBufPool::PktBufPool(size_t count, size_t buf_size, size_t align) :
+    count_(count),
+    buf_size_((buf_size + align - 1) / align * align),
+    align_(align),
+    slab_(NULL),
+    free_(count, RING_OVERFLOW_DROP_NEWEST),
+    misses_(0) {
+    void* slab;
+
+    if (posix_memalign(&slab, align_ < sizeof(void*) ? sizeof(void*) : align_,
+                       count_ * buf_size_) != 0) {
+        count_ = 0;
+        return;
+    }
+    slab_ = (uint8_t*)slab;
+    for (size_t i = 0; i < count_; i++) {
+        free_.push(slab_ + i * buf_size_);
+    }
+}
+
+PktBufPool::~PktBufPool() {
+    free(slab_);
+}
+
+uint8_t* PktBufPool::get(size_t len) {
+    uint8_t* buf;
+
+    if (len <= buf_size_ && free_.try_pop(buf)) {
+        return buf;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    void* heap;
+    if (posix_memalign(&heap, align_ < sizeof(void*) ? sizeof(void*) : align_, len ? len : 1) != 0) {
+        return NULL;
+    }
+    return (uint8_t*)heap;
+}
+
+void PktBufPool::put(uint8_t* buf) {
+    if (owns(buf)) {
+        free_.push(buf);
+    } else {
+        free(buf);
+    }
+}
+
+PktOutData::PktOutData(PktBufPool* pool, const std::string& pkt) :
+    pool_(pool), copy_(NULL), data_(pkt.data()), size_(pkt.size()) {
+    if (pool_ == NULL || (uintptr_t)data_ % pool_->align() == 0) {
+        return;
+    }
+    copy_ = pool_->get(size_);
+    if (copy_ != NULL) {
+        memcpy(copy_, pkt.data(), size_);
+        data_ = (const char*)copy_;
+    }
+}
+
+PktOutData::~PktOutData() {
+    if (copy_ != NULL) {
+        pool_->put(copy_);
+    }
+}
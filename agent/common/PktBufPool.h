@@ -0,0 +1,80 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_PKT_BUF_POOL_H_
+#define OPENOLT_PKT_BUF_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "RingQueue.h"
+
+// Fixed size, aligned packet buffers carved from one slab. get() and put()
+// may be called from any thread.
+class PktBufPool {
+  public:
+    PktBufPool(size_t count, size_t buf_size, size_t align);
+    ~PktBufPool();
+
+    PktBufPool(const PktBufPool&) = delete;
+    PktBufPool& operator=(const PktBufPool&) = delete;
+
+    // Returns an aligned buffer of at least len bytes. Falls back to the
+    // heap when the pool is empty or len exceeds the buffer size.
+    uint8_t* get(size_t len);
+    void put(uint8_t* buf);
+
+    size_t align() const { return align_; }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+  private:
+    bool owns(const uint8_t* buf) const {
+        return buf >= slab_ && buf < slab_ + count_ * buf_size_;
+    }
+
+    size_t count_;
+    size_t buf_size_;
+    size_t align_;
+    uint8_t* slab_;
+    RingQueue<uint8_t*> free_;
+    std::atomic<uint64_t> misses_;
+};
+
+// The payload of a packet-out, as bcmbal_pkt_send() wants it. Points into
+// pkt itself unless pkt is not aligned to the pool's alignment, in which case
+// the payload is copied into a pool buffer for the lifetime of the object.
+// Without a pool pkt is always used in place.
+class PktOutData {
+  public:
+    PktOutData(PktBufPool* pool, const std::string& pkt);
+    ~PktOutData();
+
+    PktOutData(const PktOutData&) = delete;
+    PktOutData& operator=(const PktOutData&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    PktBufPool* pool_;
+    uint8_t* copy_;
+    const char* data_;
+    size_t size_;
+};
+
+#endif
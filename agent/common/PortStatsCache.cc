@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include "PortStatsCache.h"
+#include "core.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Reflection;
+
+PortStatsCache portStatsCache(STATS_SNAPSHOT_INTERVAL);
+
+// The counters are the 64 bit fields of PortStatistics, in field order
+static const std::vector<const FieldDescriptor*>& counter_fields() {
+    static std::vector<const FieldDescriptor*> fields;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        const Descriptor* desc = openolt::PortStatistics::descriptor();
+        for (int i = 0; i < desc->field_count(); i++) {
+            if (desc->field(i)->cpp_type() == FieldDescriptor::CPPTYPE_UINT64) {
+                fields.push_back(desc->field(i));
+            }
+        }
+    });
+    return fields;
+}
+
+PortStatsCache::PortStatsCache(unsigned snapshot_interval) :
+    snapshot_interval_(snapshot_interval ? snapshot_interval : 1),
+    delta_(false),
+    counters_() {
+}
+
+void PortStatsCache::reset(bool delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    delta_ = delta;
+    ports_.clear();
+}
+
+bool PortStatsCache::encode(openolt::PortStatistics* stats, bool ok) {
+    const std::vector<const FieldDescriptor*>& fields = counter_fields();
+    const Reflection* reflection = stats->GetReflection();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!delta_) {
+        return true;
+    }
+    if (!ok) {
+        counters_.suppressed++;
+        return false;
+    }
+
+    std::vector<uint64_t> now(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        now[i] = reflection->GetUInt64(*stats, fields[i]);
+    }
+
+    // A counter that went backwards was cleared, so a snapshot sets a new base
+    std::map<uint32_t, Port>::iterator it = ports_.find(stats->intf_id());
+    bool cleared = false;
+    for (size_t i = 0; it != ports_.end() && i < fields.size(); i++) {
+        cleared |= now[i] < it->second.last[i];
+    }
+    if (it == ports_.end() || cleared || ++it->second.since_snapshot >= snapshot_interval_) {
+        Port& port = ports_[stats->intf_id()];
+        port.last.swap(now);
+        port.since_snapshot = 0;
+        counters_.snapshots++;
+        return true;
+    }
+
+    Port& port = it->second;
+    if (now == port.last) {
+        counters_.suppressed++;
+        return false;
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        reflection->SetUInt64(stats, fields[i], now[i] - port.last[i]);
+    }
+    stats->set_delta(true);
+    port.last.swap(now);
+    counters_.deltas++;
+    return true;
+}
+
+void PortStatsCache::get_counters(port_stats_cache_counters* counters) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *counters = counters_;
+}
+
+std::string PortStatsCache::counters_to_str() const {
+    port_stats_cache_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "snapshots " << c.snapshots << " deltas " << c.deltas << " suppressed " << c.suppressed;
+    return out.str();
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_PORT_STATS_CACHE_H_
+#define OPENOLT_PORT_STATS_CACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <openolt.grpc.pb.h>
+
+struct port_stats_cache_counters {
+    uint64_t snapshots;
+    uint64_t deltas;
+    uint64_t suppressed;
+};
+
+// Last PortStatistics counters sent per port, for streams that asked for
+// stats_delta. In delta mode encode() rewrites each reading into the
+// increments since the previous one sent, and suppresses readings that
+// changed nothing. Every snapshot_interval readings of a port, the full
+// counters go out instead.
+class PortStatsCache {
+  public:
+    explicit PortStatsCache(unsigned snapshot_interval);
+
+    PortStatsCache(const PortStatsCache&) = delete;
+    PortStatsCache& operator=(const PortStatsCache&) = delete;
+
+    // Forgets every port and sets the mode of the stream that follows
+    void reset(bool delta);
+
+    // Prepares stats for sending. Returns false if it must not be sent:
+    // nothing changed, or the read failed (ok unset) in delta mode.
+    bool encode(openolt::PortStatistics* stats, bool ok);
+
+    void get_counters(port_stats_cache_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    struct Port {
+        std::vector<uint64_t> last;
+        unsigned since_snapshot;
+    };
+
+    unsigned snapshot_interval_;
+    mutable std::mutex mutex_;
+    bool delta_;
+    std::map<uint32_t, Port> ports_;
+    port_stats_cache_counters counters_;
+};
+
+extern PortStatsCache portStatsCache;
+
+#endif
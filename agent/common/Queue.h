@@ -18,22 +18,17 @@ class Queue
 {
  public:
 
+  // Waits up to timeout seconds for an item
   std::pair<T, bool> pop(int timeout)
   {
-    std::cv_status status = std::cv_status::no_timeout;
     std::unique_lock<std::mutex> mlock(mutex_);
-    static int duration = 0;
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
     while (queue_.empty())
     {
-      status = cond_.wait_for(mlock, std::chrono::seconds(1));
-      if (status == std::cv_status::timeout)
+      if (cond_.wait_until(mlock, deadline) == std::cv_status::timeout && queue_.empty())
       {
-        duration++;
-        if (duration > timeout)
-        {
-          duration = 0;
-          return std::pair<T, bool>({}, false);
-        }
+        return std::pair<T, bool>({}, false);
       }
     }
     auto val = queue_.front();
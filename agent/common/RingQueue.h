@@ -0,0 +1,276 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_RING_QUEUE_H_
+#define OPENOLT_RING_QUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#define RING_CACHE_LINE 64
+
+// Times a producer blocked on a full ring yields before it sleeps; a ring
+// drained as fast as it fills seldom stays full for longer
+#define RING_BLOCK_SPINS 64
+
+// What push() does when the ring is full.
+enum ring_overflow_policy {
+    RING_OVERFLOW_DROP_NEWEST,  // reject the item being pushed
+    RING_OVERFLOW_DROP_OLDEST,  // evict the item at the head, then push
+    RING_OVERFLOW_BLOCK,        // wait until the consumer makes room
+};
+
+// Lets a consumer sleep until a lock-free producer has published something.
+// Producers only touch the mutex when somebody is actually waiting, so the
+// uncontended push path stays lock-free.
+class RingNotifier {
+  public:
+    void notify() {
+        // Pairs with the increment of waiters_ in wait_until(): either the
+        // waiter sees the published item, or we see the waiter.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_all();
+        }
+    }
+
+    // Blocks until ready() returns true or the deadline passes. Returns the
+    // last value of ready().
+    template <typename Pred>
+    bool wait_until(std::chrono::steady_clock::time_point deadline, Pred ready) {
+        if (ready()) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        bool ok;
+        while (!(ok = ready())) {
+            if (cond_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                ok = ready();
+                break;
+            }
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    template <typename Pred>
+    void wait(Pred ready) {
+        if (ready()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        while (!ready()) {
+            cond_.wait(lock);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+// Bounded lock-free multi-producer ring (D. Vyukov's sequenced-cell design).
+// Each cell carries a sequence number that tells producers and consumers
+// whether it is free or holds data for the current lap, so neither side
+// ever takes a lock. The dequeue side is CAS based as well, which is what
+// lets a producer evict the oldest entry under RING_OVERFLOW_DROP_OLDEST.
+//
+// The blocking pop() calls keep the interface of Queue<T> so the ring can be
+// used as a drop-in replacement on the indication path.
+template <typename T>
+class RingQueue {
+  public:
+    explicit RingQueue(size_t capacity = 4096,
+                       ring_overflow_policy policy = RING_OVERFLOW_DROP_OLDEST)
+        : mask_(round_up_pow2(capacity) - 1),
+          policy_(policy),
+          cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    ~RingQueue() {
+        delete[] cells_;
+    }
+
+    RingQueue(const RingQueue&) = delete;            // disable copying
+    RingQueue& operator=(const RingQueue&) = delete; // disable assignment
+
+    // Returns false if the item was dropped because of the overflow policy.
+    bool push(const T& item) {
+        T copy(item);
+        return push(std::move(copy));
+    }
+
+    bool push(T&& item) {
+        bool pushed = enqueue(item);
+        unsigned spins = 0;
+        while (!pushed) {
+            if (policy_ == RING_OVERFLOW_DROP_NEWEST) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (policy_ == RING_OVERFLOW_DROP_OLDEST) {
+                T evicted;
+                if (dequeue(evicted)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                pushed = enqueue(item);
+            } else if (++spins < RING_BLOCK_SPINS) {
+                std::this_thread::yield();
+                pushed = enqueue(item);
+            } else {
+                space_.wait([&]() { return enqueue(item); });
+                pushed = true;
+            }
+        }
+        notifier_.notify();
+        return true;
+    }
+
+    // Non-blocking push that ignores the overflow policy.
+    bool try_push(T&& item) {
+        if (!enqueue(item)) {
+            return false;
+        }
+        notifier_.notify();
+        return true;
+    }
+
+    bool try_pop(T& item) {
+        return dequeue(item);
+    }
+
+    // Waits up to timeout seconds for an item.
+    std::pair<T, bool> pop(int timeout) {
+        std::pair<T, bool> ret({}, false);
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+        ret.second = notifier_.wait_until(deadline, [&]() { return dequeue(ret.first); });
+        return ret;
+    }
+
+    void pop(T& item) {
+        notifier_.wait([&]() { return dequeue(item); });
+    }
+
+    // Approximate number of queued items; exact only when quiescent.
+    size_t size() const {
+        size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // Moves from item only on success.
+    bool enqueue(T& item) {
+        Cell* cell;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool dequeue(T& item) {
+        Cell* cell;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->data = T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        if (policy_ == RING_OVERFLOW_BLOCK) {
+            space_.notify();
+        }
+        return true;
+    }
+
+    const size_t mask_;
+    const ring_overflow_policy policy_;
+    Cell* const cells_;
+    char pad0_[RING_CACHE_LINE];
+    std::atomic<size_t> enqueue_pos_;
+    char pad1_[RING_CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeue_pos_;
+    char pad2_[RING_CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<uint64_t> dropped_{0};
+    RingNotifier notifier_;
+    RingNotifier space_;    // producers blocked on a full ring
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <sstream>
+
+#include "Scheduler.h"
+
+Scheduler scheduler;
+
+static uint64_t to_us(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+Scheduler::Scheduler() : next_id_(1), stopping_(false) {
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+unsigned Scheduler::add(const std::string& name, std::chrono::milliseconds period,
+                        const std::function<void()>& fn) {
+    std::call_once(started_, [this]() { thread_ = std::thread(&Scheduler::run, this); });
+
+    unsigned id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        Task& task = tasks_[id];
+        task.name = name;
+        task.period = std::max(period, std::chrono::milliseconds(1));
+        task.fn = fn;
+        task.counters = sched_task_counters();
+        deadlines_.push(Deadline(std::chrono::steady_clock::now() + task.period, id));
+    }
+    cv_.notify_one();
+    return id;
+}
+
+// The task's deadline stays in the heap and is dropped when it comes up
+void Scheduler::cancel(unsigned id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.erase(id);
+}
+
+void Scheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (deadlines_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        Deadline next = deadlines_.top();
+        if (cv_.wait_until(lock, next.first) == std::cv_status::no_timeout) {
+            // Woken by add() or the destructor, look again
+            continue;
+        }
+        deadlines_.pop();
+
+        std::map<unsigned, Task>::iterator it = tasks_.find(next.second);
+        if (it == tasks_.end()) {
+            continue;
+        }
+        std::function<void()> fn = it->second.fn;
+
+        lock.unlock();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        lock.lock();
+
+        // Cancelled while running
+        it = tasks_.find(next.second);
+        if (it == tasks_.end()) {
+            continue;
+        }
+        Task& task = it->second;
+        sched_task_counters& c = task.counters;
+        c.runs++;
+        c.jitter_us_last = to_us(start - next.first);
+        c.jitter_us_max = std::max(c.jitter_us_max, c.jitter_us_last);
+        c.run_us_last = to_us(end - start);
+        c.run_us_max = std::max(c.run_us_max, c.run_us_last);
+
+        std::chrono::steady_clock::time_point deadline = next.first + task.period;
+        if (deadline <= end) {
+            c.overruns++;
+            while (deadline <= end) {
+                deadline += task.period;
+                c.skipped++;
+            }
+        }
+        deadlines_.push(Deadline(deadline, next.second));
+    }
+}
+
+bool Scheduler::get_counters(const std::string& name, sched_task_counters* counters) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::map<unsigned, Task>::const_iterator it = tasks_.begin(); it != tasks_.end(); ++it) {
+        if (it->second.name == name) {
+            *counters = it->second.counters;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Scheduler::counters_to_str() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (std::map<unsigned, Task>::const_iterator it = tasks_.begin(); it != tasks_.end(); ++it) {
+        const sched_task_counters& c = it->second.counters;
+        out << (it == tasks_.begin() ? "" : " ") << it->second.name
+            << " [runs " << c.runs
+            << " overruns " << c.overruns
+            << " skipped " << c.skipped
+            << " jitter_us " << c.jitter_us_last << "/" << c.jitter_us_max
+            << " run_us " << c.run_us_last << "/" << c.run_us_max << "]";
+    }
+    return out.str();
+}
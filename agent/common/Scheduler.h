@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_SCHEDULER_H_
+#define OPENOLT_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct sched_task_counters {
+    uint64_t runs;
+    uint64_t overruns;          // runs that ended past the task's next deadline
+    uint64_t skipped;           // deadlines dropped to catch up after an overrun
+    uint64_t jitter_us_last;    // how late a run started
+    uint64_t jitter_us_max;
+    uint64_t run_us_last;
+    uint64_t run_us_max;
+};
+
+// Runs the agent's periodic tasks from a single thread, in deadline order
+// off a min-heap. Deadlines are on the steady clock and advance by whole
+// periods, so a task keeps its phase however late one run starts; after an
+// overrun the missed deadlines are skipped rather than run back to back.
+// Tasks must be short, anything long belongs on a thread of its own. The
+// thread starts with the first task.
+class Scheduler {
+  public:
+    Scheduler();
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Runs fn every period, the first time one period from now. Returns an
+    // id for cancel().
+    unsigned add(const std::string& name, std::chrono::milliseconds period,
+                 const std::function<void()>& fn);
+    void cancel(unsigned id);
+
+    bool get_counters(const std::string& name, sched_task_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    struct Task {
+        std::string name;
+        std::chrono::steady_clock::duration period;
+        std::function<void()> fn;
+        sched_task_counters counters;
+    };
+
+    typedef std::pair<std::chrono::steady_clock::time_point, unsigned> Deadline;
+
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > deadlines_;
+    std::map<unsigned, Task> tasks_;
+    unsigned next_id_;
+    bool stopping_;
+    std::once_flag started_;
+    std::thread thread_;
+};
+
+// Periodic tasks of the agent
+extern Scheduler scheduler;
+
+#endif
@@ -0,0 +1,177 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "StatsCollector.h"
+#include "IndicationQueue.h"
+#include "PortStatsCache.h"
+
+extern IndicationQueue oltIndQ;
+
+StatsCollector::StatsCollector(unsigned workers, unsigned deadline_ms,
+                               const PortsFn& ports, const CollectFn& collect) :
+    workers_(workers ? workers : 1),
+    deadline_(deadline_ms),
+    ports_(ports),
+    collect_(collect),
+    triggered_(false),
+    round_(0),
+    last_round_(0),
+    pending_(0) {
+}
+
+void StatsCollector::start() {
+    std::thread(&StatsCollector::run, this).detach();
+    for (unsigned i = 0; i < workers_; i++) {
+        std::thread(&StatsCollector::serve, this).detach();
+    }
+}
+
+void StatsCollector::trigger() {
+    std::call_once(started_, &StatsCollector::start, this);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        triggered_ = true;
+    }
+    trigger_cv_.notify_one();
+}
+
+void StatsCollector::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        trigger_cv_.wait(lock, [this]() { return triggered_; });
+        triggered_ = false;
+
+        lock.unlock();
+        std::vector<StatsPort> ports = ports_();
+        lock.lock();
+
+        if (!ports.empty()) {
+            run_round(lock, ports);
+        }
+    }
+}
+
+void StatsCollector::run_round(std::unique_lock<std::mutex>& lock,
+                               const std::vector<StatsPort>& ports) {
+    round_ = ++last_round_;
+    pending_ = 0;
+    for (size_t i = 0; i < ports.size(); i++) {
+        PortState& port = ports_state_[ports[i].name];
+        if (port.busy) {
+            port.timing.skipped++;
+            continue;
+        }
+        port.busy = true;
+        jobs_.push_back(Job());
+        jobs_.back().port = ports[i];
+        jobs_.back().round = round_;
+        pending_++;
+    }
+    work_cv_.notify_all();
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + deadline_;
+    if (!done_cv_.wait_until(lock, deadline, [this]() { return pending_ == 0; })) {
+        // Reads not started yet are dropped; running ones complete as late
+        size_t late = pending_;
+        while (!jobs_.empty()) {
+            PortState& port = ports_state_[jobs_.front().port.name];
+            port.busy = false;
+            port.timing.late++;
+            jobs_.pop_front();
+        }
+        std::cout << "Statistics round " << round_ << ": " << late << " of "
+                  << ports.size() << " ports missed the " << deadline_.count()
+                  << " ms deadline" << std::endl;
+    }
+    round_ = 0;
+}
+
+void StatsCollector::serve() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this]() { return !jobs_.empty(); });
+            job = jobs_.front();
+            jobs_.pop_front();
+        }
+
+        IndicationPtr ind = oltIndQ.get(openolt::Indication::kPortStats);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool ok = collect_(job.port, ind->mutable_port_stats());
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        bool publish;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            PortState& port = ports_state_[job.port.name];
+            port.busy = false;
+            port.timing.reads++;
+            port.timing.errors += ok ? 0 : 1;
+            port.timing.last_us = us;
+            port.timing.max_us = std::max(port.timing.max_us, us);
+            port.timing.total_us += us;
+
+            publish = job.round == round_;
+            if (publish) {
+                if (--pending_ == 0) {
+                    done_cv_.notify_one();
+                }
+            } else {
+                port.timing.late++;
+            }
+        }
+
+        if (publish && portStatsCache.encode(ind->mutable_port_stats(), ok)) {
+            oltIndQ.push(std::move(ind));
+        }
+    }
+}
+
+bool StatsCollector::get_timing(const std::string& name, stats_port_timing* timing) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, PortState>::const_iterator it = ports_state_.find(name);
+    if (it == ports_state_.end()) {
+        return false;
+    }
+    *timing = it->second.timing;
+    return true;
+}
+
+std::string StatsCollector::timing_to_str() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (std::map<std::string, PortState>::const_iterator it = ports_state_.begin();
+         it != ports_state_.end(); ++it) {
+        const stats_port_timing& t = it->second.timing;
+        out << (it == ports_state_.begin() ? "" : " ") << it->first
+            << " [reads " << t.reads
+            << " errors " << t.errors
+            << " late " << t.late
+            << " skipped " << t.skipped
+            << " last_us " << t.last_us
+            << " max_us " << t.max_us
+            << " avg_us " << (t.reads ? t.total_us / t.reads : 0) << "]";
+    }
+    return out.str();
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_STATS_COLLECTOR_H_
+#define OPENOLT_STATS_COLLECTOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <openolt.grpc.pb.h>
+
+// A port to read statistics from. kind and intf_id are the caller's, name
+// labels the port in the timing report.
+struct StatsPort {
+    int kind;
+    uint32_t intf_id;
+    std::string name;
+};
+
+// Collection cost of one port
+struct stats_port_timing {
+    uint64_t reads;     // completed reads
+    uint64_t errors;    // failed reads
+    uint64_t late;      // reads that missed their round's deadline
+    uint64_t skipped;   // rounds the port sat out, its previous read still running
+    uint64_t last_us;
+    uint64_t max_us;
+    uint64_t total_us;
+};
+
+// Collects port statistics off the indication path. Each trigger() starts
+// a round: the ports are read in parallel on the collector's worker
+// threads and each result is pushed to oltIndQ as it arrives, delta encoded
+// through portStatsCache when the stream asked for it. Results that
+// miss the round deadline are dropped and counted as late; a port whose
+// read is still running sits out the next round. Threads start on the
+// first trigger().
+class StatsCollector {
+  public:
+    // ports() lists the ports of a round. collect() reads one port into
+    // stats, which is the statistics to publish, and returns false if the
+    // read failed.
+    typedef std::function<std::vector<StatsPort>()> PortsFn;
+    typedef std::function<bool(const StatsPort&, openolt::PortStatistics* stats)> CollectFn;
+
+    StatsCollector(unsigned workers, unsigned deadline_ms,
+                   const PortsFn& ports, const CollectFn& collect);
+
+    StatsCollector(const StatsCollector&) = delete;
+    StatsCollector& operator=(const StatsCollector&) = delete;
+
+    // Starts a round now, or right after the running one, without waiting
+    void trigger();
+
+    bool get_timing(const std::string& name, stats_port_timing* timing) const;
+    std::string timing_to_str() const;
+
+  private:
+    struct Job {
+        StatsPort port;
+        uint64_t round;
+    };
+
+    struct PortState {
+        stats_port_timing timing;
+        bool busy;
+    };
+
+    void start();
+    void run();
+    void run_round(std::unique_lock<std::mutex>& lock, const std::vector<StatsPort>& ports);
+    void serve();
+
+    unsigned workers_;
+    std::chrono::milliseconds deadline_;
+    PortsFn ports_;
+    CollectFn collect_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable trigger_cv_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::once_flag started_;
+    bool triggered_;
+    std::deque<Job> jobs_;
+    uint64_t round_;        // round taking results, 0 if none
+    uint64_t last_round_;
+    size_t pending_;        // reads of round_ not completed yet
+    std::map<std::string, PortState> ports_state_;
+};
+
+#endif
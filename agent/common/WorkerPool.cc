@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WorkerPool.h"
+
+// Completion of one run() call
+struct WorkerPool::Run {
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending;
+};
+
+WorkerPool::WorkerPool(unsigned workers) : stopping_(false) {
+    for (unsigned i = 0; i < (workers ? workers : 1); i++) {
+        workers_.push_back(new Worker);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    for (size_t i = 0; i < workers_.size(); i++) {
+        {
+            std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+            stopping_ = true;
+        }
+        workers_[i]->cv.notify_one();
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        if (workers_[i]->thread.joinable()) {
+            workers_[i]->thread.join();
+        }
+        delete workers_[i];
+    }
+}
+
+void WorkerPool::start() {
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread = std::thread(&WorkerPool::serve, this, workers_[i]);
+    }
+}
+
+void WorkerPool::run(size_t n, const std::function<unsigned(size_t)>& shard,
+                     const std::function<void(size_t)>& work) {
+    std::call_once(started_, &WorkerPool::start, this);
+
+    std::vector<std::vector<size_t> > items(workers_.size());
+    for (size_t i = 0; i < n; i++) {
+        items[shard(i) % workers_.size()].push_back(i);
+    }
+
+    Run run;
+    run.pending = 0;
+    for (size_t w = 0; w < items.size(); w++) {
+        run.pending += items[w].empty() ? 0 : 1;
+    }
+    if (run.pending == 0) {
+        return;
+    }
+
+    for (size_t w = 0; w < items.size(); w++) {
+        if (items[w].empty()) {
+            continue;
+        }
+        Worker* worker = workers_[w];
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->tasks.push_back(Task());
+            worker->tasks.back().work = &work;
+            worker->tasks.back().items.swap(items[w]);
+            worker->tasks.back().run = &run;
+        }
+        worker->cv.notify_one();
+    }
+
+    std::unique_lock<std::mutex> lock(run.mutex);
+    run.done.wait(lock, [&run]() { return run.pending == 0; });
+}
+
+void WorkerPool::serve(Worker* worker) {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->cv.wait(lock, [this, worker]() { return stopping_ || !worker->tasks.empty(); });
+            if (worker->tasks.empty()) {
+                return;
+            }
+            task.work = worker->tasks.front().work;
+            task.items.swap(worker->tasks.front().items);
+            task.run = worker->tasks.front().run;
+            worker->tasks.pop_front();
+        }
+
+        for (size_t i = 0; i < task.items.size(); i++) {
+            (*task.work)(task.items[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(task.run->mutex);
+        if (--task.run->pending == 0) {
+            task.run->done.notify_one();
+        }
+    }
+}
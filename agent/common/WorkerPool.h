@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_WORKER_POOL_H_
+#define OPENOLT_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for work that is partitioned by a shard key,
+// typically an interface id. Shard s always runs on worker s % workers, so
+// the items of one shard never run concurrently and keep their order, even
+// across run() calls from different threads. Threads start on first use.
+class WorkerPool {
+  public:
+    explicit WorkerPool(unsigned workers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Runs work(i) for every i in [0, n) on the worker of shard(i) and
+    // returns once all of them have run.
+    void run(size_t n, const std::function<unsigned(size_t)>& shard,
+             const std::function<void(size_t)>& work);
+
+    unsigned size() const { return workers_.size(); }
+
+  private:
+    struct Run;
+
+    // The part of one run() call that falls on a single worker
+    struct Task {
+        const std::function<void(size_t)>* work;
+        std::vector<size_t> items;
+        Run* run;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void start();
+    void serve(Worker* worker);
+
+    std::vector<Worker*> workers_;
+    std::once_flag started_;
+    bool stopping_;
+};
+
+#endif
@@ -24,7 +24,111 @@ using grpc::Status;
 
 #include "state.h"
 
+// Port statistics are collected every COLLECTION_PERIOD seconds on
+// STATS_WORKERS threads. Ports not read within STATS_DEADLINE_MS of the
+// start of a round are left out of it.
 #define COLLECTION_PERIOD 15
+#define STATS_WORKERS 4
+#define STATS_DEADLINE_MS 5000
+
+// On streams with stats_delta set, the full counters of a port are sent
+// every STATS_SNAPSHOT_INTERVAL readings, deltas in between.
+#define STATS_SNAPSHOT_INTERVAL 8
+
+// Flow statistics are read in slices, one every FLOW_STATS_PERIOD_MS: at
+// most FLOW_STATS_SLICE flows out of the next FLOW_STATS_SCAN flow entries
+// (two per flow id, one per direction).
+#define FLOW_STATS_PERIOD_MS 1000
+#define FLOW_STATS_SLICE 256
+#define FLOW_STATS_SCAN 4096
+
+// Seconds between logs of the indication queue, periodic task and port
+// statistics counters
+#define HOUSEKEEPING_PERIOD 300
+
+// Max indications EnableIndication takes from oltIndQ per write cycle. All
+// but the last write of a cycle are corked; 1 restores one flush per write.
+#ifndef INDICATION_BATCH_SIZE
+#define INDICATION_BATCH_SIZE 64
+#endif
+
+// BAL indications are handled on INDICATION_SHARDS worker threads, each
+// taking the PON interfaces whose id modulo INDICATION_SHARDS is its
+// number, with room for INDICATION_SHARD_DEPTH packet-ins waiting and as
+// many other indications before they spill to the heap. The BAL callbacks
+// only copy the indication to its shard.
+#ifndef INDICATION_SHARDS
+#define INDICATION_SHARDS 4
+#endif
+#define INDICATION_SHARD_DEPTH 4096
+
+// Indications written to Voltha are kept in a ring of INDICATION_JOURNAL_SIZE
+// bytes mapped from INDICATION_JOURNAL_PATH, for replay to a reconnecting
+// adapter. An empty path keeps the journal in memory, lost on restart.
+#ifndef INDICATION_JOURNAL_PATH
+#define INDICATION_JOURNAL_PATH "/var/run/openolt_indications.journal"
+#endif
+#define INDICATION_JOURNAL_SIZE (16 << 20)
+
+// Packet-out payloads go to bcmbal_pkt_send() straight from the gRPC
+// request. Payloads not aligned to PKT_OUT_ALIGN bytes are first copied into
+// one of PKT_OUT_POOL_SIZE buffers of PKT_OUT_MAX_LENGTH bytes; the default
+// alignment of 1 never copies and allocates no buffers.
+#define PKT_OUT_ALIGN 1
+#define PKT_OUT_POOL_SIZE 64
+#define PKT_OUT_MAX_LENGTH 2048
+
+// PacketOut stream packets waiting for the dispatcher, the most it takes at
+// a time, and the workers it spreads them over by destination interface.
+#define PKT_OUT_QUEUE_DEPTH 4096
+#define PKT_OUT_BATCH_SIZE 32
+#define PKT_OUT_WORKERS 8
+
+// Worker threads submitting FlowAddBatch/FlowRemoveBatch flows to BAL. The
+// flows of an access interface always go through the same worker.
+#define FLOW_WORKERS 4
+
+// Flow ids run from 1 to FLOW_ID_MAX and index the flow state directly.
+// The logical port tables of the flow state have FLOW_TABLE_SLOTS slots.
+#define FLOW_ID_MAX 16383
+#define FLOW_TABLE_SLOTS 32768
+
+// gRPC server model. With ASYNC_SERVER set, RPCs are served from
+// SERVER_CQ_THREADS completion queues, each polled by its own thread, and
+// their handlers on SERVER_HANDLER_THREADS threads, as many as there may be
+// RPCs blocked on BAL at once. When SERVER_CQ_FIRST_CORE is not negative,
+// polling thread i is pinned to core (SERVER_CQ_FIRST_CORE + i) modulo the
+// number of online cores. Setting ASYNC_SERVER to 0 brings back the
+// synchronous server.
+#ifndef ASYNC_SERVER
+#define ASYNC_SERVER 1
+#endif
+#ifndef SERVER_CQ_THREADS
+#define SERVER_CQ_THREADS 2
+#endif
+#ifndef SERVER_HANDLER_THREADS
+#define SERVER_HANDLER_THREADS 16
+#endif
+#ifndef SERVER_CQ_FIRST_CORE
+#define SERVER_CQ_FIRST_CORE 0
+#endif
+
+// Latency histograms and counters are served by the GetMetrics RPC. When
+// METRICS_TEXT_ADDRESS is set, e.g. to "127.0.0.1:9192", they are also
+// served as plain text over HTTP there, for curl and scrapers.
+#ifndef METRICS_TEXT_ADDRESS
+#define METRICS_TEXT_ADDRESS ""
+#endif
+
+// ONU activations are traced for PONs and onu_ids below these, into a ring
+// of ONU_TRACE_RING_SIZE events shared by all ONUs. At most
+// ONU_TRACE_PENDING_MAX discovered ONUs wait for activation at a time, for
+// up to ONU_TRACE_PENDING_MAX_AGE seconds.
+#define ONU_TRACE_PONS 16
+#define ONU_TRACE_ONUS 256
+#define ONU_TRACE_RING_SIZE 65536
+#define ONU_TRACE_PENDING_MAX 4096
+#define ONU_TRACE_PENDING_MAX_AGE 600
 
 extern State state;
 
@@ -41,17 +145,19 @@ Status EnableUplinkIf_(uint32_t intf_id);
 Status DisableUplinkIf_(uint32_t intf_id);
 unsigned NumNniIf_();
 unsigned NumPonIf_();
-Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string pkt);
-Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string pkt);
+Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string& pkt, bool raw);
+Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string& pkt);
 Status ProbeDeviceCapabilities_();
 Status ProbePonIfTechnology_();
-Status UplinkPacketOut_(uint32_t intf_id, const std::string pkt);
+Status UplinkPacketOut_(uint32_t intf_id, const std::string& pkt);
 Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t port_no,
                 uint32_t flow_id, const std::string flow_type,
                 int32_t alloc_id, int32_t network_intf_id,
                 int32_t gemport_id, const ::openolt::Classifier& classifier,
                 const ::openolt::Action& action, int32_t priority_value, uint64_t cookie);
 Status FlowRemove_(uint32_t flow_id, const std::string flow_type);
+Status FlowAddBatch_(const openolt::Flows* flows, openolt::FlowResults* results);
+Status FlowRemoveBatch_(const openolt::Flows* flows, openolt::FlowResults* results);
 Status Disable_();
 Status Reenable_();
 Status GetDeviceInfo_(openolt::DeviceInfo* device_info);
@@ -60,4 +166,5 @@ Status RemoveTconts_(const openolt::Tconts *tconts);
 uint32_t GetPortNum_(uint32_t flow_id);
 
 void stats_collection();
+void flow_stats_sweep();
 #endif
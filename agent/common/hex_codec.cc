@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hex_codec.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Digit value of every character, -1 for non hex digits
+struct HexTable {
+    int8_t value[256];
+
+    HexTable() {
+        for (int c = 0; c < 256; c++) {
+            value[c] = -1;
+        }
+        for (int c = '0'; c <= '9'; c++) {
+            value[c] = c - '0';
+        }
+        for (int c = 'a'; c <= 'f'; c++) {
+            value[c] = c - 'a' + 10;
+            value[c - 'a' + 'A'] = c - 'a' + 10;
+        }
+    }
+};
+
+static const HexTable hex_table;
+static const char hex_digits[] = "0123456789abcdef";
+
+bool hex_decode_scalar(const char* in, size_t len, uint8_t* out) {
+    const int8_t* value = hex_table.value;
+
+    for (size_t i = 0; i < len; i++) {
+        int hi = value[(uint8_t)in[2 * i]];
+        int lo = value[(uint8_t)in[2 * i + 1]];
+        if ((hi | lo) < 0) {
+            return false;
+        }
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+#ifdef __SSE2__
+// Digit values of 16 characters. Clears *valid if any of them is not a hex
+// digit. Bytes >= 0x80 compare negative and so fail both range checks.
+static inline __m128i hex_values(__m128i c, int* valid) {
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                     _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    // Setting bit 5 folds A-F onto a-f and maps nothing else into a-f
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                     _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff) {
+        *valid = 0;
+    }
+    return _mm_or_si128(
+        _mm_and_si128(is_digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+        _mm_and_si128(is_alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+// Folds the 16 digit values into 8 bytes, one per 16 bit lane: the even
+// (first) digit is the high nibble.
+static inline __m128i hex_pairs(__m128i v) {
+    __m128i hi = _mm_and_si128(v, _mm_set1_epi16(0x00ff));
+    __m128i lo = _mm_srli_epi16(v, 8);
+    return _mm_or_si128(_mm_slli_epi16(hi, 4), lo);
+}
+#endif
+
+bool hex_decode(const char* in, size_t len, uint8_t* out) {
+    size_t i = 0;
+
+#ifdef __SSE2__
+    int valid = 1;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v0 = hex_values(_mm_loadu_si128((const __m128i*)(in + 2 * i)), &valid);
+        __m128i v1 = hex_values(_mm_loadu_si128((const __m128i*)(in + 2 * i + 16)), &valid);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(hex_pairs(v0), hex_pairs(v1)));
+    }
+    if (!valid) {
+        return false;
+    }
+#endif
+    return hex_decode_scalar(in + 2 * i, len - i, out + i);
+}
+
+void hex_encode(const uint8_t* in, size_t len, char* out) {
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = hex_digits[in[i] >> 4];
+        out[2 * i + 1] = hex_digits[in[i] & 0x0f];
+    }
+}
@@ -0,0 +1,36 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_HEX_CODEC_H_
+#define OPENOLT_HEX_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Decodes len bytes from the 2 * len hex digits at in (either case) into out.
+// Returns false on a non hex digit; out is then partially written. Uses
+// SSE2 when the build targets it.
+bool hex_decode(const char* in, size_t len, uint8_t* out);
+
+// Lookup table only, for targets without SSE2 and for comparison
+bool hex_decode_scalar(const char* in, size_t len, uint8_t* out);
+
+// Encodes len bytes from in as 2 * len lower case hex digits at out. No
+// terminating NUL is written.
+void hex_encode(const uint8_t* in, size_t len, char* out);
+
+#endif
@@ -19,9 +19,13 @@
 
 #include "server.h"
 #include "core.h"
+#include "IndicationBus.h"
 
 int main(int argc, char** argv) {
 
+    // Indications are journaled from the first, Voltha connected or not
+    indBus.start();
+
     Status status = Enable_(argc, argv);
     if (!status.ok()) {
         std::cout << "ERROR: Enable_ failed - "
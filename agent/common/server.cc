@@ -18,10 +18,26 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <time.h>
 #include <pthread.h>
-
-#include "Queue.h"
+#include <unistd.h>
+
+#include "IndicationBus.h"
+#include "IndicationShards.h"
+#include "IndicationQueue.h"
+#include "Metrics.h"
+#include "OnuTracer.h"
+#include "FastLog.h"
+#include "PacketOutDispatcher.h"
+#include "Scheduler.h"
+#include "PortStatsCache.h"
 #include <iostream>
 #include <sstream>
 
@@ -31,17 +47,212 @@
 
 #include <grpc++/grpc++.h>
 #include <openolt.grpc.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
 using grpc::ServerWriter;
 using grpc::Status;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
 
 const char *serverPort = "0.0.0.0:9191";
 int signature;
 
-Queue<openolt::Indication> oltIndQ;
+// Producers serialize indications in push(), the bus journals the bytes
+IndicationQueue oltIndQ(true);
+IndicationJournal indJournal(INDICATION_JOURNAL_PATH, INDICATION_JOURNAL_SIZE);
+IndicationBus indBus(oltIndQ, indJournal);
+IndicationShards indShards(INDICATION_SHARDS, INDICATION_SHARD_DEPTH);
+
+// Port statistics go out as deltas only while every stream asked for them.
+// Deltas journaled before a stream that did not ask connected are passed
+// over by it, live or replayed.
+static std::mutex statsModeMutex;
+static int fullStatsStreams = 0;
+
+// Writes journaled indications to a sync stream
+class SyncIndicationWriter {
+  public:
+    explicit SyncIndicationWriter(ServerWriter<openolt::Indication>* writer) : writer_(writer) {}
+
+    bool Write(const JournalRecord& rec, grpc::WriteOptions options) {
+        if (!ind_.ParseFromString(rec.data)) {
+            return true;    // skipped, the rest may still be good
+        }
+        ind_.set_seq(rec.seq);
+        return writer_->Write(ind_, options);
+    }
+
+  private:
+    ServerWriter<openolt::Indication>* writer_;
+    openolt::Indication ind_;
+};
+
+// The subscription filter: a bit per Indication data field named in the
+// request, 0 for all
+static uint64_t indication_kinds(const openolt::IndicationRequest* request) {
+    uint64_t kinds = 0;
+
+    for (int i = 0; i < request->types_size(); i++) {
+        const google::protobuf::FieldDescriptor* field =
+            openolt::Indication::descriptor()->FindFieldByName(request->types(i));
+        if (field == NULL || field->containing_oneof() == NULL || field->number() >= 64) {
+            std::cout << "Unknown indication type " << request->types(i) << std::endl;
+            continue;
+        }
+        kinds |= 1ULL << field->number();
+    }
+    return kinds;
+}
+
+// Streams the indications on indBus to a connected Voltha until the
+// connection is lost, starting after the sequence number the request asks
+// to resume from. Any number of streams may run at once, each with its own
+// position and filter. Writer is either SyncIndicationWriter or the async
+// IndicationCall; both block in Write() until the message is handed to the
+// transport.
+template <typename Writer>
+static Status StreamIndications(Writer* writer, const openolt::IndicationRequest* request) {
+
+    std::cout << "Connection to Voltha established. Indications enabled"
+    << std::endl;
+
+    uint64_t kinds = indication_kinds(request);
+
+    // Reconciliation / recovery: an extra OLT indication of the current
+    // state, written to this stream alone ahead of the journal, seq 0 as it
+    // is not journaled
+    JournalRecord extra;
+    extra.seq = 0;
+    if (state.previsouly_connected()) {
+        std::cout << "Reconciliation / Recovery case" << std::endl;
+        if (state.is_activated() &&
+            (kinds == 0 || (kinds & (1ULL << openolt::Indication::kOltInd)))) {
+            openolt::Indication ind;
+            ind.mutable_olt_ind()->set_oper_state("up");
+            std::cout << "Extra OLT indication up" << std::endl;
+            extra.kind = openolt::Indication::kOltInd;
+            ind.SerializeToString(&extra.data);
+        }
+    }
+
+    static const int streams = metrics.counter("rpc.EnableIndication.streams");
+    metrics.add(streams);
+
+    IndicationSubscriber subscriber(indBus, request->resume_seq(), kinds,
+                                    request->stats_delta());
+    state.connect();
+    {
+        std::lock_guard<std::mutex> lock(statsModeMutex);
+        if (!request->stats_delta()) {
+            fullStatsStreams++;
+        }
+        portStatsCache.reset(fullStatsStreams == 0);
+    }
+    // Fresh port statistics for the new connection, the scheduler keeps
+    // them coming every COLLECTION_PERIOD from then on
+    stats_collection();
+
+    std::vector<JournalRecord> batch;
+    bool first = true;
+    bool isConnected = true;
+
+    if (!extra.data.empty()) {
+        isConnected = writer->Write(extra, grpc::WriteOptions());
+        first = false;
+    }
+
+    while (isConnected) {
+        size_t n = subscriber.next(batch, INDICATION_BATCH_SIZE, COLLECTION_PERIOD);
+        // Cork all but the last write of the batch so gRPC can coalesce
+        // them; the last one flushes. The first write of the stream carries
+        // the initial metadata and fails if corked, so it always flushes.
+        for (size_t i = 0; i < n; i++) {
+            grpc::WriteOptions options;
+            if (i + 1 < n && !first) {
+                options.set_buffer_hint();
+            }
+            isConnected = writer->Write(batch[i], options);
+            first = false;
+            if (!isConnected) {
+                //Lost connectivity to this Voltha instance, the unsent
+                //indications stay journaled for the next one
+                break;
+            }
+            subscriber.delivered(batch[i].seq);
+        }
+    }
+
+    state.disconnect();
+    {
+        std::lock_guard<std::mutex> lock(statsModeMutex);
+        if (!request->stats_delta() && --fullStatsStreams == 0 && state.is_connected()) {
+            portStatsCache.reset(true);
+        }
+    }
+    std::cout << "Indication stream closed: " << subscriber.counters_to_str() << std::endl;
+    return Status::OK;
+}
+
+// Sends the packets of a PacketOut stream through pktOutDispatcher and
+// reports the ones that failed. Failures go out between reads and once the
+// client has half-closed and every packet has been sent.
+template <typename Stream>
+static Status StreamPacketOut(Stream* stream) {
+    PacketOutResults results;
+    openolt::PacketOutMsg msg;
+    std::vector<openolt::PacketOutResult> failed;
+    bool connected = true;
+    static const int streams = metrics.counter("rpc.PacketOut.streams");
+    static const int packets = metrics.counter("rpc.PacketOut.packets");
+
+    metrics.add(streams);
+    while (connected && stream->Read(&msg)) {
+        metrics.add(packets);
+        pktOutDispatcher.submit(&results, msg);
+        if (results.take_failed(failed)) {
+            for (size_t i = 0; i < failed.size() && connected; i++) {
+                connected = stream->Write(failed[i]);
+            }
+        }
+    }
+
+    results.wait_idle();
+    if (connected && results.take_failed(failed)) {
+        for (size_t i = 0; i < failed.size() && connected; i++) {
+            connected = stream->Write(failed[i]);
+        }
+    }
+    return Status::OK;
+}
+
+// The histogram rpc.<name> of an RPC's latency and the counter
+// rpc.<name>.errors of its failures
+struct RpcMetric {
+    explicit RpcMetric(const std::string& name) :
+        latency(metrics.histogram("rpc." + name)), errors(metrics.counter("rpc." + name + ".errors")) {}
+
+    int latency;
+    int errors;
+};
+
+class RpcTimer : public MetricsTimer {
+  public:
+    explicit RpcTimer(const RpcMetric& metric) : MetricsTimer(metric.latency), errors_(metric.errors) {}
+
+    Status done(const Status& status) {
+        if (!status.ok()) {
+            metrics.add(errors_);
+        }
+        return status;
+    }
+
+  private:
+    int errors_;
+};
 
 class OpenoltService final : public openolt::Openolt::Service {
 
@@ -49,84 +260,103 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Empty* request,
             openolt::Empty* response) override {
-        return Disable_();
+        static RpcMetric metric("DisableOlt");
+        RpcTimer timer(metric);
+        return timer.done(Disable_());
     }
 
     Status ReenableOlt(
             ServerContext* context,
             const openolt::Empty* request,
             openolt::Empty* response) override {
-        return Reenable_();
+        static RpcMetric metric("ReenableOlt");
+        RpcTimer timer(metric);
+        return timer.done(Reenable_());
     }
 
     Status ActivateOnu(
             ServerContext* context,
             const openolt::Onu* request,
             openolt::Empty* response) override {
-        return ActivateOnu_(
+        static RpcMetric metric("ActivateOnu");
+        RpcTimer timer(metric);
+        return timer.done(ActivateOnu_(
             request->intf_id(),
             request->onu_id(),
             ((request->serial_number()).vendor_id()).c_str(),
-            ((request->serial_number()).vendor_specific()).c_str(), request->pir());
+            ((request->serial_number()).vendor_specific()).c_str(), request->pir()));
     }
 
     Status DeactivateOnu(
             ServerContext* context,
             const openolt::Onu* request,
             openolt::Empty* response) override {
-        return DeactivateOnu_(
+        static RpcMetric metric("DeactivateOnu");
+        RpcTimer timer(metric);
+        return timer.done(DeactivateOnu_(
             request->intf_id(),
             request->onu_id(),
             ((request->serial_number()).vendor_id()).c_str(),
-            ((request->serial_number()).vendor_specific()).c_str());
+            ((request->serial_number()).vendor_specific()).c_str()));
     }
 
     Status DeleteOnu(
             ServerContext* context,
             const openolt::Onu* request,
             openolt::Empty* response) override {
-        return DeleteOnu_(
+        static RpcMetric metric("DeleteOnu");
+        RpcTimer timer(metric);
+        return timer.done(DeleteOnu_(
             request->intf_id(),
             request->onu_id(),
             ((request->serial_number()).vendor_id()).c_str(),
-            ((request->serial_number()).vendor_specific()).c_str());
+            ((request->serial_number()).vendor_specific()).c_str()));
     }
 
     Status OmciMsgOut(
             ServerContext* context,
             const openolt::OmciMsg* request,
             openolt::Empty* response) override {
-        return OmciMsgOut_(
+        static RpcMetric metric("OmciMsgOut");
+        RpcTimer timer(metric);
+        return timer.done(OmciMsgOut_(
             request->intf_id(),
             request->onu_id(),
-            request->pkt());
+            request->pkt(),
+            request->raw()));
     }
 
     Status OnuPacketOut(
             ServerContext* context,
             const openolt::OnuPacket* request,
             openolt::Empty* response) override {
-        return OnuPacketOut_(
+        static RpcMetric metric("OnuPacketOut");
+        RpcTimer timer(metric);
+        return timer.done(OnuPacketOut_(
             request->intf_id(),
             request->onu_id(),
             request->port_no(),
-            request->pkt());
+            request->pkt()));
     }
 
     Status UplinkPacketOut(
             ServerContext* context,
             const openolt::UplinkPacket* request,
             openolt::Empty* response) override {
-        return UplinkPacketOut_(
+        static RpcMetric metric("UplinkPacketOut");
+        RpcTimer timer(metric);
+        return timer.done(UplinkPacketOut_(
             request->intf_id(),
-            request->pkt());
+            request->pkt()));
     }
 
     Status FlowAdd(
             ServerContext* context,
             const openolt::Flow* request,
             openolt::Empty* response) override {
-        return FlowAdd_(
+        static RpcMetric metric("FlowAdd");
+        RpcTimer timer(metric);
+        return timer.done(FlowAdd_(
             request->access_intf_id(),
             request->onu_id(),
             request->uni_id(),
@@ -139,72 +369,58 @@ class OpenoltService final : public openolt::Openolt::Service {
             request->classifier(),
             request->action(),
             request->priority(),
-            request->cookie());
+            request->cookie()));
     }
 
     Status FlowRemove(
             ServerContext* context,
             const openolt::Flow* request,
             openolt::Empty* response) override {
-        return FlowRemove_(
+        static RpcMetric metric("FlowRemove");
+        RpcTimer timer(metric);
+        return timer.done(FlowRemove_(
             request->flow_id(),
-            request->flow_type());
+            request->flow_type()));
     }
 
-    Status EnableIndication(
+    Status FlowAddBatch(
             ServerContext* context,
-            const ::openolt::Empty* request,
-            ServerWriter<openolt::Indication>* writer) override {
-
-        std::cout << "Connection to Voltha established. Indications enabled"
-        << std::endl;
-
-        if (state.previsouly_connected()) {
-            // Reconciliation / recovery case
-            std::cout << "Reconciliation / Recovery case" << std::endl;
-            if (state.is_activated()){
-                // Adding extra olt indication of current state
-                openolt::Indication ind;
-                openolt::OltIndication* oltInd = new openolt::OltIndication();
-                if (state.is_activated()) {
-                    oltInd->set_oper_state("up");
-                    std::cout << "Extra OLT indication up" << std::endl;
-                } else {
-                    oltInd->set_oper_state("down");
-                    std::cout << "Extra OLT indication down" << std::endl;
-                }
-                ind.set_allocated_olt_ind(oltInd);
-                oltIndQ.push(ind);
-            }
-        }
+            const openolt::Flows* request,
+            openolt::FlowResults* response) override {
+        static RpcMetric metric("FlowAddBatch");
+        RpcTimer timer(metric);
+        return timer.done(FlowAddBatch_(request, response));
+    }
 
-        state.connect();
+    Status FlowRemoveBatch(
+            ServerContext* context,
+            const openolt::Flows* request,
+            openolt::FlowResults* response) override {
+        static RpcMetric metric("FlowRemoveBatch");
+        RpcTimer timer(metric);
+        return timer.done(FlowRemoveBatch_(request, response));
+    }
 
-        while (state.is_connected()) {
-            std::pair<openolt::Indication, bool> ind = oltIndQ.pop(COLLECTION_PERIOD);
-            if (ind.second == false) {
-                /* timeout - do lower priority periodic stuff like stats */
-                stats_collection();
-                continue;
-            }
-            openolt::Indication oltInd = ind.first;
-            bool isConnected = writer->Write(oltInd);
-            if (!isConnected) {
-                //Lost connectivity to this Voltha instance
-                //Put the indication back in the queue for next connecting instance
-                oltIndQ.push(oltInd);
-                state.disconnect();
-            }
-            //oltInd.release_olt_ind()
-        }
+    Status EnableIndication(
+            ServerContext* context,
+            const ::openolt::IndicationRequest* request,
+            ServerWriter<openolt::Indication>* writer) override {
+        SyncIndicationWriter sync_writer(writer);
+        return StreamIndications(&sync_writer, request);
+    }
 
-        return Status::OK;
+    Status PacketOut(
+            ServerContext* context,
+            grpc::ServerReaderWriter<openolt::PacketOutResult, openolt::PacketOutMsg>* stream) override {
+        return StreamPacketOut(stream);
     }
 
     Status HeartbeatCheck(
             ServerContext* context,
             const openolt::Empty* request,
             openolt::Heartbeat* response) override {
+        static RpcMetric metric("HeartbeatCheck");
+        RpcTimer timer(metric);
         response->set_heartbeat_signature(signature);
 
         return Status::OK;
@@ -214,22 +430,26 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Interface* request,
             openolt::Empty* response) override {
-
-        return EnablePonIf_(request->intf_id());
+        static RpcMetric metric("EnablePonIf");
+        RpcTimer timer(metric);
+        return timer.done(EnablePonIf_(request->intf_id()));
     }
 
     Status DisablePonIf(
             ServerContext* context,
             const openolt::Interface* request,
             openolt::Empty* response) override {
-
-        return DisablePonIf_(request->intf_id());
+        static RpcMetric metric("DisablePonIf");
+        RpcTimer timer(metric);
+        return timer.done(DisablePonIf_(request->intf_id()));
     }
 
     Status CollectStatistics(
             ServerContext* context,
             const openolt::Empty* request,
             openolt::Empty* response) override {
+        static RpcMetric metric("CollectStatistics");
+        RpcTimer timer(metric);
 
         stats_collection();
 
@@ -240,10 +460,12 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Empty* request,
             openolt::Empty* response) override {
+        static RpcMetric metric("Reboot");
+        RpcTimer timer(metric);
 
         system("shutdown -r now");
 
-        return Status::OK;
+        return timer.done(Status::OK);
 
     }
 
@@ -251,6 +473,8 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Empty* request,
             openolt::DeviceInfo* response) override {
+        static RpcMetric metric("GetDeviceInfo");
+        RpcTimer timer(metric);
 
         GetDeviceInfo_(response);
 
@@ -262,6 +486,8 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Tconts* request,
             openolt::Empty* response) override {
+        static RpcMetric metric("CreateTconts");
+        RpcTimer timer(metric);
         CreateTconts_(request);
         return Status::OK;
     };
@@ -270,19 +496,475 @@ class OpenoltService final : public openolt::Openolt::Service {
             ServerContext* context,
             const openolt::Tconts* request,
             openolt::Empty* response) override {
+        static RpcMetric metric("RemoveTconts");
+        RpcTimer timer(metric);
         RemoveTconts_(request);
         return Status::OK;
     };
 
+    Status GetMetrics(
+            ServerContext* context,
+            const openolt::MetricsRequest* request,
+            openolt::Metrics* response) override {
+        std::vector<metrics_histogram> histograms;
+        metrics_counters counters;
+
+        metrics.snapshot(&histograms, &counters, request->prefix());
+        for (size_t i = 0; i < histograms.size(); i++) {
+            const metrics_histogram& h = histograms[i];
+            openolt::MetricsHistogram* out = response->add_histograms();
+            out->set_name(h.name);
+            out->set_count(h.count);
+            out->set_sum_ns(h.sum_ns);
+            out->set_max_ns(h.max_ns);
+            out->set_p50_ns(Metrics::percentile(h, 0.5));
+            out->set_p90_ns(Metrics::percentile(h, 0.9));
+            out->set_p99_ns(Metrics::percentile(h, 0.99));
+            out->set_p999_ns(Metrics::percentile(h, 0.999));
+            for (int b = 0; request->buckets() && b < METRICS_BUCKETS; b++) {
+                if (h.buckets[b]) {
+                    openolt::MetricsBucket* bucket = out->add_buckets();
+                    bucket->set_upper_ns(Metrics::bucket_upper(b));
+                    bucket->set_count(h.buckets[b]);
+                }
+            }
+        }
+        for (size_t i = 0; i < counters.size(); i++) {
+            openolt::MetricsCounter* out = response->add_counters();
+            out->set_name(counters[i].first);
+            out->set_value(counters[i].second);
+        }
+        return Status::OK;
+    }
+
+    Status GetOnuTrace(
+            ServerContext* context,
+            const openolt::Onu* request,
+            openolt::OnuTrace* response) override {
+        response->set_intf_id(request->intf_id());
+        response->set_onu_id(request->onu_id());
+        response->set_trace_json(onuTracer.trace_json(request->intf_id(), request->onu_id()));
+        return Status::OK;
+    }
+
+};
+
+#if ASYNC_SERVER
+
+// The generated async service, plus a request for EnableIndication streams
+// that write raw bytes. The method is registered as usual and takes the same
+// request, the server does not care what type the writer writes.
+class AsyncService : public openolt::Openolt::AsyncService {
+  public:
+    void RequestEnableIndicationRaw(ServerContext* context, openolt::IndicationRequest* request,
+                                    grpc::ServerAsyncWriter<grpc::ByteBuffer>* writer,
+                                    grpc::CompletionQueue* cq, grpc::ServerCompletionQueue* notification_cq,
+                                    void* tag) {
+        RequestAsyncServerStreaming(method_index("EnableIndication"), context, request, writer,
+                                    cq, notification_cq, tag);
+    }
+
+  private:
+    // The generated code numbers the methods in proto order
+    static int method_index(const std::string& name) {
+        return openolt::Indication::descriptor()->file()->FindServiceByName("Openolt")
+            ->FindMethodByName(name)->index();
+    }
+};
+
+// Tag of every operation queued on a server completion queue. The polling
+// thread hands the completion back to the call that started it.
+class AsyncCall {
+  public:
+    virtual ~AsyncCall() {}
+    virtual void Proceed(bool ok) = 0;
+};
+
+// Threads running the unary handlers. Handlers block on BAL, the flow
+// workers or system(); run on the polling threads, a few of them would hold
+// up every other RPC and the completions the streams wait on.
+class HandlerPool {
+  public:
+    explicit HandlerPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; i++) {
+            std::thread(&HandlerPool::serve, this).detach();
+        }
+    }
+
+    void run(const std::function<void()>& handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handlers_.push_back(std::make_pair(std::chrono::steady_clock::now(), handler));
+        cv_.notify_one();
+    }
+
+  private:
+    void serve() {
+        int wait_metric = metrics.histogram("queue.handler.wait");
+
+        for (;;) {
+            std::pair<std::chrono::steady_clock::time_point, std::function<void()> > handler;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return !handlers_.empty(); });
+                handler = std::move(handlers_.front());
+                handlers_.pop_front();
+            }
+            metrics.record(wait_metric, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - handler.first).count());
+            handler.second();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::function<void()> > > handlers_;
+};
+
+// One unary RPC. Each instance waits for a single call of its method, queues
+// a replacement for the next call, runs the regular OpenoltService handler
+// on the handler pool, or on the polling thread when it has none, and
+// finishes the call.
+template <typename Req, typename Resp>
+class UnaryCall : public AsyncCall {
+  public:
+    typedef void (AsyncService::*RequestMethod)(
+        ServerContext*, Req*, grpc::ServerAsyncResponseWriter<Resp>*,
+        grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+    typedef Status (openolt::Openolt::Service::*Handler)(ServerContext*, const Req*, Resp*);
+
+    UnaryCall(AsyncService* service, openolt::Openolt::Service* impl, HandlerPool* pool,
+              grpc::ServerCompletionQueue* cq, RequestMethod request, Handler handler) :
+        service_(service), impl_(impl), pool_(pool), cq_(cq), request_(request), handler_(handler),
+        responder_(&ctx_), finishing_(false) {
+        (service_->*request_)(&ctx_, &req_, &responder_, cq_, cq_, this);
+    }
+
+    void Proceed(bool ok) override {
+        if (finishing_ || !ok) {
+            // Done, or the queue is shutting down
+            delete this;
+            return;
+        }
+        new UnaryCall(service_, impl_, pool_, cq_, request_, handler_);
+
+        if (pool_) {
+            pool_->run([this]() { Handle(); });
+        } else {
+            Handle();
+        }
+    }
+
+  private:
+    void Handle() {
+        Status status = (impl_->*handler_)(&ctx_, &req_, &resp_);
+        finishing_ = true;
+        responder_.Finish(resp_, status, this);
+    }
+
+    AsyncService* service_;
+    openolt::Openolt::Service* impl_;
+    HandlerPool* pool_;
+    grpc::ServerCompletionQueue* cq_;
+    RequestMethod request_;
+    Handler handler_;
+    ServerContext ctx_;
+    Req req_;
+    Resp resp_;
+    grpc::ServerAsyncResponseWriter<Resp> responder_;
+    bool finishing_;
 };
 
+// Deduces the request and response types from the method pointers, e.g.
+// ServeUnary(service, impl, pool, cq, &AsyncService::RequestFlowAdd, &openolt::Openolt::Service::FlowAdd).
+template <typename Base, typename Req, typename Resp>
+static void ServeUnary(AsyncService* service, openolt::Openolt::Service* impl, HandlerPool* pool,
+                       grpc::ServerCompletionQueue* cq,
+                       void (Base::*request)(ServerContext*, Req*, grpc::ServerAsyncResponseWriter<Resp>*,
+                                             grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*),
+                       Status (openolt::Openolt::Service::*handler)(ServerContext*, const Req*, Resp*)) {
+    new UnaryCall<Req, Resp>(service, impl, pool, cq, request, handler);
+}
+
+// A read or write of a streaming call. The stream's thread starts the
+// operation and waits; the polling thread completes it.
+class StreamOp : public AsyncCall {
+  public:
+    StreamOp() : done_(false), ok_(false) {}
+
+    // Call before starting the operation
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = false;
+    }
+
+    bool wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return done_; });
+        return ok_;
+    }
+
+    void Proceed(bool ok) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ok_ = ok;
+        done_ = true;
+        cv_.notify_one();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_;
+    bool ok_;
+};
+
+// A streaming RPC. Streams block for long stretches, so an accepted stream
+// runs on its own thread with blocking reads and writes over StreamOps. The
+// call itself is the tag of the stream's acceptance and of its Finish.
+class StreamCall : public AsyncCall {
+  public:
+    void Proceed(bool ok) override {
+        if (accepted_ || !ok) {
+            // Finished, or the queue is shutting down
+            delete this;
+            return;
+        }
+        accepted_ = true;
+        Listen();
+        std::thread(&StreamCall::Run, this).detach();
+    }
+
+  protected:
+    StreamCall() : accepted_(false) {}
+
+    // Queues a call object for the next stream of the same method
+    virtual void Listen() = 0;
+    // Serves the stream and finishes it, after which it must not touch this
+    virtual void Run() = 0;
+
+  private:
+    bool accepted_;
+};
+
+class IndicationCall : public StreamCall {
+  public:
+    IndicationCall(AsyncService* service, grpc::ServerCompletionQueue* cq) :
+        service_(service), cq_(cq), writer_(&ctx_) {
+        service_->RequestEnableIndicationRaw(&ctx_, &req_, &writer_, cq_, cq_, this);
+    }
+
+    // The journaled bytes are the whole message, seq is appended to them
+    // as one more field
+    bool Write(const JournalRecord& rec, grpc::WriteOptions options) {
+        uint8_t field[16];
+        uint8_t* end = CodedOutputStream::WriteTagToArray(
+            WireFormatLite::MakeTag(openolt::Indication::kSeqFieldNumber, WireFormatLite::WIRETYPE_VARINT),
+            field);
+        end = CodedOutputStream::WriteVarint64ToArray(rec.seq, end);
+
+        grpc::Slice slices[2] = {
+            grpc::Slice(rec.data.data(), rec.data.size()),
+            grpc::Slice(field, end - field)
+        };
+        grpc::ByteBuffer msg(slices, 2);
+        write_op_.start();
+        writer_.Write(msg, options, &write_op_);
+        return write_op_.wait();
+    }
+
+  private:
+    void Listen() override {
+        new IndicationCall(service_, cq_);
+    }
+
+    void Run() override {
+        writer_.Finish(StreamIndications(this, &req_), this);
+    }
+
+    AsyncService* service_;
+    grpc::ServerCompletionQueue* cq_;
+    ServerContext ctx_;
+    openolt::IndicationRequest req_;
+    grpc::ServerAsyncWriter<grpc::ByteBuffer> writer_;
+    StreamOp write_op_;
+};
+
+class PacketOutCall : public StreamCall {
+  public:
+    PacketOutCall(AsyncService* service, grpc::ServerCompletionQueue* cq) :
+        service_(service), cq_(cq), stream_(&ctx_) {
+        service_->RequestPacketOut(&ctx_, &stream_, cq_, cq_, this);
+    }
+
+    bool Read(openolt::PacketOutMsg* msg) {
+        read_op_.start();
+        stream_.Read(msg, &read_op_);
+        return read_op_.wait();
+    }
+
+    bool Write(const openolt::PacketOutResult& result) {
+        write_op_.start();
+        stream_.Write(result, &write_op_);
+        return write_op_.wait();
+    }
+
+  private:
+    void Listen() override {
+        new PacketOutCall(service_, cq_);
+    }
+
+    void Run() override {
+        stream_.Finish(StreamPacketOut(this), this);
+    }
+
+    AsyncService* service_;
+    grpc::ServerCompletionQueue* cq_;
+    ServerContext ctx_;
+    grpc::ServerAsyncReaderWriter<openolt::PacketOutResult, openolt::PacketOutMsg> stream_;
+    StreamOp read_op_;
+    StreamOp write_op_;
+};
+
+static void ServeCompletionQueue(AsyncService* service, openolt::Openolt::Service* impl,
+                                 HandlerPool* pool, grpc::ServerCompletionQueue* cq, int core) {
+    if (core >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            std::cout << "WARNING: failed to pin completion queue thread to core "
+                      << core << std::endl;
+        }
+    }
+
+    typedef openolt::Openolt::Service Sync;
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestDisableOlt, &Sync::DisableOlt);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestReenableOlt, &Sync::ReenableOlt);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestActivateOnu, &Sync::ActivateOnu);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestDeactivateOnu, &Sync::DeactivateOnu);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestDeleteOnu, &Sync::DeleteOnu);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestOmciMsgOut, &Sync::OmciMsgOut);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestOnuPacketOut, &Sync::OnuPacketOut);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestUplinkPacketOut, &Sync::UplinkPacketOut);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestFlowAdd, &Sync::FlowAdd);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestFlowRemove, &Sync::FlowRemove);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestFlowAddBatch, &Sync::FlowAddBatch);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestFlowRemoveBatch, &Sync::FlowRemoveBatch);
+    // Heartbeats only read the state, and are answered even when every
+    // handler thread is stuck
+    ServeUnary(service, impl, NULL, cq, &AsyncService::RequestHeartbeatCheck, &Sync::HeartbeatCheck);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestEnablePonIf, &Sync::EnablePonIf);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestDisablePonIf, &Sync::DisablePonIf);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestGetDeviceInfo, &Sync::GetDeviceInfo);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestReboot, &Sync::Reboot);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestCollectStatistics, &Sync::CollectStatistics);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestCreateTconts, &Sync::CreateTconts);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestRemoveTconts, &Sync::RemoveTconts);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestGetMetrics, &Sync::GetMetrics);
+    ServeUnary(service, impl, pool, cq, &AsyncService::RequestGetOnuTrace, &Sync::GetOnuTrace);
+    new IndicationCall(service, cq);
+    new PacketOutCall(service, cq);
+
+    void* tag;
+    bool ok;
+    while (cq->Next(&tag, &ok)) {
+        static_cast<AsyncCall*>(tag)->Proceed(ok);
+    }
+}
+
+#endif
+
+// Exports the counters the pipeline's components keep themselves to
+// GetMetrics, as the housekeeping task logs them
+static void component_counters(metrics_counters* out) {
+    static const char* tasks[] = { "stats", "flow_stats", "housekeeping" };
+
+    for (int c = 0; c < IND_CLASS_MAX; c++) {
+        ind_class_counters q;
+        std::string name = std::string("indication_queue.") + IndicationQueue::class_name((ind_class)c);
+        oltIndQ.get_counters((ind_class)c, &q);
+        out->push_back(std::make_pair(name + ".pushed", q.pushed));
+        out->push_back(std::make_pair(name + ".popped", q.popped));
+        out->push_back(std::make_pair(name + ".dropped", q.dropped));
+        out->push_back(std::make_pair(name + ".depth", q.depth));
+    }
+
+    ind_pool_counters pool;
+    oltIndQ.get_pool_counters(&pool);
+    out->push_back(std::make_pair("indication_pool.allocated", pool.allocated));
+    out->push_back(std::make_pair("indication_pool.reused", pool.reused));
+    out->push_back(std::make_pair("indication_pool.freed", pool.freed));
+    out->push_back(std::make_pair("indication_pool.wire_misses", oltIndQ.wire_misses()));
+
+    ind_journal_counters journal;
+    indJournal.get_counters(&journal);
+    out->push_back(std::make_pair("indication_journal.appended", journal.appended));
+    out->push_back(std::make_pair("indication_journal.evicted", journal.evicted));
+
+    ind_bus_counters bus;
+    indBus.get_counters(&bus);
+    out->push_back(std::make_pair("indication_bus.published", bus.published));
+    out->push_back(std::make_pair("indication_bus.subscribers", bus.subscribers));
+    out->push_back(std::make_pair("indication_bus.skipped", bus.skipped));
+
+    for (unsigned i = 0; i < indShards.size(); i++) {
+        ind_shard_counters shard;
+        std::string name = "indication_shards." + std::to_string(i);
+        indShards.get_counters(i, &shard);
+        out->push_back(std::make_pair(name + ".submitted", shard.submitted));
+        out->push_back(std::make_pair(name + ".dropped", shard.dropped));
+        out->push_back(std::make_pair(name + ".overflowed", shard.overflowed));
+        out->push_back(std::make_pair(name + ".handled", shard.handled));
+        out->push_back(std::make_pair(name + ".depth", shard.depth));
+    }
+
+    for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+        sched_task_counters task;
+        std::string name = std::string("scheduler.") + tasks[i];
+        if (scheduler.get_counters(tasks[i], &task)) {
+            out->push_back(std::make_pair(name + ".runs", task.runs));
+            out->push_back(std::make_pair(name + ".overruns", task.overruns));
+            out->push_back(std::make_pair(name + ".skipped", task.skipped));
+        }
+    }
+
+    port_stats_cache_counters stats;
+    portStatsCache.get_counters(&stats);
+    out->push_back(std::make_pair("port_stats_cache.snapshots", stats.snapshots));
+    out->push_back(std::make_pair("port_stats_cache.deltas", stats.deltas));
+    out->push_back(std::make_pair("port_stats_cache.suppressed", stats.suppressed));
+
+    onu_trace_counters trace;
+    onuTracer.get_counters(&trace);
+    out->push_back(std::make_pair("onu_trace.traced", trace.traced));
+    out->push_back(std::make_pair("onu_trace.overwritten", trace.overwritten));
+    out->push_back(std::make_pair("onu_trace.activations", trace.activations));
+    out->push_back(std::make_pair("onu_trace.pending", trace.pending));
+    out->push_back(std::make_pair("onu_trace.expired", trace.expired));
+
+    fast_log_counters log;
+    fastLog.get_counters(&log);
+    out->push_back(std::make_pair("fast_log.logged", log.logged));
+    out->push_back(std::make_pair("fast_log.suppressed", log.suppressed));
+    out->push_back(std::make_pair("fast_log.dropped", log.dropped));
+    out->push_back(std::make_pair("fast_log.written", log.written));
+}
+
 void RunServer() {
   OpenoltService service;
   std::string server_address(serverPort);
   ServerBuilder builder;
 
   builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+#if ASYNC_SERVER
+  AsyncService async_service;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue> > cqs;
+  builder.RegisterService(&async_service);
+  for (int i = 0; i < SERVER_CQ_THREADS; i++) {
+      cqs.push_back(builder.AddCompletionQueue());
+  }
+#else
   builder.RegisterService(&service);
+#endif
 
   std::unique_ptr<Server> server(builder.BuildAndStart());
 
@@ -293,6 +975,41 @@ void RunServer() {
   std::cout << "Server listening on " << server_address
   << ", connection signature : " << signature << std::endl;
 
-
+  scheduler.add("stats", std::chrono::seconds(COLLECTION_PERIOD), stats_collection);
+  scheduler.add("flow_stats", std::chrono::milliseconds(FLOW_STATS_PERIOD_MS), flow_stats_sweep);
+  scheduler.add("housekeeping", std::chrono::seconds(HOUSEKEEPING_PERIOD), []() {
+      std::cout << "Indication queue: " << oltIndQ.counters_to_str() << std::endl;
+      std::cout << "Indication pool: " << oltIndQ.pool_counters_to_str() << std::endl;
+      std::cout << "Indication journal: " << indJournal.counters_to_str() << std::endl;
+      std::cout << "Indication bus: " << indBus.counters_to_str() << std::endl;
+      std::cout << "Indication shards: " << indShards.counters_to_str() << std::endl;
+      std::cout << "Periodic tasks: " << scheduler.counters_to_str() << std::endl;
+      std::cout << "Port statistics: " << portStatsCache.counters_to_str() << std::endl;
+      onuTracer.expire();
+      std::cout << "ONU activations: " << onuTracer.counters_to_str() << std::endl;
+      std::cout << "Fast log: " << fastLog.counters_to_str() << std::endl;
+  });
+
+  metrics.add_source(component_counters);
+  if (strlen(METRICS_TEXT_ADDRESS) > 0) {
+      metrics.serve_text(METRICS_TEXT_ADDRESS);
+  }
+
+#if ASYNC_SERVER
+  long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+  HandlerPool pool(SERVER_HANDLER_THREADS);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < SERVER_CQ_THREADS; i++) {
+      int core = SERVER_CQ_FIRST_CORE < 0 ? -1 : (int)((SERVER_CQ_FIRST_CORE + i) % ncores);
+      threads.push_back(std::thread(ServeCompletionQueue, &async_service, &service, &pool,
+                                    cqs[i].get(), core));
+  }
+  std::cout << "Serving RPCs from " << SERVER_CQ_THREADS << " completion queues and "
+            << SERVER_HANDLER_THREADS << " handler threads" << std::endl;
+  for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+  }
+#else
   server->Wait();
+#endif
 }
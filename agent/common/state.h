@@ -18,11 +18,18 @@
 #ifndef OPENOLT_STATE_H_
 #define OPENOLT_STATE_H_
 
+#include <atomic>
+
 class State {
   public:
 
+    // True while at least one indication stream is open
     bool is_connected() {
-        return connected_to_voltha;
+        return connections > 0;
+    }
+
+    int connected_streams() {
+        return connections;
     }
 
     bool is_activated() {
@@ -34,12 +41,12 @@ class State {
     }
 
     void connect() {
-        connected_to_voltha = true;
+        connections++;
         connected_once = true;
     }
 
     void disconnect() {
-        connected_to_voltha = false;
+        connections--;
     }
 
     void activate() {
@@ -51,7 +58,7 @@ class State {
     }
 
   private:
-    bool connected_to_voltha = false;
+    std::atomic<int> connections{0};
     bool activated = false;
     bool connected_once = false;
 };
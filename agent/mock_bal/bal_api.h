@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_API_H_
+#define MOCK_BAL_API_H_
+
+// The BAL API calls and object macros the agent uses, with the signatures
+// of BAL 2.6, implemented by mock_bal.cc
+
+#include "bcmos_system.h"
+#include "bal_model_types.h"
+
+typedef bcmos_errno (*f_bcmbal_ind_handler)(bcmbal_obj *obj);
+
+typedef struct {
+    bcmos_module_id module;
+    bcmbal_obj_id obj_type;
+    void *p_object_key_info;
+    uint16_t *p_subgroup;       // all indications of obj_type if NULL
+    f_bcmbal_ind_handler ind_cb_hdlr;
+} bcmbal_cb_cfg;
+
+#define BCMBAL_OBJ_INIT(_msg, _obj, _key, _group, _subgroup) \
+    do { \
+        memset((_msg), 0, sizeof(*(_msg))); \
+        (_msg)->hdr.obj_type = bcmbal_obj_id_##_obj; \
+        (_msg)->hdr.group = (_group); \
+        (_msg)->hdr.subgroup = (_subgroup); \
+        (_msg)->key = (_key); \
+    } while (0)
+
+#define BCMBAL_CFG_INIT(_msg, _obj, _key) \
+    BCMBAL_OBJ_INIT(_msg, _obj, _key, BCMBAL_MGT_GROUP_CFG, 0)
+
+#define BCMBAL_CFG_PROP_SET(_msg, _obj, _prop, _val) \
+    do { \
+        (_msg)->data._prop = (_val); \
+        (_msg)->hdr.presence_mask |= 1ULL << bcmbal_##_obj##_cfg_id_##_prop; \
+    } while (0)
+
+#define BCMBAL_CFG_PROP_GET(_msg, _obj, _prop) \
+    ((_msg)->hdr.presence_mask |= 1ULL << bcmbal_##_obj##_cfg_id_##_prop)
+
+#define BCMBAL_CFG_PROP_IS_SET(_msg, _obj, _prop) \
+    (((_msg)->hdr.presence_mask & (1ULL << bcmbal_##_obj##_cfg_id_##_prop)) != 0)
+
+#define BCMBAL_STAT_INIT(_msg, _obj, _key) \
+    BCMBAL_OBJ_INIT(_msg, _obj, _key, BCMBAL_MGT_GROUP_STAT, 0)
+
+// all_properties asks for every counter
+#define BCMBAL_STAT_PROP_GET(_msg, _obj, _prop) \
+    ((_msg)->hdr.presence_mask |= (bcmbal_##_obj##_stat_id_##_prop == bcmbal_##_obj##_stat_id_all_properties) ? \
+        ~0ULL : 1ULL << bcmbal_##_obj##_stat_id_##_prop)
+
+#define BCMBAL_ATTRIBUTE_PROP_SET(_attr, _type, _prop, _val) \
+    do { \
+        (_attr)->_prop = (_val); \
+        (_attr)->presence_mask |= bcmbal_##_type##_id_##_prop; \
+    } while (0)
+
+#define BCMBAL_IND_SUBGROUP(_obj, _subgroup) bcmbal_##_obj##_auto_id_##_subgroup
+
+bcmos_errno bcmbal_cfg_set(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bcmbal_cfg_get(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bcmbal_cfg_clear(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bcmbal_stat_get(bcmbal_access_id access_term_id, bcmbal_stat *objinfo,
+                            bcmos_bool clear_on_read);
+bcmos_errno bcmbal_pkt_send(bcmbal_access_id access_term_id, bcmbal_dest dest,
+                            const char *packet_to_send, uint16_t packet_len);
+bcmos_errno bcmbal_subscribe_ind(bcmbal_access_id access_term_id, bcmbal_cb_cfg *cb_cfg);
+
+#endif
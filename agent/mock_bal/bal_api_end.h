@@ -0,0 +1,27 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_API_END_H_
+#define MOCK_BAL_API_END_H_
+
+#include "bal_api.h"
+
+// Starts the mock BAL. Its --mock-* options are taken from argv, see
+// mock_bal.h; everything else is left to the agent.
+bcmos_errno bcmbal_init(int argc, char *argv[], void *p_mgmt_cb);
+
+#endif
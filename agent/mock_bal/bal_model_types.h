@@ -0,0 +1,955 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_MODEL_TYPES_H_
+#define MOCK_BAL_MODEL_TYPES_H_
+
+// The BAL 2.6 object model as far as the agent uses it: the objects, keys,
+// properties and indications it reads or writes, under the names of the
+// real bal_model_types.h. Properties the agent never touches are left out.
+
+#include "bcmos_system.h"
+
+#define DEFAULT_ATERM_ID 0
+
+typedef uint16_t bcmbal_access_id;
+typedef uint32_t bcmbal_intf_id;
+typedef uint32_t bcmbal_sub_id;
+typedef uint32_t bcmbal_flow_id;
+typedef uint16_t bcmbal_service_port_id;
+typedef uint16_t bcmbal_aggregation_port_id;
+typedef uint32_t bcmbal_tm_sched_id;
+typedef uint8_t bcmbal_tm_queue_id;
+typedef uint16_t bcmbal_flow_priority;
+typedef uint64_t bcmbal_cookie;
+
+/* Objects */
+
+typedef enum {
+    BCMBAL_OBJ_ID_ACCESS_TERMINAL = 0,
+    BCMBAL_OBJ_ID_FLOW,
+    BCMBAL_OBJ_ID_GROUP,
+    BCMBAL_OBJ_ID_INTERFACE,
+    BCMBAL_OBJ_ID_PACKET,
+    BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL,
+    BCMBAL_OBJ_ID_TM_QUEUE,
+    BCMBAL_OBJ_ID_TM_SCHED,
+    BCMBAL_OBJ_ID__NUM_OF,
+} bcmbal_obj_id;
+
+#define bcmbal_obj_id_access_terminal       BCMBAL_OBJ_ID_ACCESS_TERMINAL
+#define bcmbal_obj_id_flow                  BCMBAL_OBJ_ID_FLOW
+#define bcmbal_obj_id_group                 BCMBAL_OBJ_ID_GROUP
+#define bcmbal_obj_id_interface             BCMBAL_OBJ_ID_INTERFACE
+#define bcmbal_obj_id_packet                BCMBAL_OBJ_ID_PACKET
+#define bcmbal_obj_id_subscriber_terminal   BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL
+#define bcmbal_obj_id_tm_queue              BCMBAL_OBJ_ID_TM_QUEUE
+#define bcmbal_obj_id_tm_sched              BCMBAL_OBJ_ID_TM_SCHED
+
+typedef enum {
+    BCMBAL_MGT_GROUP_CFG = 0,
+    BCMBAL_MGT_GROUP_STAT,
+    BCMBAL_MGT_GROUP_AUTO,
+} bcmbal_mgt_group;
+
+// The header every configuration, statistics and indication object starts
+// with. presence_mask has a bit per property set or wanted.
+typedef struct bcmbal_obj {
+    bcmbal_obj_id obj_type;
+    bcmbal_mgt_group group;
+    uint16_t subgroup;
+    bcmos_errno status;
+    uint64_t presence_mask;
+} bcmbal_obj;
+
+typedef bcmbal_obj bcmbal_cfg;
+typedef bcmbal_obj bcmbal_stat;
+
+/* Common types */
+
+typedef enum {
+    BCMBAL_STATE_UP = 0,
+    BCMBAL_STATE_DOWN,
+    BCMBAL_STATE_TESTING,
+} bcmbal_state;
+
+typedef enum {
+    BCMBAL_STATUS_UP = 0,
+    BCMBAL_STATUS_DOWN,
+    BCMBAL_STATUS_TESTING,
+    BCMBAL_STATUS_NOT_PRESENT,
+    BCMBAL_STATUS_LOWER_LAYER_DOWN,
+    BCMBAL_STATUS_UNKNOWN,
+} bcmbal_status;
+
+typedef enum {
+    BCMBAL_ALARM_STATUS_OFF = 0,
+    BCMBAL_ALARM_STATUS_ON,
+    BCMBAL_ALARM_STATUS_NO__CHANGE,
+} bcmbal_alarm_status;
+
+typedef enum {
+    BCMBAL_INTF_TYPE_NNI = 0,
+    BCMBAL_INTF_TYPE_PON,
+} bcmbal_intf_type;
+
+typedef enum {
+    BCMBAL_PON_FAMILY_GPON = 0,
+    BCMBAL_PON_FAMILY_EPON,
+} bcmbal_pon_family;
+
+typedef enum {
+    BCMBAL_PON_SUB_FAMILY_GPON = 0,
+    BCMBAL_PON_SUB_FAMILY_XGPON,
+    BCMBAL_PON_SUB_FAMILY_XGS,
+    BCMBAL_PON_SUB_FAMILY_NGPON2,
+} bcmbal_pon_sub_family;
+
+typedef enum {
+    BCMBAL_TRX_TYPE_GPON_SPS_43_48 = 0,
+    BCMBAL_TRX_TYPE_GPON_SPS_SOG_4321,
+    BCMBAL_TRX_TYPE_GPON_LTE_3680_M,
+    BCMBAL_TRX_TYPE_GPON_SOURCE_PHOTONICS,
+    BCMBAL_TRX_TYPE_GPON_LTE_3680_P,
+    BCMBAL_TRX_TYPE_XGPON_LTH_7222_PC,
+    BCMBAL_TRX_TYPE_XGPON_LTH_7226_PC,
+    BCMBAL_TRX_TYPE_XGPON_LTH_5302_PC,
+} bcmbal_trx_type;
+
+typedef struct {
+    uint8_t vendor_id[4];
+    uint8_t vendor_specific[4];
+} bcmbal_serial_number;
+
+typedef struct {
+    uint8_t arr[36];
+} bcmbal_registration_id;
+
+typedef struct {
+    uint32_t len;
+    uint8_t *val;
+} bcmbal_u8_list_u32_max_2048;
+
+/* Packet destinations */
+
+typedef enum {
+    BCMBAL_DEST_TYPE_NNI = 1,
+    BCMBAL_DEST_TYPE_SUB_TERM,
+    BCMBAL_DEST_TYPE_SVC_PORT,
+    BCMBAL_DEST_TYPE_HOST,
+    BCMBAL_DEST_TYPE_ITU_OMCI_CHANNEL,
+    BCMBAL_DEST_TYPE_IEEE_OAM_CHANNEL,
+} bcmbal_dest_type;
+
+typedef struct {
+    bcmbal_dest_type type;
+    union {
+        struct {
+            bcmbal_intf_id intf_id;
+        } nni;
+        struct {
+            bcmbal_sub_id sub_term_id;
+            bcmbal_intf_id intf_id;
+        } sub_term;
+        struct {
+            bcmbal_service_port_id svc_port_id;
+            bcmbal_intf_id intf_id;
+        } svc_port;
+        struct {
+            bcmbal_sub_id sub_term_id;
+            bcmbal_intf_id intf_id;
+        } itu_omci_channel;
+    } u;
+} bcmbal_dest;
+
+/* Classifier and action of a flow */
+
+typedef enum {
+    BCMBAL_PKT_TAG_TYPE_NONE = 0,
+    BCMBAL_PKT_TAG_TYPE_UNTAGGED = 0x0001,
+    BCMBAL_PKT_TAG_TYPE_SINGLE_TAG = 0x0002,
+    BCMBAL_PKT_TAG_TYPE_DOUBLE_TAG = 0x0004,
+} bcmbal_pkt_tag_type;
+
+typedef enum {
+    BCMBAL_CLASSIFIER_ID_NONE = 0,
+    BCMBAL_CLASSIFIER_ID_O_TPID = 0x0001,
+    BCMBAL_CLASSIFIER_ID_O_VID = 0x0002,
+    BCMBAL_CLASSIFIER_ID_I_TPID = 0x0004,
+    BCMBAL_CLASSIFIER_ID_I_VID = 0x0008,
+    BCMBAL_CLASSIFIER_ID_O_PBITS = 0x0010,
+    BCMBAL_CLASSIFIER_ID_I_PBITS = 0x0020,
+    BCMBAL_CLASSIFIER_ID_ETHER_TYPE = 0x0040,
+    BCMBAL_CLASSIFIER_ID_DST_MAC = 0x0080,
+    BCMBAL_CLASSIFIER_ID_SRC_MAC = 0x0100,
+    BCMBAL_CLASSIFIER_ID_IP_PROTO = 0x0200,
+    BCMBAL_CLASSIFIER_ID_DST_IP = 0x0400,
+    BCMBAL_CLASSIFIER_ID_SRC_IP = 0x0800,
+    BCMBAL_CLASSIFIER_ID_SRC_PORT = 0x1000,
+    BCMBAL_CLASSIFIER_ID_DST_PORT = 0x2000,
+    BCMBAL_CLASSIFIER_ID_PKT_TAG_TYPE = 0x4000,
+} bcmbal_classifier_id;
+
+#define bcmbal_classifier_id_o_tpid         BCMBAL_CLASSIFIER_ID_O_TPID
+#define bcmbal_classifier_id_o_vid          BCMBAL_CLASSIFIER_ID_O_VID
+#define bcmbal_classifier_id_i_tpid         BCMBAL_CLASSIFIER_ID_I_TPID
+#define bcmbal_classifier_id_i_vid          BCMBAL_CLASSIFIER_ID_I_VID
+#define bcmbal_classifier_id_o_pbits        BCMBAL_CLASSIFIER_ID_O_PBITS
+#define bcmbal_classifier_id_i_pbits        BCMBAL_CLASSIFIER_ID_I_PBITS
+#define bcmbal_classifier_id_ether_type     BCMBAL_CLASSIFIER_ID_ETHER_TYPE
+#define bcmbal_classifier_id_dst_mac        BCMBAL_CLASSIFIER_ID_DST_MAC
+#define bcmbal_classifier_id_src_mac        BCMBAL_CLASSIFIER_ID_SRC_MAC
+#define bcmbal_classifier_id_ip_proto       BCMBAL_CLASSIFIER_ID_IP_PROTO
+#define bcmbal_classifier_id_dst_ip         BCMBAL_CLASSIFIER_ID_DST_IP
+#define bcmbal_classifier_id_src_ip         BCMBAL_CLASSIFIER_ID_SRC_IP
+#define bcmbal_classifier_id_src_port       BCMBAL_CLASSIFIER_ID_SRC_PORT
+#define bcmbal_classifier_id_dst_port       BCMBAL_CLASSIFIER_ID_DST_PORT
+#define bcmbal_classifier_id_pkt_tag_type   BCMBAL_CLASSIFIER_ID_PKT_TAG_TYPE
+
+typedef struct {
+    bcmbal_classifier_id presence_mask;
+    uint16_t o_tpid;
+    uint16_t o_vid;
+    uint16_t i_tpid;
+    uint16_t i_vid;
+    uint8_t o_pbits;
+    uint8_t i_pbits;
+    uint16_t ether_type;
+    uint8_t dst_mac[6];
+    uint8_t src_mac[6];
+    uint8_t ip_proto;
+    uint32_t dst_ip;
+    uint32_t src_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    bcmbal_pkt_tag_type pkt_tag_type;
+} bcmbal_classifier;
+
+typedef enum {
+    BCMBAL_ACTION_CMD_ID_NONE = 0,
+    BCMBAL_ACTION_CMD_ID_ADD_OUTER_TAG = 0x0001,
+    BCMBAL_ACTION_CMD_ID_REMOVE_OUTER_TAG = 0x0002,
+    BCMBAL_ACTION_CMD_ID_XLATE_OUTER_TAG = 0x0004,
+    BCMBAL_ACTION_CMD_ID_XLATE_TWO_TAGS = 0x0008,
+    BCMBAL_ACTION_CMD_ID_DISCARD_DS_BCAST = 0x0010,
+    BCMBAL_ACTION_CMD_ID_DISCARD_DS_UNKNOWN = 0x0020,
+    BCMBAL_ACTION_CMD_ID_ADD_TWO_TAGS = 0x0040,
+    BCMBAL_ACTION_CMD_ID_REMOVE_TWO_TAGS = 0x0080,
+    BCMBAL_ACTION_CMD_ID_REMARK_PBITS = 0x0100,
+    BCMBAL_ACTION_CMD_ID_COPY_PBITS = 0x0200,
+    BCMBAL_ACTION_CMD_ID_REVERSE_COPY_PBITS = 0x0400,
+    BCMBAL_ACTION_CMD_ID_DSCP_TO_PBITS = 0x0800,
+    BCMBAL_ACTION_CMD_ID_TRAP_TO_HOST = 0x1000,
+} bcmbal_action_cmd_id;
+
+typedef enum {
+    BCMBAL_ACTION_ID_NONE = 0,
+    BCMBAL_ACTION_ID_CMDS_BITMASK = 0x0001,
+    BCMBAL_ACTION_ID_O_VID = 0x0002,
+    BCMBAL_ACTION_ID_O_PBITS = 0x0004,
+    BCMBAL_ACTION_ID_O_TPID = 0x0008,
+    BCMBAL_ACTION_ID_I_VID = 0x0010,
+    BCMBAL_ACTION_ID_I_PBITS = 0x0020,
+    BCMBAL_ACTION_ID_I_TPID = 0x0040,
+} bcmbal_action_id;
+
+#define bcmbal_action_id_cmds_bitmask       BCMBAL_ACTION_ID_CMDS_BITMASK
+#define bcmbal_action_id_o_vid              BCMBAL_ACTION_ID_O_VID
+#define bcmbal_action_id_o_pbits            BCMBAL_ACTION_ID_O_PBITS
+#define bcmbal_action_id_o_tpid             BCMBAL_ACTION_ID_O_TPID
+#define bcmbal_action_id_i_vid              BCMBAL_ACTION_ID_I_VID
+#define bcmbal_action_id_i_pbits            BCMBAL_ACTION_ID_I_PBITS
+#define bcmbal_action_id_i_tpid             BCMBAL_ACTION_ID_I_TPID
+
+typedef struct {
+    bcmbal_action_id presence_mask;
+    bcmbal_action_cmd_id cmds_bitmask;
+    uint16_t o_vid;
+    uint8_t o_pbits;
+    uint16_t o_tpid;
+    uint16_t i_vid;
+    uint8_t i_pbits;
+    uint16_t i_tpid;
+} bcmbal_action;
+
+/* Traffic management */
+
+typedef enum {
+    BCMBAL_TM_SCHED_DIR_US = 1,
+    BCMBAL_TM_SCHED_DIR_DS = 2,
+} bcmbal_tm_sched_dir;
+
+typedef enum {
+    BCMBAL_TM_SCHED_TYPE_NONE = 0,
+    BCMBAL_TM_SCHED_TYPE_WFQ,
+    BCMBAL_TM_SCHED_TYPE_SP,
+    BCMBAL_TM_SCHED_TYPE_SP_WFQ,
+} bcmbal_tm_sched_type;
+
+typedef enum {
+    BCMBAL_TM_CREATION_MODE_MANUAL = 0,
+    BCMBAL_TM_CREATION_MODE_AUTO,
+} bcmbal_tm_creation_mode;
+
+typedef enum {
+    BCMBAL_TM_SHAPING_ID_NONE = 0,
+    BCMBAL_TM_SHAPING_ID_PIR = 0x0001,
+    BCMBAL_TM_SHAPING_ID_CIR = 0x0002,
+    BCMBAL_TM_SHAPING_ID_BURST = 0x0004,
+    BCMBAL_TM_SHAPING_ID_ALL = 0x0007,
+} bcmbal_tm_shaping_id;
+
+typedef struct {
+    bcmbal_tm_shaping_id presence_mask;
+    uint32_t cir;
+    uint32_t pir;
+    uint32_t burst;
+} bcmbal_tm_shaping;
+
+typedef struct {
+    bcmbal_tm_sched_id sched_id;
+    bcmbal_tm_queue_id queue_id;
+} bcmbal_tm_queue_ref;
+
+typedef enum {
+    BCMBAL_TM_SCHED_OWNER_TYPE_UNDEFINED = 0,
+    BCMBAL_TM_SCHED_OWNER_TYPE_INTERFACE,
+    BCMBAL_TM_SCHED_OWNER_TYPE_SUB_TERM,
+    BCMBAL_TM_SCHED_OWNER_TYPE_AGG_PORT,
+    BCMBAL_TM_SCHED_OWNER_TYPE_UNI,
+    BCMBAL_TM_SCHED_OWNER_TYPE_VIRTUAL,
+} bcmbal_tm_sched_owner_type;
+
+typedef enum {
+    BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_NONE = 0,
+    BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_INTF_ID = 0x0001,
+    BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_SUB_TERM_ID = 0x0002,
+    BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_AGG_PORT_ID = 0x0004,
+} bcmbal_tm_sched_owner_agg_port_id;
+
+#define bcmbal_tm_sched_owner_agg_port_id_intf_id       BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_INTF_ID
+#define bcmbal_tm_sched_owner_agg_port_id_sub_term_id   BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_SUB_TERM_ID
+#define bcmbal_tm_sched_owner_agg_port_id_agg_port_id   BCMBAL_TM_SCHED_OWNER_AGG_PORT_ID_AGG_PORT_ID
+
+typedef struct {
+    bcmbal_tm_sched_owner_agg_port_id presence_mask;
+    bcmbal_intf_id intf_id;
+    bcmbal_sub_id sub_term_id;
+    bcmbal_aggregation_port_id agg_port_id;
+} bcmbal_tm_sched_owner_agg_port;
+
+typedef struct {
+    bcmbal_tm_sched_owner_type type;
+    union {
+        struct {
+            bcmbal_intf_type intf_type;
+            bcmbal_intf_id intf_id;
+        } interface;
+        bcmbal_tm_sched_owner_agg_port agg_port;
+    } u;
+} bcmbal_tm_sched_owner;
+
+typedef enum {
+    BCMBAL_TM_SCHED_PARENT_ID_NONE = 0,
+    BCMBAL_TM_SCHED_PARENT_ID_SCHED_ID = 0x0001,
+    BCMBAL_TM_SCHED_PARENT_ID_PRIORITY = 0x0002,
+    BCMBAL_TM_SCHED_PARENT_ID_WEIGHT = 0x0004,
+} bcmbal_tm_sched_parent_id;
+
+typedef struct {
+    bcmbal_tm_sched_parent_id presence_mask;
+    bcmbal_tm_sched_id sched_id;
+    uint8_t priority;
+    uint8_t weight;
+} bcmbal_tm_sched_parent;
+
+/* Access terminal */
+
+typedef struct {
+    bcmbal_access_id access_term_id;
+} bcmbal_access_terminal_key;
+
+typedef struct {
+    uint8_t major_rev;
+    uint8_t minor_rev;
+    uint8_t release_rev;
+    uint32_t om_version;
+} bcmbal_access_terminal_sw_version;
+
+typedef struct {
+    uint8_t num_of_nni_ports;
+    uint8_t num_of_pon_ports;
+    uint8_t num_of_mac_devs;
+    uint8_t num_of_pons_per_mac_dev;
+    bcmbal_pon_family pon_family;
+    bcmbal_pon_sub_family pon_sub_family;
+} bcmbal_topology;
+
+typedef enum {
+    bcmbal_access_terminal_cfg_id_admin_state = 0,
+    bcmbal_access_terminal_cfg_id_oper_status,
+    bcmbal_access_terminal_cfg_id_iwf_mode,
+    bcmbal_access_terminal_cfg_id_topology,
+    bcmbal_access_terminal_cfg_id_sw_version,
+    bcmbal_access_terminal_cfg_id_conn_id,
+} bcmbal_access_terminal_cfg_id;
+
+typedef struct {
+    bcmbal_state admin_state;
+    bcmbal_status oper_status;
+    uint32_t iwf_mode;
+    bcmbal_topology topology;
+    bcmbal_access_terminal_sw_version sw_version;
+    uint32_t conn_id;
+} bcmbal_access_terminal_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_access_terminal_key key;
+    bcmbal_access_terminal_cfg_data data;
+} bcmbal_access_terminal_cfg;
+
+typedef enum {
+    bcmbal_access_terminal_auto_id_oper_status_change = 0,
+} bcmbal_access_terminal_auto_id;
+
+typedef struct {
+    bcmbal_status new_oper_status;
+    bcmbal_status old_oper_status;
+    bcmbal_state admin_state;
+} bcmbal_access_terminal_oper_status_change_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_access_terminal_key key;
+    bcmbal_access_terminal_oper_status_change_data data;
+} bcmbal_access_terminal_oper_status_change;
+
+/* Interface */
+
+typedef struct {
+    bcmbal_intf_id intf_id;
+    bcmbal_intf_type intf_type;
+} bcmbal_interface_key;
+
+typedef enum {
+    bcmbal_interface_cfg_id_admin_state = 0,
+    bcmbal_interface_cfg_id_oper_status,
+    bcmbal_interface_cfg_id_min_data_agg_port_id,
+    bcmbal_interface_cfg_id_min_data_svc_port_id,
+    bcmbal_interface_cfg_id_transceiver_type,
+    bcmbal_interface_cfg_id_mtu,
+} bcmbal_interface_cfg_id;
+
+typedef struct {
+    bcmbal_state admin_state;
+    bcmbal_status oper_status;
+    bcmbal_aggregation_port_id min_data_agg_port_id;
+    bcmbal_service_port_id min_data_svc_port_id;
+    bcmbal_trx_type transceiver_type;
+    uint16_t mtu;
+} bcmbal_interface_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_interface_key key;
+    bcmbal_interface_cfg_data data;
+} bcmbal_interface_cfg;
+
+typedef enum {
+    bcmbal_interface_stat_id_rx_bytes = 0,
+    bcmbal_interface_stat_id_rx_packets,
+    bcmbal_interface_stat_id_rx_ucast_packets,
+    bcmbal_interface_stat_id_rx_mcast_packets,
+    bcmbal_interface_stat_id_rx_bcast_packets,
+    bcmbal_interface_stat_id_rx_error_packets,
+    bcmbal_interface_stat_id_rx_unknown_protos,
+    bcmbal_interface_stat_id_rx_crc_errors,
+    bcmbal_interface_stat_id_bip_errors,
+    bcmbal_interface_stat_id_tx_bytes,
+    bcmbal_interface_stat_id_tx_packets,
+    bcmbal_interface_stat_id_tx_ucast_packets,
+    bcmbal_interface_stat_id_tx_mcast_packets,
+    bcmbal_interface_stat_id_tx_bcast_packets,
+    bcmbal_interface_stat_id_tx_error_packets,
+    bcmbal_interface_stat_id_all_properties,
+} bcmbal_interface_stat_id;
+
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_ucast_packets;
+    uint64_t rx_mcast_packets;
+    uint64_t rx_bcast_packets;
+    uint64_t rx_error_packets;
+    uint64_t rx_unknown_protos;
+    uint64_t rx_crc_errors;
+    uint64_t bip_errors;
+    uint64_t tx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_ucast_packets;
+    uint64_t tx_mcast_packets;
+    uint64_t tx_bcast_packets;
+    uint64_t tx_error_packets;
+} bcmbal_interface_stat_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_interface_key key;
+    bcmbal_interface_stat_data data;
+} bcmbal_interface_stat;
+
+typedef enum {
+    bcmbal_interface_auto_id_los = 0,
+    bcmbal_interface_auto_id_oper_status_change,
+} bcmbal_interface_auto_id;
+
+typedef struct {
+    bcmbal_alarm_status status;
+} bcmbal_interface_los_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_interface_key key;
+    bcmbal_interface_los_data data;
+} bcmbal_interface_los;
+
+typedef struct {
+    bcmbal_status new_oper_status;
+    bcmbal_status old_oper_status;
+    bcmbal_state admin_state;
+} bcmbal_interface_oper_status_change_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_interface_key key;
+    bcmbal_interface_oper_status_change_data data;
+} bcmbal_interface_oper_status_change;
+
+/* Subscriber terminal */
+
+typedef struct {
+    bcmbal_sub_id sub_term_id;
+    bcmbal_intf_id intf_id;
+} bcmbal_subscriber_terminal_key;
+
+typedef enum {
+    bcmbal_subscriber_terminal_cfg_id_admin_state = 0,
+    bcmbal_subscriber_terminal_cfg_id_oper_status,
+    bcmbal_subscriber_terminal_cfg_id_serial_number,
+    bcmbal_subscriber_terminal_cfg_id_password,
+    bcmbal_subscriber_terminal_cfg_id_registration_id,
+    bcmbal_subscriber_terminal_cfg_id_svc_port_id,
+} bcmbal_subscriber_terminal_cfg_id;
+
+typedef struct {
+    bcmbal_state admin_state;
+    bcmbal_status oper_status;
+    bcmbal_serial_number serial_number;
+    uint8_t password[10];
+    bcmbal_registration_id registration_id;
+    bcmbal_service_port_id svc_port_id;
+} bcmbal_subscriber_terminal_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_cfg_data data;
+} bcmbal_subscriber_terminal_cfg;
+
+typedef enum {
+    bcmbal_subscriber_terminal_auto_id_dgi = 0,
+    bcmbal_subscriber_terminal_auto_id_dowi,
+    bcmbal_subscriber_terminal_auto_id_looci,
+    bcmbal_subscriber_terminal_auto_id_oper_status_change,
+    bcmbal_subscriber_terminal_auto_id_processing_error,
+    bcmbal_subscriber_terminal_auto_id_sdi,
+    bcmbal_subscriber_terminal_auto_id_sfi,
+    bcmbal_subscriber_terminal_auto_id_sub_term_act_fail,
+    bcmbal_subscriber_terminal_auto_id_sub_term_alarm,
+    bcmbal_subscriber_terminal_auto_id_sub_term_disc,
+    bcmbal_subscriber_terminal_auto_id_sufi,
+    bcmbal_subscriber_terminal_auto_id_tiwi,
+} bcmbal_subscriber_terminal_auto_id;
+
+typedef struct {
+    bcmbal_alarm_status los;
+    bcmbal_alarm_status lob;
+    bcmbal_alarm_status lopc_miss;
+    bcmbal_alarm_status lopc_mic_error;
+} bcmbal_subscriber_terminal_alarms;
+
+typedef struct {
+    bcmbal_subscriber_terminal_alarms alarm;
+} bcmbal_subscriber_terminal_sub_term_alarm_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sub_term_alarm_data data;
+} bcmbal_subscriber_terminal_sub_term_alarm;
+
+typedef struct {
+    bcmbal_alarm_status dgi_status;
+} bcmbal_subscriber_terminal_dgi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_dgi_data data;
+} bcmbal_subscriber_terminal_dgi;
+
+typedef struct {
+    bcmbal_serial_number serial_number;
+    uint32_t reserved;
+} bcmbal_subscriber_terminal_sub_term_disc_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sub_term_disc_data data;
+} bcmbal_subscriber_terminal_sub_term_disc;
+
+typedef struct {
+    bcmbal_status new_oper_status;
+    bcmbal_status old_oper_status;
+    bcmbal_state admin_state;
+} bcmbal_subscriber_terminal_oper_status_change_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_oper_status_change_data data;
+} bcmbal_subscriber_terminal_oper_status_change;
+
+typedef struct {
+    bcmbal_alarm_status sufi_status;
+    bcmbal_sub_id last_detected_onu_id;
+} bcmbal_subscriber_terminal_sufi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sufi_data data;
+} bcmbal_subscriber_terminal_sufi;
+
+typedef struct {
+    bcmbal_alarm_status sdi_status;
+    uint8_t ber;
+} bcmbal_subscriber_terminal_sdi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sdi_data data;
+} bcmbal_subscriber_terminal_sdi;
+
+typedef struct {
+    bcmbal_alarm_status dowi_status;
+    uint32_t drift_value;
+    uint32_t new_eqd;
+} bcmbal_subscriber_terminal_dowi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_dowi_data data;
+} bcmbal_subscriber_terminal_dowi;
+
+typedef struct {
+    bcmbal_alarm_status looci_status;
+} bcmbal_subscriber_terminal_looci_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_looci_data data;
+} bcmbal_subscriber_terminal_looci;
+
+typedef struct {
+    bcmbal_alarm_status sfi_status;
+    uint8_t ber;
+} bcmbal_subscriber_terminal_sfi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sfi_data data;
+} bcmbal_subscriber_terminal_sfi;
+
+typedef struct {
+    bcmbal_alarm_status tiwi_status;
+    uint32_t drift_value;
+} bcmbal_subscriber_terminal_tiwi_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_tiwi_data data;
+} bcmbal_subscriber_terminal_tiwi;
+
+typedef struct {
+    uint32_t fail_reason;
+} bcmbal_subscriber_terminal_sub_term_act_fail_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_sub_term_act_fail_data data;
+} bcmbal_subscriber_terminal_sub_term_act_fail;
+
+typedef struct {
+    uint32_t reserved;
+} bcmbal_subscriber_terminal_processing_error_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_subscriber_terminal_key key;
+    bcmbal_subscriber_terminal_processing_error_data data;
+} bcmbal_subscriber_terminal_processing_error;
+
+/* Packet */
+
+typedef struct {
+    uint32_t reserved;
+    bcmbal_dest packet_send_dest;
+} bcmbal_packet_key;
+
+typedef enum {
+    bcmbal_packet_auto_id_bearer_channel_rx = 0,
+    bcmbal_packet_auto_id_ieee_oam_channel_rx,
+    bcmbal_packet_auto_id_itu_omci_channel_rx,
+} bcmbal_packet_auto_id;
+
+typedef enum {
+    BCMBAL_FLOW_TYPE_UPSTREAM = 1,
+    BCMBAL_FLOW_TYPE_DOWNSTREAM,
+    BCMBAL_FLOW_TYPE_BROADCAST,
+    BCMBAL_FLOW_TYPE_MULTICAST,
+} bcmbal_flow_type;
+
+typedef struct {
+    bcmbal_flow_id flow_id;
+    bcmbal_flow_type flow_type;
+    bcmbal_intf_id intf_id;
+    bcmbal_intf_type intf_type;
+    bcmbal_service_port_id svc_port;
+    bcmbal_cookie flow_cookie;
+    bcmbal_u8_list_u32_max_2048 pkt;
+} bcmbal_packet_bearer_channel_rx_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_packet_key key;
+    bcmbal_packet_bearer_channel_rx_data data;
+} bcmbal_packet_bearer_channel_rx;
+
+typedef struct {
+    bcmbal_u8_list_u32_max_2048 pkt;
+} bcmbal_packet_itu_omci_channel_rx_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_packet_key key;
+    bcmbal_packet_itu_omci_channel_rx_data data;
+} bcmbal_packet_itu_omci_channel_rx;
+
+/* Flow */
+
+typedef struct {
+    bcmbal_flow_id flow_id;
+    bcmbal_flow_type flow_type;
+} bcmbal_flow_key;
+
+typedef enum {
+    bcmbal_flow_cfg_id_admin_state = 0,
+    bcmbal_flow_cfg_id_oper_status,
+    bcmbal_flow_cfg_id_access_int_id,
+    bcmbal_flow_cfg_id_network_int_id,
+    bcmbal_flow_cfg_id_sub_term_id,
+    bcmbal_flow_cfg_id_sub_term_uni_idx,
+    bcmbal_flow_cfg_id_svc_port_id,
+    bcmbal_flow_cfg_id_agg_port_id,
+    bcmbal_flow_cfg_id_resolve_mac,
+    bcmbal_flow_cfg_id_classifier,
+    bcmbal_flow_cfg_id_action,
+    bcmbal_flow_cfg_id_sla,
+    bcmbal_flow_cfg_id_cookie,
+    bcmbal_flow_cfg_id_priority,
+    bcmbal_flow_cfg_id_group_id,
+    bcmbal_flow_cfg_id_queue,
+    bcmbal_flow_cfg_id_dba_tm_sched_id,
+} bcmbal_flow_cfg_id;
+
+typedef struct {
+    bcmbal_state admin_state;
+    bcmbal_status oper_status;
+    bcmbal_intf_id access_int_id;
+    bcmbal_intf_id network_int_id;
+    bcmbal_sub_id sub_term_id;
+    uint8_t sub_term_uni_idx;
+    bcmbal_service_port_id svc_port_id;
+    bcmbal_aggregation_port_id agg_port_id;
+    bcmos_bool resolve_mac;
+    bcmbal_classifier classifier;
+    bcmbal_action action;
+    bcmbal_cookie cookie;
+    bcmbal_flow_priority priority;
+    uint32_t group_id;
+    bcmbal_tm_queue_ref queue;
+    bcmbal_tm_sched_id dba_tm_sched_id;
+} bcmbal_flow_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_flow_key key;
+    bcmbal_flow_cfg_data data;
+} bcmbal_flow_cfg;
+
+typedef enum {
+    bcmbal_flow_stat_id_rx_packets = 0,
+    bcmbal_flow_stat_id_rx_bytes,
+    bcmbal_flow_stat_id_tx_packets,
+    bcmbal_flow_stat_id_tx_bytes,
+    bcmbal_flow_stat_id_all_properties,
+} bcmbal_flow_stat_id;
+
+typedef struct {
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+} bcmbal_flow_stat_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_flow_key key;
+    bcmbal_flow_stat_data data;
+} bcmbal_flow_stat;
+
+typedef enum {
+    bcmbal_flow_auto_id_ind = 0,
+    bcmbal_flow_auto_id_oper_status_change,
+} bcmbal_flow_auto_id;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_flow_key key;
+    bcmbal_flow_cfg_data data;
+} bcmbal_flow_ind;
+
+typedef struct {
+    bcmbal_status new_oper_status;
+    bcmbal_status old_oper_status;
+    bcmbal_state admin_state;
+} bcmbal_flow_oper_status_change_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_flow_key key;
+    bcmbal_flow_oper_status_change_data data;
+} bcmbal_flow_oper_status_change;
+
+/* Traffic management scheduler */
+
+typedef struct {
+    bcmbal_tm_sched_dir dir;
+    bcmbal_tm_sched_id id;
+} bcmbal_tm_sched_key;
+
+typedef enum {
+    bcmbal_tm_sched_cfg_id_owner = 0,
+    bcmbal_tm_sched_cfg_id_sched_type,
+    bcmbal_tm_sched_cfg_id_sched_parent,
+    bcmbal_tm_sched_cfg_id_num_priorities,
+    bcmbal_tm_sched_cfg_id_rate,
+    bcmbal_tm_sched_cfg_id_creation_mode,
+} bcmbal_tm_sched_cfg_id;
+
+typedef struct {
+    bcmbal_tm_sched_owner owner;
+    bcmbal_tm_sched_type sched_type;
+    bcmbal_tm_sched_parent sched_parent;
+    uint8_t num_priorities;
+    bcmbal_tm_shaping rate;
+    bcmbal_tm_creation_mode creation_mode;
+} bcmbal_tm_sched_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_tm_sched_key key;
+    bcmbal_tm_sched_cfg_data data;
+} bcmbal_tm_sched_cfg;
+
+typedef enum {
+    bcmbal_tm_sched_auto_id_oper_status_change = 0,
+} bcmbal_tm_sched_auto_id;
+
+typedef struct {
+    bcmbal_status new_oper_status;
+    bcmbal_status old_oper_status;
+} bcmbal_tm_sched_oper_status_change_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_tm_sched_key key;
+    bcmbal_tm_sched_oper_status_change_data data;
+} bcmbal_tm_sched_oper_status_change;
+
+/* Traffic management queue */
+
+typedef struct {
+    bcmbal_tm_sched_id sched_id;
+    bcmbal_tm_sched_dir sched_dir;
+    bcmbal_tm_queue_id id;
+} bcmbal_tm_queue_key;
+
+typedef enum {
+    bcmbal_tm_queue_cfg_id_priority = 0,
+    bcmbal_tm_queue_cfg_id_weight,
+    bcmbal_tm_queue_cfg_id_rate,
+    bcmbal_tm_queue_cfg_id_creation_mode,
+} bcmbal_tm_queue_cfg_id;
+
+typedef struct {
+    uint8_t priority;
+    uint8_t weight;
+    bcmbal_tm_shaping rate;
+    bcmbal_tm_creation_mode creation_mode;
+} bcmbal_tm_queue_cfg_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_tm_queue_key key;
+    bcmbal_tm_queue_cfg_data data;
+} bcmbal_tm_queue_cfg;
+
+typedef enum {
+    bcmbal_tm_queue_auto_id_ind = 0,
+} bcmbal_tm_queue_auto_id;
+
+typedef struct {
+    bcmbal_status ret;
+} bcmbal_tm_queue_ind_data;
+
+typedef struct {
+    bcmbal_obj hdr;
+    bcmbal_tm_queue_key key;
+    bcmbal_tm_queue_ind_data data;
+} bcmbal_tm_queue_ind;
+
+#endif
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <sys/time.h>
+#include <time.h>
+
+extern "C"
+{
+#include "bcm_dev_log_task.h"
+}
+
+// Log ids are registered from static initializers, so everything here is
+// constant initialized
+bcm_dev_log_level bcm_dev_log_levels[DEV_LOG_MAX_IDS];
+static const char* log_names[DEV_LOG_MAX_IDS];
+static std::atomic<int> log_ids(0);
+static std::atomic<int> level_override(-1);
+
+static const char* const level_names[] = { "-", "F", "E", "W", "I", "D" };
+
+dev_log_id bcm_dev_log_id_register(const char *name, bcm_dev_log_level default_level,
+                                   bcm_dev_log_id_type default_type) {
+    int id = log_ids.fetch_add(1) % DEV_LOG_MAX_IDS;
+    int level = level_override.load();
+
+    (void)default_type;
+    log_names[id] = name;
+    bcm_dev_log_levels[id] = level >= 0 ? (bcm_dev_log_level)level : default_level;
+    return id;
+}
+
+void bcm_dev_log_level_set_all(bcm_dev_log_level level) {
+    level_override = level;
+    for (int i = 0; i < DEV_LOG_MAX_IDS; i++) {
+        bcm_dev_log_levels[i] = level;
+    }
+}
+
+bcmos_errno bcm_dev_log_id_get_level(dev_log_id id, bcm_dev_log_level *p_log_level_print,
+                                     bcm_dev_log_level *p_log_level_save) {
+    *p_log_level_print = bcm_dev_log_levels[id % DEV_LOG_MAX_IDS];
+    *p_log_level_save = bcm_dev_log_levels[id % DEV_LOG_MAX_IDS];
+    return BCM_ERR_OK;
+}
+
+void bcm_dev_log_log(dev_log_id id, bcm_dev_log_level level, const char *fmt, ...) {
+    char line[1024];
+    struct timeval tv;
+    struct tm tm;
+    va_list args;
+
+    gettimeofday(&tv, NULL);
+    localtime_r(&tv.tv_sec, &tm);
+    int n = snprintf(line, sizeof(line), "[%02d:%02d:%02d.%03d %s %-8s] ",
+                     tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(tv.tv_usec / 1000),
+                     level_names[level % 6], log_names[id % DEV_LOG_MAX_IDS] ? log_names[id % DEV_LOG_MAX_IDS] : "");
+
+    va_start(args, fmt);
+    int m = vsnprintf(line + n, sizeof(line) - n, fmt, args);
+    va_end(args);
+
+    n = m < 0 ? n : (n + m < (int)sizeof(line) ? n + m : (int)sizeof(line) - 1);
+    if (n > 0 && line[n - 1] != '\n') {
+        if (n == (int)sizeof(line) - 1) {
+            n--;
+        }
+        line[n++] = '\n';
+    }
+    fwrite(line, 1, n, stdout);
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_BCM_DEV_LOG_H_
+#define MOCK_BAL_BCM_DEV_LOG_H_
+
+// The device log of the mock BAL: BCM_LOG formats in the caller and writes
+// to stdout when the level is enabled for the log id
+
+#define DEV_LOG_MAX_IDS 32
+
+typedef int dev_log_id;
+
+typedef enum {
+    DEV_LOG_LEVEL_NO_LOG = 0,
+    DEV_LOG_LEVEL_FATAL,
+    DEV_LOG_LEVEL_ERROR,
+    DEV_LOG_LEVEL_WARNING,
+    DEV_LOG_LEVEL_INFO,
+    DEV_LOG_LEVEL_DEBUG,
+} bcm_dev_log_level;
+
+typedef enum {
+    DEV_LOG_ID_TYPE_NONE = 0,
+    DEV_LOG_ID_TYPE_PRINT = 1,
+    DEV_LOG_ID_TYPE_LOGGER = 2,
+    DEV_LOG_ID_TYPE_BOTH = 3,
+} bcm_dev_log_id_type;
+
+extern bcm_dev_log_level bcm_dev_log_levels[DEV_LOG_MAX_IDS];
+
+dev_log_id bcm_dev_log_id_register(const char *name, bcm_dev_log_level default_level,
+                                   bcm_dev_log_id_type default_type);
+void bcm_dev_log_level_set_all(bcm_dev_log_level level);
+void bcm_dev_log_log(dev_log_id id, bcm_dev_log_level level, const char *fmt, ...);
+
+#define BCM_LOG(level, id, fmt, ...) \
+    do { \
+        if (DEV_LOG_LEVEL_##level <= bcm_dev_log_levels[(id) % DEV_LOG_MAX_IDS]) { \
+            bcm_dev_log_log(id, DEV_LOG_LEVEL_##level, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif
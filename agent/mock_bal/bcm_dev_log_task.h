@@ -0,0 +1,28 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_BCM_DEV_LOG_TASK_H_
+#define MOCK_BAL_BCM_DEV_LOG_TASK_H_
+
+// No log task in the mock BAL, the log is written by the caller
+#include "bcmos_system.h"
+#include "bcm_dev_log.h"
+
+bcmos_errno bcm_dev_log_id_get_level(dev_log_id id, bcm_dev_log_level *p_log_level_print,
+                                     bcm_dev_log_level *p_log_level_save);
+
+#endif
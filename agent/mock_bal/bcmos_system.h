@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCK_BAL_BCMOS_SYSTEM_H_
+#define MOCK_BAL_BCMOS_SYSTEM_H_
+
+// The part of the BAL OS abstraction the agent uses
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t bcmos_bool;
+
+#define BCMOS_FALSE 0
+#define BCMOS_TRUE  1
+
+typedef enum {
+    BCM_ERR_OK = 0,
+    BCM_ERR_IN_PROGRESS = -1,
+    BCM_ERR_PARM = -2,
+    BCM_ERR_NOMEM = -3,
+    BCM_ERR_NORES = -4,
+    BCM_ERR_INTERNAL = -5,
+    BCM_ERR_NOENT = -6,
+    BCM_ERR_NODEV = -7,
+    BCM_ERR_ALREADY = -8,
+    BCM_ERR_RANGE = -9,
+    BCM_ERR_PERM = -10,
+    BCM_ERR_NOT_SUPPORTED = -11,
+    BCM_ERR_PARSE = -12,
+    BCM_ERR_INVALID_OP = -13,
+    BCM_ERR_IO = -14,
+    BCM_ERR_STATE = -15,
+    BCM_ERR_DELETED = -16,
+    BCM_ERR_TOO_MANY = -17,
+    BCM_ERR_NO_MORE = -18,
+    BCM_ERR_OVERFLOW = -19,
+    BCM_ERR_COMM_FAIL = -20,
+    BCM_ERR_NOT_CONNECTED = -21,
+    BCM_ERR_SYSCALL_ERR = -22,
+    BCM_ERR_MSG_ERROR = -23,
+    BCM_ERR_TOO_MANY_REQS = -24,
+    BCM_ERR_TIMEOUT = -25,
+    BCM_ERR_TOO_MANY_FRAGS = -26,
+    BCM_ERR_NULL = -27,
+    BCM_ERR_READ_ONLY = -28,
+    BCM_ERR_ONU_ERR_RESP = -29,
+    BCM_ERR_MANDATORY_PARM_IS_MISSING = -30,
+    BCM_ERR_KEY_RANGE = -31,
+    BCM_ERR_QUEUE_EMPTY = -32,
+    BCM_ERR_QUEUE_FULL = -33,
+    BCM_ERR_TOO_LONG = -34,
+    BCM_ERR_INSUFFICIENT_LIST_MEM = -35,
+} bcmos_errno;
+
+typedef enum {
+    BCMOS_MODULE_ID_NONE = 0,
+} bcmos_module_id;
+
+#include "bcm_dev_log.h"
+
+#endif
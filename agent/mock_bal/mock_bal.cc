@@ -0,0 +1,1044 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "mock_bal.h"
+
+// OMCI baseline message, and the bits of its message type byte
+#define OMCI_BASELINE_LENGTH 48
+#define OMCI_MT_AR 0x40
+#define OMCI_MT_AK 0x20
+
+// The agent keeps the technology of at most 16 PONs, see core.cc
+#define MOCK_BAL_MAX_PONS 16
+#define MOCK_BAL_MAX_NNIS 16
+#define MOCK_BAL_MAX_ONUS 256
+
+// Handlers of an object's indications, a slot per subgroup and one for
+// those subscribed to every subgroup
+#define MOCK_BAL_SUBGROUPS 16
+#define MOCK_BAL_HANDLERS  4
+
+static dev_log_id mock_log_id = bcm_dev_log_id_register("MOCK_BAL", DEV_LOG_LEVEL_INFO, DEV_LOG_ID_TYPE_BOTH);
+
+static void delay(unsigned us) {
+    if (us) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+static bool uint_arg(int argc, char *argv[], int* i, const char* name, unsigned* value) {
+    if (strcmp(argv[*i], name) != 0 || *i + 1 >= argc) {
+        return false;
+    }
+    *value = strtoul(argv[++*i], NULL, 10);
+    return true;
+}
+
+class MockBal {
+  public:
+    MockBal();
+    ~MockBal();
+
+    void configure(const mock_bal_config& config);
+    bcmos_errno init(int argc, char *argv[]);
+
+    bcmos_errno cfg_set(bcmbal_cfg* obj);
+    bcmos_errno cfg_get(bcmbal_cfg* obj);
+    bcmos_errno cfg_clear(bcmbal_cfg* obj);
+    bcmos_errno stat_get(bcmbal_stat* obj, bool clear_on_read);
+    bcmos_errno pkt_send(const bcmbal_dest& dest, const char* pkt, uint16_t len);
+    bcmos_errno subscribe(const bcmbal_cb_cfg* cb_cfg);
+    bcmos_errno dispatch(bcmbal_obj* obj);
+
+    void get_counters(mock_bal_counters* counters);
+    std::string counters_to_str();
+
+    std::atomic<uint64_t> injected;
+
+  private:
+    struct SubTerm {
+        bcmbal_state admin_state;
+        bool up;
+        bcmbal_serial_number serial_number;
+    };
+
+    struct Flow {
+        bcmbal_flow_cfg_data cfg;
+        uint64_t presence_mask;
+        uint64_t rx_packets;
+        uint64_t rx_bytes;
+    };
+
+    struct PortCounters {
+        uint64_t rx_packets;
+        uint64_t rx_bytes;
+        uint64_t tx_packets;
+        uint64_t tx_bytes;
+    };
+
+    struct Intf {
+        bcmbal_state admin_state;
+        PortCounters counters;
+    };
+
+    struct Handlers {
+        f_bcmbal_ind_handler fn[MOCK_BAL_HANDLERS];
+        std::atomic<unsigned> count;
+    };
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    static uint32_t sub_term_key(uint32_t intf_id, uint32_t sub_term_id) {
+        return (intf_id << 16) | (sub_term_id & 0xffff);
+    }
+    static uint64_t flow_key(const bcmbal_flow_key& key) {
+        return ((uint64_t)key.flow_id << 1) | (key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM);
+    }
+
+    Intf* find_intf(const bcmbal_interface_key& key);
+    bcmos_errno set_access_terminal(bcmbal_access_terminal_cfg* cfg);
+    bcmos_errno set_interface(bcmbal_interface_cfg* cfg);
+    bcmos_errno set_sub_term(bcmbal_subscriber_terminal_cfg* cfg);
+    bcmos_errno set_flow(bcmbal_flow_cfg* cfg);
+    void discover(uint32_t intf_id);
+    void sub_term_up(uint32_t key);
+    void sub_term_status(const bcmbal_subscriber_terminal_key& key, bcmbal_status old_status,
+                         bcmbal_status new_status, bcmbal_state admin_state);
+    void generate_packets(unsigned count);
+
+    void run();
+    void tick(TimePoint now);
+    void after(unsigned us, const std::function<void()>& fn);
+    bcmos_errno result(bcmos_errno err);
+
+    // Whether the packet-out being sent is one of those to fail
+    bool fail_packet() {
+        return config_.pkt_fail_every && ++pkts_out_ % config_.pkt_fail_every == 0;
+    }
+
+    // Has the indication ind run once the lock is released
+    template <typename T>
+    void emit(const T& ind) {
+        T copy = ind;
+        ready_.push_back([this, copy]() mutable {
+            dispatch(&copy.hdr);
+        });
+        indications_++;
+    }
+
+    mock_bal_config config_;
+    bool started_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool stopping_;
+
+    bcmbal_state olt_admin_state_;
+    std::vector<Intf> pons_;
+    std::vector<Intf> nnis_;
+    std::map<uint32_t, SubTerm> sub_terms_;
+    std::map<uint64_t, Flow> flows_;
+    std::vector<uint64_t> traps_;   // keys of the flows that trap to host
+    std::set<uint64_t> scheds_;     // (dir << 32) | id
+    std::set<uint64_t> queues_;     // (sched_id << 8) | id
+    std::multimap<TimePoint, std::function<void()> > timers_;
+    std::vector<std::function<void()> > ready_;
+    std::string pkt_;
+    size_t trap_cursor_;
+    double pkt_credit_;
+    TimePoint last_tick_;
+    TimePoint next_report_;
+    uint64_t onus_up_;
+    uint64_t pkts_out_;             // to ONUs and NNIs
+
+    Handlers handlers_[BCMBAL_OBJ_ID__NUM_OF][MOCK_BAL_SUBGROUPS + 1];
+    std::mutex handlers_mutex_;
+
+    std::atomic<uint64_t> cfg_set_;
+    std::atomic<uint64_t> cfg_get_;
+    std::atomic<uint64_t> cfg_clear_;
+    std::atomic<uint64_t> stat_get_;
+    std::atomic<uint64_t> pkt_send_;
+    std::atomic<uint64_t> omci_requests_;
+    std::atomic<uint64_t> failed_;
+    std::atomic<uint64_t> indications_;
+    std::atomic<uint64_t> pkt_in_;
+};
+
+static MockBal mockBal;
+
+mock_bal_config mock_bal_default_config() {
+    mock_bal_config config;
+
+    config.pons = 16;
+    config.nnis = 1;
+    config.onus = 32;
+    config.gpon = false;
+    config.cfg_us = 200;
+    config.stat_us = 200;
+    config.pkt_us = 20;
+    config.ind_us = 1000;
+    config.activation_ms = 200;
+    config.omci_us = 2000;
+    config.pkt_in_rate = 0;
+    config.pkt_in_size = 64;
+    config.pkt_fail_every = 0;
+    config.log_level = DEV_LOG_LEVEL_INFO;
+    config.report_period = 0;
+    return config;
+}
+
+MockBal::MockBal() :
+    injected(0), config_(mock_bal_default_config()), started_(false), stopping_(false),
+    olt_admin_state_(BCMBAL_STATE_DOWN), trap_cursor_(0), pkt_credit_(0), onus_up_(0), pkts_out_(0),
+    cfg_set_(0), cfg_get_(0), cfg_clear_(0), stat_get_(0), pkt_send_(0), omci_requests_(0),
+    failed_(0), indications_(0), pkt_in_(0) {
+    for (int i = 0; i < BCMBAL_OBJ_ID__NUM_OF; i++) {
+        for (int j = 0; j <= MOCK_BAL_SUBGROUPS; j++) {
+            handlers_[i][j].count = 0;
+        }
+    }
+    configure(config_);
+}
+
+MockBal::~MockBal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MockBal::configure(const mock_bal_config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (started_) {
+        return;
+    }
+    config_ = config;
+    config_.pons = std::min(std::max(config_.pons, 1u), (unsigned)MOCK_BAL_MAX_PONS);
+    config_.nnis = std::min(std::max(config_.nnis, 1u), (unsigned)MOCK_BAL_MAX_NNIS);
+    config_.onus = std::min(config_.onus, (unsigned)MOCK_BAL_MAX_ONUS);
+    config_.pkt_in_size = std::min(std::max(config_.pkt_in_size, 14u), 2048u);
+
+    Intf intf;
+    memset(&intf, 0, sizeof(intf));
+    intf.admin_state = BCMBAL_STATE_DOWN;
+    pons_.assign(config_.pons, intf);
+    nnis_.assign(config_.nnis, intf);
+    pkt_.assign(config_.pkt_in_size, '\xa5');
+}
+
+bcmos_errno MockBal::init(int argc, char *argv[]) {
+    mock_bal_config config = config_;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mock-gpon") == 0) {
+            config.gpon = true;
+        } else if (uint_arg(argc, argv, &i, "--mock-pons", &config.pons) ||
+                   uint_arg(argc, argv, &i, "--mock-nnis", &config.nnis) ||
+                   uint_arg(argc, argv, &i, "--mock-onus", &config.onus) ||
+                   uint_arg(argc, argv, &i, "--mock-cfg-us", &config.cfg_us) ||
+                   uint_arg(argc, argv, &i, "--mock-stat-us", &config.stat_us) ||
+                   uint_arg(argc, argv, &i, "--mock-pkt-us", &config.pkt_us) ||
+                   uint_arg(argc, argv, &i, "--mock-ind-us", &config.ind_us) ||
+                   uint_arg(argc, argv, &i, "--mock-activation-ms", &config.activation_ms) ||
+                   uint_arg(argc, argv, &i, "--mock-omci-us", &config.omci_us) ||
+                   uint_arg(argc, argv, &i, "--mock-pkt-in-rate", &config.pkt_in_rate) ||
+                   uint_arg(argc, argv, &i, "--mock-pkt-in-size", &config.pkt_in_size) ||
+                   uint_arg(argc, argv, &i, "--mock-pkt-fail-every", &config.pkt_fail_every) ||
+                   uint_arg(argc, argv, &i, "--mock-log-level", &config.log_level) ||
+                   uint_arg(argc, argv, &i, "--mock-report", &config.report_period)) {
+            continue;
+        }
+    }
+    configure(config);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_) {
+        return BCM_ERR_ALREADY;
+    }
+    started_ = true;
+    bcm_dev_log_level_set_all((bcm_dev_log_level)std::min(config_.log_level, (unsigned)DEV_LOG_LEVEL_DEBUG));
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    BCM_LOG(INFO, mock_log_id, "mock BAL: %u PONs of %u ONUs, %u NNIs, %s, "
+            "latency cfg %u us stat %u us pkt %u us ind %u us activation %u ms omci %u us, "
+            "packet-in %u/s of %u bytes, packet-out failure every %u\n",
+            config_.pons, config_.onus, config_.nnis, config_.gpon ? "gpon" : "xgspon",
+            config_.cfg_us, config_.stat_us, config_.pkt_us, config_.ind_us,
+            config_.activation_ms, config_.omci_us, config_.pkt_in_rate, config_.pkt_in_size,
+            config_.pkt_fail_every);
+
+    last_tick_ = std::chrono::steady_clock::now();
+    next_report_ = last_tick_ + std::chrono::seconds(config_.report_period);
+    thread_ = std::thread(&MockBal::run, this);
+    return BCM_ERR_OK;
+}
+
+bcmos_errno MockBal::result(bcmos_errno err) {
+    if (err != BCM_ERR_OK) {
+        failed_++;
+    }
+    return err;
+}
+
+MockBal::Intf* MockBal::find_intf(const bcmbal_interface_key& key) {
+    std::vector<Intf>& intfs = key.intf_type == BCMBAL_INTF_TYPE_PON ? pons_ : nnis_;
+    return key.intf_id < intfs.size() ? &intfs[key.intf_id] : NULL;
+}
+
+/* Configuration */
+
+bcmos_errno MockBal::cfg_set(bcmbal_cfg* obj) {
+    cfg_set_++;
+    delay(config_.cfg_us);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        return result(BCM_ERR_NOT_CONNECTED);
+    }
+
+    switch (obj->obj_type) {
+    case BCMBAL_OBJ_ID_ACCESS_TERMINAL:
+        return result(set_access_terminal((bcmbal_access_terminal_cfg*)obj));
+    case BCMBAL_OBJ_ID_INTERFACE:
+        return result(set_interface((bcmbal_interface_cfg*)obj));
+    case BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL:
+        return result(set_sub_term((bcmbal_subscriber_terminal_cfg*)obj));
+    case BCMBAL_OBJ_ID_FLOW:
+        return result(set_flow((bcmbal_flow_cfg*)obj));
+    case BCMBAL_OBJ_ID_TM_SCHED: {
+        bcmbal_tm_sched_cfg* cfg = (bcmbal_tm_sched_cfg*)obj;
+        bcmbal_tm_sched_oper_status_change ind;
+        uint64_t key = ((uint64_t)cfg->key.dir << 32) | cfg->key.id;
+
+        if (scheds_.insert(key).second) {
+            BCMBAL_OBJ_INIT(&ind, tm_sched, cfg->key, BCMBAL_MGT_GROUP_AUTO,
+                            bcmbal_tm_sched_auto_id_oper_status_change);
+            ind.data.new_oper_status = BCMBAL_STATUS_UP;
+            ind.data.old_oper_status = BCMBAL_STATUS_DOWN;
+            after(config_.ind_us, [this, ind]() { emit(ind); });
+        }
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_TM_QUEUE: {
+        bcmbal_tm_queue_cfg* cfg = (bcmbal_tm_queue_cfg*)obj;
+        queues_.insert(((uint64_t)cfg->key.sched_id << 8) | cfg->key.id);
+        return BCM_ERR_OK;
+    }
+    default:
+        return result(BCM_ERR_NOT_SUPPORTED);
+    }
+}
+
+bcmos_errno MockBal::set_access_terminal(bcmbal_access_terminal_cfg* cfg) {
+    bcmbal_access_terminal_oper_status_change ind;
+
+    if (!BCMBAL_CFG_PROP_IS_SET(cfg, access_terminal, admin_state) ||
+        cfg->data.admin_state == olt_admin_state_) {
+        return BCM_ERR_OK;
+    }
+    olt_admin_state_ = cfg->data.admin_state;
+
+    BCMBAL_OBJ_INIT(&ind, access_terminal, cfg->key, BCMBAL_MGT_GROUP_AUTO,
+                    bcmbal_access_terminal_auto_id_oper_status_change);
+    ind.data.admin_state = olt_admin_state_;
+    ind.data.new_oper_status = olt_admin_state_ == BCMBAL_STATE_UP ? BCMBAL_STATUS_UP : BCMBAL_STATUS_DOWN;
+    ind.data.old_oper_status = olt_admin_state_ == BCMBAL_STATE_UP ? BCMBAL_STATUS_DOWN : BCMBAL_STATUS_UP;
+    after(config_.ind_us, [this, ind]() { emit(ind); });
+    return BCM_ERR_OK;
+}
+
+bcmos_errno MockBal::set_interface(bcmbal_interface_cfg* cfg) {
+    bcmbal_interface_oper_status_change ind;
+    Intf* intf = find_intf(cfg->key);
+
+    if (intf == NULL) {
+        return BCM_ERR_RANGE;
+    }
+    if (!BCMBAL_CFG_PROP_IS_SET(cfg, interface, admin_state) ||
+        cfg->data.admin_state == intf->admin_state) {
+        return BCM_ERR_OK;
+    }
+    intf->admin_state = cfg->data.admin_state;
+
+    BCMBAL_OBJ_INIT(&ind, interface, cfg->key, BCMBAL_MGT_GROUP_AUTO,
+                    bcmbal_interface_auto_id_oper_status_change);
+    ind.data.admin_state = intf->admin_state;
+    ind.data.new_oper_status = intf->admin_state == BCMBAL_STATE_UP ? BCMBAL_STATUS_UP : BCMBAL_STATUS_DOWN;
+    ind.data.old_oper_status = intf->admin_state == BCMBAL_STATE_UP ? BCMBAL_STATUS_DOWN : BCMBAL_STATUS_UP;
+
+    uint32_t intf_id = cfg->key.intf_id;
+    bool pon_up = cfg->key.intf_type == BCMBAL_INTF_TYPE_PON && intf->admin_state == BCMBAL_STATE_UP;
+    after(config_.ind_us, [this, ind, intf_id, pon_up]() {
+        emit(ind);
+        if (pon_up) {
+            discover(intf_id);
+        }
+    });
+    return BCM_ERR_OK;
+}
+
+// The ONUs of a PON that just came up, other than those activated already,
+// show up with serial numbers MOCK<pon><index>
+void MockBal::discover(uint32_t intf_id) {
+    bcmbal_subscriber_terminal_sub_term_disc ind;
+    bcmbal_subscriber_terminal_key key = { 0, intf_id };
+
+    if (pons_[intf_id].admin_state != BCMBAL_STATE_UP) {
+        return;
+    }
+    BCMBAL_OBJ_INIT(&ind, subscriber_terminal, key, BCMBAL_MGT_GROUP_AUTO,
+                    bcmbal_subscriber_terminal_auto_id_sub_term_disc);
+    memcpy(ind.data.serial_number.vendor_id, "MOCK", 4);
+
+    for (unsigned i = 0; i < config_.onus; i++) {
+        uint8_t* vs = ind.data.serial_number.vendor_specific;
+        vs[0] = (uint8_t)intf_id;
+        vs[1] = (uint8_t)(i >> 8);
+        vs[2] = (uint8_t)i;
+        vs[3] = 0x5a;
+
+        bool active = false;
+        for (std::map<uint32_t, SubTerm>::const_iterator it = sub_terms_.lower_bound(sub_term_key(intf_id, 0));
+             it != sub_terms_.end() && (it->first >> 16) == intf_id && !active; ++it) {
+            active = it->second.admin_state == BCMBAL_STATE_UP &&
+                     memcmp(&it->second.serial_number, &ind.data.serial_number, sizeof(bcmbal_serial_number)) == 0;
+        }
+        if (!active) {
+            emit(ind);
+        }
+    }
+}
+
+bcmos_errno MockBal::set_sub_term(bcmbal_subscriber_terminal_cfg* cfg) {
+    if (cfg->key.intf_id >= pons_.size()) {
+        return BCM_ERR_RANGE;
+    }
+
+    uint32_t key = sub_term_key(cfg->key.intf_id, cfg->key.sub_term_id);
+    std::map<uint32_t, SubTerm>::iterator it = sub_terms_.find(key);
+    if (it == sub_terms_.end()) {
+        SubTerm sub_term;
+        memset(&sub_term, 0, sizeof(sub_term));
+        sub_term.admin_state = BCMBAL_STATE_DOWN;
+        it = sub_terms_.insert(std::make_pair(key, sub_term)).first;
+    }
+    SubTerm& sub_term = it->second;
+
+    if (BCMBAL_CFG_PROP_IS_SET(cfg, subscriber_terminal, serial_number)) {
+        sub_term.serial_number = cfg->data.serial_number;
+    }
+    if (!BCMBAL_CFG_PROP_IS_SET(cfg, subscriber_terminal, admin_state) ||
+        cfg->data.admin_state == sub_term.admin_state) {
+        return BCM_ERR_OK;
+    }
+    sub_term.admin_state = cfg->data.admin_state;
+
+    if (sub_term.admin_state == BCMBAL_STATE_UP) {
+        after(config_.activation_ms * 1000, [this, key]() { sub_term_up(key); });
+    } else if (sub_term.up) {
+        sub_term.up = false;
+        onus_up_--;
+        bcmbal_subscriber_terminal_key ind_key = cfg->key;
+        after(config_.ind_us, [this, ind_key]() {
+            sub_term_status(ind_key, BCMBAL_STATUS_UP, BCMBAL_STATUS_DOWN, BCMBAL_STATE_DOWN);
+        });
+    }
+    return BCM_ERR_OK;
+}
+
+void MockBal::sub_term_up(uint32_t key) {
+    std::map<uint32_t, SubTerm>::iterator it = sub_terms_.find(key);
+    if (it == sub_terms_.end() || it->second.up || it->second.admin_state != BCMBAL_STATE_UP ||
+        pons_[key >> 16].admin_state != BCMBAL_STATE_UP) {
+        return;
+    }
+    it->second.up = true;
+    onus_up_++;
+
+    bcmbal_subscriber_terminal_key ind_key = { key & 0xffff, key >> 16 };
+    sub_term_status(ind_key, BCMBAL_STATUS_DOWN, BCMBAL_STATUS_UP, BCMBAL_STATE_UP);
+}
+
+void MockBal::sub_term_status(const bcmbal_subscriber_terminal_key& key, bcmbal_status old_status,
+                              bcmbal_status new_status, bcmbal_state admin_state) {
+    bcmbal_subscriber_terminal_oper_status_change ind;
+
+    BCMBAL_OBJ_INIT(&ind, subscriber_terminal, key, BCMBAL_MGT_GROUP_AUTO,
+                    bcmbal_subscriber_terminal_auto_id_oper_status_change);
+    ind.data.new_oper_status = new_status;
+    ind.data.old_oper_status = old_status;
+    ind.data.admin_state = admin_state;
+    emit(ind);
+}
+
+bcmos_errno MockBal::set_flow(bcmbal_flow_cfg* cfg) {
+    uint64_t key = flow_key(cfg->key);
+
+    if ((BCMBAL_CFG_PROP_IS_SET(cfg, flow, access_int_id) && cfg->data.access_int_id >= pons_.size()) ||
+        (BCMBAL_CFG_PROP_IS_SET(cfg, flow, network_int_id) && cfg->data.network_int_id >= nnis_.size())) {
+        return BCM_ERR_RANGE;
+    }
+    bool is_new = flows_.find(key) == flows_.end();
+    Flow& flow = flows_[key];
+
+    if (is_new) {
+        memset(&flow, 0, sizeof(flow));
+    }
+    flow.cfg = cfg->data;
+    flow.presence_mask |= cfg->hdr.presence_mask;
+
+    std::vector<uint64_t>::iterator trap = std::find(traps_.begin(), traps_.end(), key);
+    if (flow.cfg.action.cmds_bitmask & BCMBAL_ACTION_CMD_ID_TRAP_TO_HOST) {
+        if (trap == traps_.end()) {
+            traps_.push_back(key);
+        }
+    } else if (trap != traps_.end()) {
+        traps_.erase(trap);
+    }
+
+    if (is_new) {
+        bcmbal_flow_oper_status_change ind;
+        BCMBAL_OBJ_INIT(&ind, flow, cfg->key, BCMBAL_MGT_GROUP_AUTO,
+                        bcmbal_flow_auto_id_oper_status_change);
+        ind.data.new_oper_status = BCMBAL_STATUS_UP;
+        ind.data.old_oper_status = BCMBAL_STATUS_DOWN;
+        ind.data.admin_state = BCMBAL_STATE_UP;
+        after(config_.ind_us, [this, ind]() { emit(ind); });
+    }
+    return BCM_ERR_OK;
+}
+
+bcmos_errno MockBal::cfg_get(bcmbal_cfg* obj) {
+    cfg_get_++;
+    delay(config_.cfg_us);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        return result(BCM_ERR_NOT_CONNECTED);
+    }
+
+    switch (obj->obj_type) {
+    case BCMBAL_OBJ_ID_ACCESS_TERMINAL: {
+        bcmbal_access_terminal_cfg* cfg = (bcmbal_access_terminal_cfg*)obj;
+        cfg->data.admin_state = olt_admin_state_;
+        cfg->data.oper_status = olt_admin_state_ == BCMBAL_STATE_UP ? BCMBAL_STATUS_UP : BCMBAL_STATUS_DOWN;
+        cfg->data.topology.num_of_nni_ports = nnis_.size();
+        cfg->data.topology.num_of_pon_ports = pons_.size();
+        cfg->data.topology.num_of_mac_devs = (pons_.size() + 7) / 8;
+        cfg->data.topology.num_of_pons_per_mac_dev = std::min(pons_.size(), (size_t)8);
+        cfg->data.topology.pon_family = BCMBAL_PON_FAMILY_GPON;
+        cfg->data.topology.pon_sub_family = config_.gpon ? BCMBAL_PON_SUB_FAMILY_GPON : BCMBAL_PON_SUB_FAMILY_XGS;
+        cfg->data.sw_version.major_rev = 2;
+        cfg->data.sw_version.minor_rev = 6;
+        cfg->data.sw_version.release_rev = 0;
+        cfg->data.sw_version.om_version = 0;
+        cfg->data.conn_id = 0;
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_INTERFACE: {
+        bcmbal_interface_cfg* cfg = (bcmbal_interface_cfg*)obj;
+        Intf* intf = find_intf(cfg->key);
+        if (intf == NULL) {
+            return result(BCM_ERR_RANGE);
+        }
+        cfg->data.admin_state = intf->admin_state;
+        cfg->data.oper_status = intf->admin_state == BCMBAL_STATE_UP ? BCMBAL_STATUS_UP : BCMBAL_STATUS_DOWN;
+        cfg->data.transceiver_type = config_.gpon ? BCMBAL_TRX_TYPE_GPON_SPS_43_48 : BCMBAL_TRX_TYPE_XGPON_LTH_7226_PC;
+        cfg->data.mtu = 9600;
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL: {
+        bcmbal_subscriber_terminal_cfg* cfg = (bcmbal_subscriber_terminal_cfg*)obj;
+        std::map<uint32_t, SubTerm>::const_iterator it =
+            sub_terms_.find(sub_term_key(cfg->key.intf_id, cfg->key.sub_term_id));
+        if (it == sub_terms_.end()) {
+            return result(BCM_ERR_NOENT);
+        }
+        cfg->data.admin_state = it->second.admin_state;
+        cfg->data.oper_status = it->second.up ? BCMBAL_STATUS_UP : BCMBAL_STATUS_DOWN;
+        cfg->data.serial_number = it->second.serial_number;
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_FLOW: {
+        bcmbal_flow_cfg* cfg = (bcmbal_flow_cfg*)obj;
+        std::map<uint64_t, Flow>::const_iterator it = flows_.find(flow_key(cfg->key));
+        if (it == flows_.end()) {
+            return result(BCM_ERR_NOENT);
+        }
+        cfg->data = it->second.cfg;
+        cfg->data.oper_status = BCMBAL_STATUS_UP;
+        return BCM_ERR_OK;
+    }
+    default:
+        return result(BCM_ERR_NOT_SUPPORTED);
+    }
+}
+
+// As BAL, a subscriber terminal has to be disabled before it is removed
+bcmos_errno MockBal::cfg_clear(bcmbal_cfg* obj) {
+    cfg_clear_++;
+    delay(config_.cfg_us);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        return result(BCM_ERR_NOT_CONNECTED);
+    }
+
+    switch (obj->obj_type) {
+    case BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL: {
+        bcmbal_subscriber_terminal_cfg* cfg = (bcmbal_subscriber_terminal_cfg*)obj;
+        std::map<uint32_t, SubTerm>::iterator it =
+            sub_terms_.find(sub_term_key(cfg->key.intf_id, cfg->key.sub_term_id));
+        if (it == sub_terms_.end()) {
+            return result(BCM_ERR_NOENT);
+        }
+        if (it->second.admin_state == BCMBAL_STATE_UP) {
+            return result(BCM_ERR_STATE);
+        }
+        sub_terms_.erase(it);
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_FLOW: {
+        uint64_t key = flow_key(((bcmbal_flow_cfg*)obj)->key);
+        if (flows_.erase(key) == 0) {
+            return result(BCM_ERR_NOENT);
+        }
+        std::vector<uint64_t>::iterator trap = std::find(traps_.begin(), traps_.end(), key);
+        if (trap != traps_.end()) {
+            traps_.erase(trap);
+        }
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_TM_SCHED: {
+        bcmbal_tm_sched_cfg* cfg = (bcmbal_tm_sched_cfg*)obj;
+        if (scheds_.erase(((uint64_t)cfg->key.dir << 32) | cfg->key.id) == 0) {
+            return result(BCM_ERR_NOENT);
+        }
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_TM_QUEUE: {
+        bcmbal_tm_queue_cfg* cfg = (bcmbal_tm_queue_cfg*)obj;
+        if (queues_.erase(((uint64_t)cfg->key.sched_id << 8) | cfg->key.id) == 0) {
+            return result(BCM_ERR_NOENT);
+        }
+        return BCM_ERR_OK;
+    }
+    default:
+        return result(BCM_ERR_NOT_SUPPORTED);
+    }
+}
+
+/* Statistics and packets */
+
+bcmos_errno MockBal::stat_get(bcmbal_stat* obj, bool clear_on_read) {
+    stat_get_++;
+    delay(config_.stat_us);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        return result(BCM_ERR_NOT_CONNECTED);
+    }
+
+    switch (obj->obj_type) {
+    case BCMBAL_OBJ_ID_INTERFACE: {
+        bcmbal_interface_stat* stat = (bcmbal_interface_stat*)obj;
+        Intf* intf = find_intf(stat->key);
+        if (intf == NULL) {
+            return result(BCM_ERR_RANGE);
+        }
+        memset(&stat->data, 0, sizeof(stat->data));
+        stat->data.rx_packets = stat->data.rx_ucast_packets = intf->counters.rx_packets;
+        stat->data.rx_bytes = intf->counters.rx_bytes;
+        stat->data.tx_packets = stat->data.tx_ucast_packets = intf->counters.tx_packets;
+        stat->data.tx_bytes = intf->counters.tx_bytes;
+        if (clear_on_read) {
+            memset(&intf->counters, 0, sizeof(intf->counters));
+        }
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_OBJ_ID_FLOW: {
+        bcmbal_flow_stat* stat = (bcmbal_flow_stat*)obj;
+        std::map<uint64_t, Flow>::iterator it = flows_.find(flow_key(stat->key));
+        if (it == flows_.end()) {
+            return result(BCM_ERR_NOENT);
+        }
+        memset(&stat->data, 0, sizeof(stat->data));
+        stat->data.rx_packets = it->second.rx_packets;
+        stat->data.rx_bytes = it->second.rx_bytes;
+        if (clear_on_read) {
+            it->second.rx_packets = it->second.rx_bytes = 0;
+        }
+        return BCM_ERR_OK;
+    }
+    default:
+        return result(BCM_ERR_NOT_SUPPORTED);
+    }
+}
+
+// An OMCI request is answered with an acknowledgement, as from an ONU that
+// applies every request; other packets are only counted
+bcmos_errno MockBal::pkt_send(const bcmbal_dest& dest, const char* pkt, uint16_t len) {
+    pkt_send_++;
+    delay(config_.pkt_us);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        return result(BCM_ERR_NOT_CONNECTED);
+    }
+
+    switch (dest.type) {
+    case BCMBAL_DEST_TYPE_ITU_OMCI_CHANNEL: {
+        uint32_t intf_id = dest.u.itu_omci_channel.intf_id;
+        uint32_t key = sub_term_key(intf_id, dest.u.itu_omci_channel.sub_term_id);
+
+        omci_requests_++;
+        std::map<uint32_t, SubTerm>::const_iterator it = sub_terms_.find(key);
+        if (intf_id >= pons_.size() || it == sub_terms_.end()) {
+            return result(BCM_ERR_NOENT);
+        }
+        pons_[intf_id].counters.tx_packets++;
+        pons_[intf_id].counters.tx_bytes += len;
+        if (!it->second.up) {
+            return BCM_ERR_OK;
+        }
+
+        std::string response(pkt, std::min((size_t)len, (size_t)OMCI_BASELINE_LENGTH));
+        response.resize(OMCI_BASELINE_LENGTH, '\0');
+        response[2] = (response[2] & ~OMCI_MT_AR) | OMCI_MT_AK;
+        response[8] = 0;    // success
+
+        bcmbal_dest from = dest;
+        after(config_.omci_us, [this, key, from, response]() {
+            std::map<uint32_t, SubTerm>::const_iterator it = sub_terms_.find(key);
+            if (it == sub_terms_.end() || !it->second.up) {
+                return;
+            }
+            ready_.push_back([this, from, response]() {
+                bcmbal_packet_itu_omci_channel_rx ind;
+                bcmbal_packet_key key = { 0, from };
+                BCMBAL_OBJ_INIT(&ind, packet, key, BCMBAL_MGT_GROUP_AUTO,
+                                bcmbal_packet_auto_id_itu_omci_channel_rx);
+                ind.data.pkt.val = (uint8_t*)response.data();
+                ind.data.pkt.len = response.size();
+                dispatch(&ind.hdr);
+            });
+            indications_++;
+            pons_[from.u.itu_omci_channel.intf_id].counters.rx_packets++;
+            pons_[from.u.itu_omci_channel.intf_id].counters.rx_bytes += response.size();
+        });
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_DEST_TYPE_SUB_TERM:
+    case BCMBAL_DEST_TYPE_SVC_PORT: {
+        uint32_t intf_id = dest.type == BCMBAL_DEST_TYPE_SUB_TERM ?
+            dest.u.sub_term.intf_id : dest.u.svc_port.intf_id;
+        if (intf_id >= pons_.size()) {
+            return result(BCM_ERR_RANGE);
+        }
+        if (fail_packet()) {
+            return result(BCM_ERR_IO);
+        }
+        pons_[intf_id].counters.tx_packets++;
+        pons_[intf_id].counters.tx_bytes += len;
+        return BCM_ERR_OK;
+    }
+    case BCMBAL_DEST_TYPE_NNI:
+        if (dest.u.nni.intf_id >= nnis_.size()) {
+            return result(BCM_ERR_RANGE);
+        }
+        if (fail_packet()) {
+            return result(BCM_ERR_IO);
+        }
+        nnis_[dest.u.nni.intf_id].counters.tx_packets++;
+        nnis_[dest.u.nni.intf_id].counters.tx_bytes += len;
+        return BCM_ERR_OK;
+    default:
+        return result(BCM_ERR_PARM);
+    }
+}
+
+// count packets from the trap flows in turn. Flows of an ONU only trap
+// while it is up.
+void MockBal::generate_packets(unsigned count) {
+    unsigned idle = 0;
+
+    while (count > 0 && !traps_.empty() && idle < traps_.size()) {
+        trap_cursor_ = (trap_cursor_ + 1) % traps_.size();
+        Flow& flow = flows_[traps_[trap_cursor_]];
+        bool pon = (flow.presence_mask & (1ULL << bcmbal_flow_cfg_id_access_int_id)) != 0;
+        uint32_t intf_id = pon ? flow.cfg.access_int_id : flow.cfg.network_int_id;
+
+        if (pon && (flow.presence_mask & (1ULL << bcmbal_flow_cfg_id_sub_term_id))) {
+            std::map<uint32_t, SubTerm>::const_iterator it =
+                sub_terms_.find(sub_term_key(intf_id, flow.cfg.sub_term_id));
+            if (it == sub_terms_.end() || !it->second.up) {
+                idle++;
+                continue;
+            }
+        }
+        if (intf_id >= (pon ? pons_.size() : nnis_.size())) {
+            idle++;
+            continue;
+        }
+        idle = 0;
+        count--;
+
+        bcmbal_packet_bearer_channel_rx ind;
+        bcmbal_packet_key key = { };
+        BCMBAL_OBJ_INIT(&ind, packet, key, BCMBAL_MGT_GROUP_AUTO,
+                        bcmbal_packet_auto_id_bearer_channel_rx);
+        ind.data.flow_id = traps_[trap_cursor_] >> 1;
+        ind.data.flow_type = (traps_[trap_cursor_] & 1) ? BCMBAL_FLOW_TYPE_DOWNSTREAM : BCMBAL_FLOW_TYPE_UPSTREAM;
+        ind.data.intf_id = intf_id;
+        ind.data.intf_type = pon ? BCMBAL_INTF_TYPE_PON : BCMBAL_INTF_TYPE_NNI;
+        ind.data.svc_port = flow.cfg.svc_port_id;
+        ind.data.flow_cookie = flow.cfg.cookie;
+        ind.data.pkt.val = (uint8_t*)pkt_.data();
+        ind.data.pkt.len = pkt_.size();
+        emit(ind);
+
+        Intf& intf = pon ? pons_[intf_id] : nnis_[intf_id];
+        intf.counters.rx_packets++;
+        intf.counters.rx_bytes += pkt_.size();
+        flow.rx_packets++;
+        flow.rx_bytes += pkt_.size();
+        pkt_in_++;
+    }
+}
+
+/* Indications */
+
+bcmos_errno MockBal::subscribe(const bcmbal_cb_cfg* cb_cfg) {
+    unsigned subgroup = cb_cfg->p_subgroup ? *cb_cfg->p_subgroup : MOCK_BAL_SUBGROUPS;
+
+    if (cb_cfg->obj_type >= BCMBAL_OBJ_ID__NUM_OF || subgroup > MOCK_BAL_SUBGROUPS ||
+        cb_cfg->ind_cb_hdlr == NULL) {
+        return result(BCM_ERR_PARM);
+    }
+
+    std::lock_guard<std::mutex> lock(handlers_mutex_);
+    Handlers& handlers = handlers_[cb_cfg->obj_type][subgroup];
+    unsigned count = handlers.count.load(std::memory_order_relaxed);
+    if (count == MOCK_BAL_HANDLERS) {
+        return result(BCM_ERR_TOO_MANY);
+    }
+    handlers.fn[count] = cb_cfg->ind_cb_hdlr;
+    handlers.count.store(count + 1, std::memory_order_release);
+    return BCM_ERR_OK;
+}
+
+// Handlers are only ever added, so they are read without the lock
+bcmos_errno MockBal::dispatch(bcmbal_obj* obj) {
+    bool handled = false;
+
+    if (obj->obj_type >= BCMBAL_OBJ_ID__NUM_OF || obj->subgroup >= MOCK_BAL_SUBGROUPS) {
+        return BCM_ERR_PARM;
+    }
+    const Handlers* slots[2] = {
+        &handlers_[obj->obj_type][obj->subgroup],
+        &handlers_[obj->obj_type][MOCK_BAL_SUBGROUPS],
+    };
+    for (int i = 0; i < 2; i++) {
+        unsigned count = slots[i]->count.load(std::memory_order_acquire);
+        for (unsigned j = 0; j < count; j++) {
+            slots[i]->fn[j](obj);
+            handled = true;
+        }
+    }
+    return handled ? BCM_ERR_OK : BCM_ERR_NOENT;
+}
+
+void MockBal::after(unsigned us, const std::function<void()>& fn) {
+    timers_.insert(std::make_pair(std::chrono::steady_clock::now() + std::chrono::microseconds(us), fn));
+    cv_.notify_one();
+}
+
+// Timers and the packet generator run under the lock; the indications they
+// emit run after it is released, so handlers may call back into the mock
+void MockBal::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    TimePoint next_tick = std::chrono::steady_clock::now();
+    std::vector<std::function<void()> > ready;
+
+    while (!stopping_) {
+        TimePoint wake = next_tick;
+        if (!timers_.empty() && timers_.begin()->first < wake) {
+            wake = timers_.begin()->first;
+        }
+        cv_.wait_until(lock, wake);
+        if (stopping_) {
+            break;
+        }
+
+        TimePoint now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            std::function<void()> fn = timers_.begin()->second;
+            timers_.erase(timers_.begin());
+            fn();
+        }
+        if (now >= next_tick) {
+            tick(now);
+            next_tick += std::chrono::milliseconds(MOCK_BAL_TICK_MS);
+            if (next_tick < now) {
+                next_tick = now + std::chrono::milliseconds(MOCK_BAL_TICK_MS);
+            }
+        }
+
+        if (!ready_.empty()) {
+            ready.swap(ready_);
+            lock.unlock();
+            for (size_t i = 0; i < ready.size(); i++) {
+                ready[i]();
+            }
+            ready.clear();
+            lock.lock();
+        }
+    }
+}
+
+void MockBal::tick(TimePoint now) {
+    uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_tick_).count();
+    // Catching up after a stall is no more than one tenth of a second's work
+    double seconds = std::min(ms, (uint64_t)100) / 1000.0;
+
+    last_tick_ = now;
+    pkt_credit_ += config_.pkt_in_rate * seconds;
+    if (pkt_credit_ >= 1) {
+        unsigned n = (unsigned)pkt_credit_;
+        pkt_credit_ -= n;
+        generate_packets(n);
+    }
+
+    if (config_.report_period && now >= next_report_) {
+        next_report_ = now + std::chrono::seconds(config_.report_period);
+        ready_.push_back([this]() {
+            BCM_LOG(INFO, mock_log_id, "mock BAL: %s\n", counters_to_str().c_str());
+        });
+    }
+}
+
+void MockBal::get_counters(mock_bal_counters* counters) {
+    counters->cfg_set = cfg_set_;
+    counters->cfg_get = cfg_get_;
+    counters->cfg_clear = cfg_clear_;
+    counters->stat_get = stat_get_;
+    counters->pkt_send = pkt_send_;
+    counters->omci_requests = omci_requests_;
+    counters->failed = failed_;
+    counters->indications = indications_;
+    counters->injected = injected;
+    counters->pkt_in = pkt_in_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters->onus_up = onus_up_;
+    counters->flows = flows_.size();
+}
+
+std::string MockBal::counters_to_str() {
+    mock_bal_counters c;
+    std::ostringstream out;
+
+    get_counters(&c);
+    out << "cfg set/get/clear " << c.cfg_set << "/" << c.cfg_get << "/" << c.cfg_clear
+        << ", stat get " << c.stat_get
+        << ", pkt send " << c.pkt_send << " (" << c.omci_requests << " omci)"
+        << ", failed " << c.failed
+        << ", indications " << c.indications << " (" << c.pkt_in << " packet-in)"
+        << ", injected " << c.injected
+        << ", onus up " << c.onus_up
+        << ", flows " << c.flows;
+    return out.str();
+}
+
+/* The BAL API */
+
+bcmos_errno bcmbal_init(int argc, char *argv[], void *p_mgmt_cb) {
+    (void)p_mgmt_cb;
+    return mockBal.init(argc, argv);
+}
+
+bcmos_errno bcmbal_cfg_set(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    (void)access_term_id;
+    return mockBal.cfg_set(objinfo);
+}
+
+bcmos_errno bcmbal_cfg_get(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    (void)access_term_id;
+    return mockBal.cfg_get(objinfo);
+}
+
+bcmos_errno bcmbal_cfg_clear(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    (void)access_term_id;
+    return mockBal.cfg_clear(objinfo);
+}
+
+bcmos_errno bcmbal_stat_get(bcmbal_access_id access_term_id, bcmbal_stat *objinfo,
+                            bcmos_bool clear_on_read) {
+    (void)access_term_id;
+    return mockBal.stat_get(objinfo, clear_on_read);
+}
+
+bcmos_errno bcmbal_pkt_send(bcmbal_access_id access_term_id, bcmbal_dest dest,
+                            const char *packet_to_send, uint16_t packet_len) {
+    (void)access_term_id;
+    return mockBal.pkt_send(dest, packet_to_send, packet_len);
+}
+
+bcmos_errno bcmbal_subscribe_ind(bcmbal_access_id access_term_id, bcmbal_cb_cfg *cb_cfg) {
+    (void)access_term_id;
+    return mockBal.subscribe(cb_cfg);
+}
+
+/* Control of the mock */
+
+void mock_bal_configure(const mock_bal_config& config) {
+    mockBal.configure(config);
+}
+
+bcmos_errno mock_bal_inject(bcmbal_obj* obj) {
+    mockBal.injected++;
+    return mockBal.dispatch(obj);
+}
+
+void mock_bal_get_counters(mock_bal_counters* counters) {
+    mockBal.get_counters(counters);
+}
+
+std::string mock_bal_counters_to_str() {
+    return mockBal.counters_to_str();
+}
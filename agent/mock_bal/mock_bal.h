@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_MOCK_BAL_H_
+#define OPENOLT_MOCK_BAL_H_
+
+#include <cstdint>
+#include <string>
+
+extern "C"
+{
+#include <bcmos_system.h>
+#include <bal_api.h>
+#include <bal_api_end.h>
+}
+
+// The mock BAL stands in for libbal_api_dist so the agent in src/ can be
+// load tested without an OLT. It keeps the state BAL would for the calls
+// the agent makes and answers them after a configurable latency:
+//  - the OLT, interface, ONU, flow and scheduler indications that follow
+//    a configuration change, ind_us later, activation_ms for an ONU;
+//  - discovery of the ONUs not activated yet when a PON comes up;
+//  - an OMCI response to every OMCI request to an up ONU, omci_us later;
+//  - packet-in on the trap flows, at pkt_in_rate;
+//  - statistics counting the packets it sent and received;
+//  - a BCM_ERR_IO failure of every pkt_fail_every-th packet-out to an ONU
+//    or NNI, to exercise the agent's error paths.
+// Indications run on a thread of the mock, as BAL runs them on its own.
+// mock_bal_inject() runs the handlers on any other indication.
+//
+// bcmbal_init() takes these options from the agent's command line:
+//   --mock-pons N --mock-nnis N --mock-onus N --mock-gpon
+//   --mock-cfg-us N --mock-stat-us N --mock-pkt-us N --mock-ind-us N
+//   --mock-activation-ms N --mock-omci-us N
+//   --mock-pkt-in-rate N --mock-pkt-in-size N --mock-pkt-fail-every N
+//   --mock-log-level N --mock-report N
+
+// Packet-in is generated every MOCK_BAL_TICK_MS
+#define MOCK_BAL_TICK_MS 10
+
+struct mock_bal_config {
+    unsigned pons;
+    unsigned nnis;
+    unsigned onus;              // per PON
+    bool gpon;                  // GPON rather than XGS-PON transceivers
+    unsigned cfg_us;            // latency of bcmbal_cfg_set/get/clear
+    unsigned stat_us;           // of bcmbal_stat_get
+    unsigned pkt_us;            // of bcmbal_pkt_send
+    unsigned ind_us;            // from a configuration change to its indication
+    unsigned activation_ms;     // from enabling an ONU to its indication
+    unsigned omci_us;           // from an OMCI request to its response
+    unsigned pkt_in_rate;       // packet indications per second, over all trap flows
+    unsigned pkt_in_size;
+    unsigned pkt_fail_every;    // packet-outs, not OMCI, per failed one; 0 for none
+    unsigned log_level;         // bcm_dev_log_level of every log id
+    unsigned report_period;     // seconds between counter logs, 0 for never
+};
+
+struct mock_bal_counters {
+    uint64_t cfg_set;
+    uint64_t cfg_get;
+    uint64_t cfg_clear;
+    uint64_t stat_get;
+    uint64_t pkt_send;
+    uint64_t omci_requests;
+    uint64_t failed;            // calls that returned an error
+    uint64_t indications;       // run by the mock
+    uint64_t injected;          // run by mock_bal_inject()
+    uint64_t pkt_in;
+    uint64_t onus_up;           // up now
+    uint64_t flows;             // programmed now
+};
+
+mock_bal_config mock_bal_default_config();
+
+// Before bcmbal_init(), whose options override config
+void mock_bal_configure(const mock_bal_config& config);
+
+// Runs the handlers subscribed to the indication obj, by its obj_type and
+// subgroup, on the calling thread. Returns BCM_ERR_NOENT if there are none.
+bcmos_errno mock_bal_inject(bcmbal_obj* obj);
+
+void mock_bal_get_counters(mock_bal_counters* counters);
+std::string mock_bal_counters_to_str();
+
+#endif
@@ -0,0 +1,1104 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+#include "core.h"
+#include "SimOlt.h"
+
+// OMCI baseline message, and the bits of its message type byte
+#define OMCI_BASELINE_LENGTH 48
+#define OMCI_MT_AR 0x40
+#define OMCI_MT_AK 0x20
+
+// Average frame of the modeled subscriber traffic
+#define SIM_FRAME_BYTES 512
+
+// Port numbers of the port statistics, as interface_key_to_port_no()
+#define SIM_NNI_PORT_NO(intf_id) ((0x1 << 16) + (intf_id))
+#define SIM_PON_PORT_NO(intf_id) ((0x2 << 28) + (intf_id))
+
+enum sim_rx_type {
+    SIM_RX_OLT,
+    SIM_RX_INTF,
+    SIM_RX_LOS,
+    SIM_RX_ONU_DISC,
+    SIM_RX_ONU,
+    SIM_RX_ONU_ALARM,
+    SIM_RX_DYING_GASP,
+    SIM_RX_OMCI,
+    SIM_RX_PKT,
+};
+
+// Stands in for the BAL objects the callbacks of the real agent copy to
+// the indication shards. data, the OMCI message or packet, is copied along.
+struct sim_rx {
+    uint32_t type;
+    uint32_t intf_type;     // SIM_PORT_NNI or SIM_PORT_PON
+    uint32_t intf_id;
+    uint32_t onu_id;
+    uint32_t up;            // oper state, or alarm status
+    uint32_t admin_up;
+    uint32_t gemport_id;
+    uint32_t flow_id;
+    uint8_t serial[12];
+    uint32_t len;
+    const uint8_t* data;
+};
+
+static const char* up_down(bool up) {
+    return up ? "up" : "down";
+}
+
+static const char* on_off(bool on) {
+    return on ? "on" : "off";
+}
+
+// Runs on the shard workers, as the handlers of src/indications.cc
+static void SimIndication(void* obj) {
+    const sim_rx* in = (const sim_rx*)obj;
+    IndicationPtr ind;
+
+    switch (in->type) {
+    case SIM_RX_OLT:
+        ind = oltIndQ.get(openolt::Indication::kOltInd);
+        ind->mutable_olt_ind()->set_oper_state(up_down(in->up));
+        break;
+    case SIM_RX_INTF:
+        // BAL reports interface state changes to IfIndication and
+        // IfOperIndication both
+        ind = oltIndQ.get(openolt::Indication::kIntfInd);
+        ind->mutable_intf_ind()->set_intf_id(in->intf_id);
+        ind->mutable_intf_ind()->set_oper_state(up_down(in->up));
+        oltIndQ.push(std::move(ind));
+
+        ind = oltIndQ.get(openolt::Indication::kIntfOperInd);
+        ind->mutable_intf_oper_ind()->set_type(in->intf_type == SIM_PORT_NNI ? "nni" : "pon");
+        ind->mutable_intf_oper_ind()->set_intf_id(in->intf_id);
+        ind->mutable_intf_oper_ind()->set_oper_state(up_down(in->up));
+        break;
+    case SIM_RX_LOS:
+        ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+        ind->mutable_alarm_ind()->mutable_los_ind()->set_intf_id(SIM_PON_PORT_NO(in->intf_id));
+        ind->mutable_alarm_ind()->mutable_los_ind()->set_status(on_off(in->up));
+        break;
+    case SIM_RX_ONU_DISC: {
+        ind = oltIndQ.get(openolt::Indication::kOnuDiscInd);
+        openolt::OnuDiscIndication* disc = ind->mutable_onu_disc_ind();
+        disc->set_intf_id(in->intf_id);
+        disc->mutable_serial_number()->set_vendor_id((const char*)in->serial, 4);
+        disc->mutable_serial_number()->set_vendor_specific((const char*)in->serial + 4, 8);
+        break;
+    }
+    case SIM_RX_ONU:
+        ind = oltIndQ.get(openolt::Indication::kOnuInd);
+        ind->mutable_onu_ind()->set_intf_id(in->intf_id);
+        ind->mutable_onu_ind()->set_onu_id(in->onu_id);
+        ind->mutable_onu_ind()->set_oper_state(up_down(in->up));
+        ind->mutable_onu_ind()->set_admin_state(up_down(in->admin_up));
+        break;
+    case SIM_RX_ONU_ALARM: {
+        ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+        openolt::OnuAlarmIndication* alarm = ind->mutable_alarm_ind()->mutable_onu_alarm_ind();
+        alarm->set_intf_id(in->intf_id);
+        alarm->set_onu_id(in->onu_id);
+        alarm->set_los_status(on_off(in->up));
+        alarm->set_lob_status("off");
+        alarm->set_lopc_miss_status("off");
+        alarm->set_lopc_mic_error_status("off");
+        break;
+    }
+    case SIM_RX_DYING_GASP:
+        ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+        ind->mutable_alarm_ind()->mutable_dying_gasp_ind()->set_intf_id(in->intf_id);
+        ind->mutable_alarm_ind()->mutable_dying_gasp_ind()->set_onu_id(in->onu_id);
+        ind->mutable_alarm_ind()->mutable_dying_gasp_ind()->set_status(on_off(in->up));
+        break;
+    case SIM_RX_OMCI:
+        ind = oltIndQ.get(openolt::Indication::kOmciInd);
+        ind->mutable_omci_ind()->set_intf_id(in->intf_id);
+        ind->mutable_omci_ind()->set_onu_id(in->onu_id);
+        ind->mutable_omci_ind()->mutable_pkt()->assign((const char*)in->data, in->len);
+        break;
+    case SIM_RX_PKT: {
+        ind = oltIndQ.get(openolt::Indication::kPktInd);
+        openolt::PacketIndication* pkt_ind = ind->mutable_pkt_ind();
+        FlowEntry flow;
+        pkt_ind->set_intf_type("pon");
+        pkt_ind->set_intf_id(in->intf_id);
+        pkt_ind->set_gemport_id(in->gemport_id);
+        pkt_ind->set_flow_id(in->flow_id);
+        pkt_ind->set_port_no(GetPortNum_(in->flow_id));
+        if (flow_state.find_flow(in->flow_id, false, &flow)) {
+            pkt_ind->set_cookie(flow.cookie);
+        }
+        pkt_ind->mutable_pkt()->assign((const char*)in->data, in->len);
+        break;
+    }
+    default:
+        return;
+    }
+    oltIndQ.push(std::move(ind));
+}
+
+sim_config SimOlt::default_config() {
+    sim_config config;
+
+    config.pons = 16;
+    config.onus = 32;
+    config.nnis = 1;
+    config.discovery_rate = 100;
+    config.activation_ms = 200;
+    config.omci_us = 2000;
+    config.pkt_in_rate = 0;
+    config.pkt_in_size = 64;
+    config.onu_pps = 100;
+    config.auto_activate = false;
+    config.los_period = 0;
+    config.dying_gasp_period = 0;
+    config.dying_gasp_onus = 16;
+    config.fault_duration = 30;
+    config.seed = 1;
+    return config;
+}
+
+SimOlt::SimOlt() :
+    config_(default_config()), stopping_(false), disc_pon_(0), disc_credit_(0), pkt_credit_(0),
+    los_requested_(false), dying_gasp_requested_(false), pkt_in_(0), dropped_(0) {
+    memset(&counters_, 0, sizeof(counters_));
+}
+
+SimOlt::~SimOlt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SimOlt::configure(const sim_config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    config_ = config;
+    // Serial numbers have 7 bits of PON and 14 of ONU index
+    config_.pons = std::min(std::max(config_.pons, 1u), 128u);
+    config_.onus = std::min(config_.onus, 16384u);
+    config_.nnis = std::max(config_.nnis, 1u);
+    rng_.seed(config_.seed);
+
+    pons_.assign(config_.pons, Pon());
+    for (size_t i = 0; i < pons_.size(); i++) {
+        Pon& pon = pons_[i];
+        pon.enabled = false;
+        pon.los = false;
+        pon.disc_cursor = 0;
+        pon.up_onus = 0;
+        pon.onus.assign(config_.onus, Onu());
+        for (size_t j = 0; j < pon.onus.size(); j++) {
+            pon.onus[j].state = ONU_UNDISCOVERED;
+            pon.onus[j].onu_id = 0;
+            pon.onus[j].powered = true;
+            pon.onus[j].up_pos = 0;
+            pon.onus[j].tconts = 0;
+        }
+        memset(&pon.counters, 0, sizeof(pon.counters));
+    }
+    nnis_.assign(config_.nnis, Nni());
+    for (size_t i = 0; i < nnis_.size(); i++) {
+        nnis_[i].enabled = false;
+        memset(&nnis_[i].counters, 0, sizeof(nnis_[i].counters));
+    }
+    pkt_.assign(std::max(config_.pkt_in_size, 14u), '\xa5');
+}
+
+void SimOlt::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sim_rx rx = { SIM_RX_OLT };
+
+    started_at_ = last_tick_ = std::chrono::steady_clock::now();
+    next_los_ = started_at_ + std::chrono::seconds(config_.los_period);
+    next_dying_gasp_ = started_at_ + std::chrono::seconds(config_.dying_gasp_period);
+
+    rx.up = 1;
+    emit(0, &rx, sizeof(rx));
+    std::cout << "sim: olt up, " << config_.pons << " PONs of " << config_.onus << " ONUs, "
+              << config_.nnis << " NNIs" << std::endl;
+
+    // As OltOperIndication does on OLT up
+    for (uint32_t i = 0; i < nnis_.size(); i++) {
+        nnis_[i].enabled = true;
+        rx.type = SIM_RX_INTF;
+        rx.intf_type = SIM_PORT_NNI;
+        rx.intf_id = i;
+        emit(0, &rx, sizeof(rx));
+    }
+    for (uint32_t i = 0; i < pons_.size(); i++) {
+        set_pon(i, true);
+    }
+
+    thread_ = std::thread(&SimOlt::run, this);
+}
+
+Status SimOlt::disable() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sim_rx rx = { SIM_RX_INTF };
+
+    // As the real agent, which only takes the first NNI down
+    nnis_[0].enabled = false;
+    rx.intf_type = SIM_PORT_NNI;
+    emit(0, &rx, sizeof(rx));
+    rx.type = SIM_RX_OLT;
+    emit(0, &rx, sizeof(rx));
+    return Status::OK;
+}
+
+Status SimOlt::reenable() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sim_rx rx = { SIM_RX_INTF };
+
+    nnis_[0].enabled = true;
+    rx.intf_type = SIM_PORT_NNI;
+    rx.up = 1;
+    emit(0, &rx, sizeof(rx));
+    rx.type = SIM_RX_OLT;
+    emit(0, &rx, sizeof(rx));
+    return Status::OK;
+}
+
+Status SimOlt::enable_pon(uint32_t intf_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (intf_id >= pons_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid PON interface");
+    }
+    set_pon(intf_id, true);
+    return Status::OK;
+}
+
+Status SimOlt::disable_pon(uint32_t intf_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (intf_id >= pons_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid PON interface");
+    }
+    set_pon(intf_id, false);
+    return Status::OK;
+}
+
+Status SimOlt::enable_nni(uint32_t intf_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sim_rx rx = { SIM_RX_INTF };
+
+    if (intf_id >= nnis_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid NNI interface");
+    }
+    if (!nnis_[intf_id].enabled) {
+        nnis_[intf_id].enabled = true;
+        rx.intf_type = SIM_PORT_NNI;
+        rx.intf_id = intf_id;
+        rx.up = 1;
+        emit(0, &rx, sizeof(rx));
+    }
+    return Status::OK;
+}
+
+Status SimOlt::disable_nni(uint32_t intf_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sim_rx rx = { SIM_RX_INTF };
+
+    if (intf_id >= nnis_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid NNI interface");
+    }
+    if (nnis_[intf_id].enabled) {
+        nnis_[intf_id].enabled = false;
+        rx.intf_type = SIM_PORT_NNI;
+        rx.intf_id = intf_id;
+        emit(0, &rx, sizeof(rx));
+    }
+    return Status::OK;
+}
+
+// An enabled PON brings its ONUs that were up before back up; a disabled
+// one takes them down and forgets the ones only discovered
+void SimOlt::set_pon(uint32_t intf_id, bool up) {
+    Pon& pon = pons_[intf_id];
+    sim_rx rx = { SIM_RX_INTF };
+
+    if (pon.enabled == up) {
+        return;
+    }
+    pon.enabled = up;
+    rx.intf_type = SIM_PORT_PON;
+    rx.intf_id = intf_id;
+    rx.up = up;
+    emit(intf_id, &rx, sizeof(rx));
+
+    for (unsigned i = 0; i < pon.onus.size(); i++) {
+        Onu& onu = pon.onus[i];
+        if (up && onu.state == ONU_DOWN && onu.powered && !pon.los) {
+            onu_up(intf_id, i);
+        } else if (!up && onu.state == ONU_UP) {
+            onu_down(intf_id, i, ONU_DOWN);
+        } else if (!up && onu.state == ONU_DISCOVERED) {
+            onu.state = ONU_UNDISCOVERED;
+        }
+    }
+}
+
+// Vendor id, then 4 bytes of vendor specific serial carrying the PON and
+// ONU index, none of them 0, then 4 more of 0
+void SimOlt::serial_number(uint32_t intf_id, unsigned index, uint8_t serial[12]) const {
+    memcpy(serial, "SIMU", 4);
+    serial[4] = 0x80 | intf_id;
+    serial[5] = 0x80 | (index >> 7);
+    serial[6] = 0x80 | (index & 0x7f);
+    serial[7] = 0x5a;
+    memset(serial + 8, 0, 4);
+}
+
+SimOlt::Onu* SimOlt::find_onu(uint32_t intf_id, uint32_t onu_id, unsigned* index) {
+    if (intf_id >= pons_.size()) {
+        return NULL;
+    }
+    std::map<uint32_t, unsigned>::const_iterator it = pons_[intf_id].by_onu_id.find(onu_id);
+    if (it == pons_[intf_id].by_onu_id.end()) {
+        return NULL;
+    }
+    *index = it->second;
+    return &pons_[intf_id].onus[it->second];
+}
+
+void SimOlt::onu_up(uint32_t intf_id, unsigned index) {
+    Pon& pon = pons_[intf_id];
+    Onu& onu = pon.onus[index];
+    sim_rx rx = { SIM_RX_ONU };
+
+    onu.state = ONU_UP;
+    onu.up_pos = up_.size();
+    up_.push_back((intf_id << 16) | index);
+    pon.up_onus++;
+    counters_.activated++;
+
+    rx.intf_id = intf_id;
+    rx.onu_id = onu.onu_id;
+    rx.up = 1;
+    rx.admin_up = 1;
+    emit(intf_id, &rx, sizeof(rx));
+}
+
+void SimOlt::onu_down(uint32_t intf_id, unsigned index, OnuState state) {
+    Pon& pon = pons_[intf_id];
+    Onu& onu = pon.onus[index];
+    sim_rx rx = { SIM_RX_ONU };
+
+    if (onu.state == ONU_UP) {
+        uint32_t last = up_.back();
+        up_[onu.up_pos] = last;
+        pons_[last >> 16].onus[last & 0xffff].up_pos = onu.up_pos;
+        up_.pop_back();
+        pon.up_onus--;
+    }
+    onu.state = state;
+
+    rx.intf_id = intf_id;
+    rx.onu_id = onu.onu_id;
+    rx.admin_up = state != ONU_DISABLED;
+    emit(intf_id, &rx, sizeof(rx));
+}
+
+Status SimOlt::activate_onu(uint32_t intf_id, uint32_t onu_id,
+                            const char* vendor_id, const char* vendor_specific) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint8_t* vs = (const uint8_t*)vendor_specific;
+
+    if (intf_id >= pons_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid PON interface");
+    }
+    if (memcmp(vendor_id, "SIMU", 4) != 0 || (vs[0] & 0x7f) != intf_id) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    unsigned index = ((vs[1] & 0x7f) << 7) | (vs[2] & 0x7f);
+    if (index >= config_.onus) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+
+    Pon& pon = pons_[intf_id];
+    Onu& onu = pon.onus[index];
+    std::map<uint32_t, unsigned>::const_iterator it = pon.by_onu_id.find(onu_id);
+    if (it != pon.by_onu_id.end() && it->second != index) {
+        return Status(grpc::StatusCode::ALREADY_EXISTS, "ONU id in use on the PON");
+    }
+    if (onu.state == ONU_UP || onu.state == ONU_ACTIVATING || onu.state == ONU_DOWN) {
+        return Status::OK;
+    }
+    if (onu.onu_id != 0 && onu.onu_id != onu_id) {
+        pon.by_onu_id.erase(onu.onu_id);
+    }
+    onu.onu_id = onu_id;
+    pon.by_onu_id[onu_id] = index;
+    onu.state = ONU_ACTIVATING;
+
+    after(std::chrono::milliseconds(config_.activation_ms), [this, intf_id, index]() {
+        Pon& pon = pons_[intf_id];
+        Onu& onu = pon.onus[index];
+        if (onu.state != ONU_ACTIVATING) {
+            return;
+        }
+        if (pon.enabled && !pon.los && onu.powered) {
+            onu_up(intf_id, index);
+        } else {
+            onu.state = ONU_DOWN;
+        }
+    });
+    return Status::OK;
+}
+
+Status SimOlt::deactivate_onu(uint32_t intf_id, uint32_t onu_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    if (find_onu(intf_id, onu_id, &index) == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    onu_down(intf_id, index, ONU_DISABLED);
+    return Status::OK;
+}
+
+Status SimOlt::delete_onu(uint32_t intf_id, uint32_t onu_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    Onu* onu = find_onu(intf_id, onu_id, &index);
+    if (onu == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    if (onu->state != ONU_DISABLED) {
+        onu_down(intf_id, index, ONU_DISABLED);
+    }
+    // Discovered again later, as a new ONU
+    pons_[intf_id].by_onu_id.erase(onu_id);
+    counters_.tconts -= onu->tconts;
+    onu->tconts = 0;
+    onu->trap_flows.clear();
+    onu->onu_id = 0;
+    onu->state = ONU_UNDISCOVERED;
+    return Status::OK;
+}
+
+// Answers with an acknowledgement of the request, as an ONU that applies
+// every request
+Status SimOlt::omci_out(uint32_t intf_id, uint32_t onu_id, const uint8_t* msg, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    counters_.omci_requests++;
+    Onu* onu = find_onu(intf_id, onu_id, &index);
+    if (onu == NULL || onu->state != ONU_UP) {
+        counters_.omci_dropped++;
+        return Status::OK;
+    }
+
+    std::string response((const char*)msg, std::min(len, (size_t)OMCI_BASELINE_LENGTH));
+    response.resize(OMCI_BASELINE_LENGTH, '\0');
+    response[2] = (response[2] & ~OMCI_MT_AR) | OMCI_MT_AK;
+    response[8] = 0;    // success
+
+    after(std::chrono::microseconds(config_.omci_us), [this, intf_id, index, response]() {
+        Onu& onu = pons_[intf_id].onus[index];
+        sim_rx rx = { SIM_RX_OMCI };
+        if (onu.state != ONU_UP) {
+            return;
+        }
+        rx.intf_id = intf_id;
+        rx.onu_id = onu.onu_id;
+        rx.len = response.size();
+        emit(intf_id, &rx, sizeof(rx), response.data(), response.size());
+    });
+    return Status::OK;
+}
+
+Status SimOlt::onu_packet_out(uint32_t intf_id, uint32_t onu_id, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    if (find_onu(intf_id, onu_id, &index) == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    pons_[intf_id].counters.tx_packets++;
+    pons_[intf_id].counters.tx_bytes += len;
+    counters_.pkt_out++;
+    return Status::OK;
+}
+
+Status SimOlt::uplink_packet_out(uint32_t intf_id, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (intf_id >= nnis_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid NNI interface");
+    }
+    nnis_[intf_id].counters.tx_packets++;
+    nnis_[intf_id].counters.tx_bytes += len;
+    counters_.pkt_out++;
+    return Status::OK;
+}
+
+Status SimOlt::add_flow(int32_t intf_id, int32_t onu_id, uint32_t flow_id,
+                        const std::string& flow_type, bool trap) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool downstream = flow_type == "downstream";
+    unsigned index = UINT32_MAX;
+
+    if (!downstream && flow_type != "upstream") {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid flow type");
+    }
+    if (intf_id >= (int32_t)pons_.size()) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid PON interface");
+    }
+    // NNI flows have no access interface or ONU
+    if (intf_id >= 0 && onu_id >= 0 && find_onu(intf_id, onu_id, &index) == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+
+    uint64_t key = ((uint64_t)flow_id << 1) | downstream;
+    std::map<uint64_t, Flow>::iterator it = flows_.find(key);
+    if (it != flows_.end()) {
+        drop_trap(it->second, flow_id);
+    }
+    Flow& flow = flows_[key];
+    flow.intf_id = intf_id;
+    flow.onu = index;
+    // Packet-in comes from ONUs, on upstream flows
+    flow.trap = trap && !downstream && index != UINT32_MAX;
+    if (flow.trap) {
+        pons_[intf_id].onus[index].trap_flows.push_back(flow_id);
+    }
+    counters_.flows = flows_.size();
+    return Status::OK;
+}
+
+void SimOlt::drop_trap(const Flow& flow, uint32_t flow_id) {
+    if (!flow.trap) {
+        return;
+    }
+    std::vector<uint32_t>& traps = pons_[flow.intf_id].onus[flow.onu].trap_flows;
+    std::vector<uint32_t>::iterator trap = std::find(traps.begin(), traps.end(), flow_id);
+    // Gone already if the ONU was deleted
+    if (trap != traps.end()) {
+        traps.erase(trap);
+    }
+}
+
+Status SimOlt::remove_flow(uint32_t flow_id, const std::string& flow_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool downstream = flow_type == "downstream";
+
+    if (!downstream && flow_type != "upstream") {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid flow type");
+    }
+    std::map<uint64_t, Flow>::iterator it = flows_.find(((uint64_t)flow_id << 1) | downstream);
+    if (it == flows_.end()) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such flow");
+    }
+    drop_trap(it->second, flow_id);
+    flows_.erase(it);
+    counters_.flows = flows_.size();
+    return Status::OK;
+}
+
+Status SimOlt::add_tconts(const openolt::Tconts* tconts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    Onu* onu = find_onu(tconts->intf_id(), tconts->onu_id(), &index);
+    if (onu == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    for (int i = 0; i < tconts->tconts_size(); i++) {
+        if (tconts->tconts(i).direction() != openolt::Direction::UPSTREAM &&
+            tconts->tconts(i).direction() != openolt::Direction::DOWNSTREAM) {
+            return Status::CANCELLED;
+        }
+    }
+    onu->tconts += tconts->tconts_size();
+    counters_.tconts += tconts->tconts_size();
+    return Status::OK;
+}
+
+Status SimOlt::remove_tconts(const openolt::Tconts* tconts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index;
+
+    Onu* onu = find_onu(tconts->intf_id(), tconts->onu_id(), &index);
+    if (onu == NULL) {
+        return Status(grpc::StatusCode::NOT_FOUND, "No such ONU on the PON");
+    }
+    uint32_t n = std::min(onu->tconts, (uint32_t)tconts->tconts_size());
+    onu->tconts -= n;
+    counters_.tconts -= n;
+    return Status::OK;
+}
+
+bool SimOlt::packet_in(uint32_t intf_id, uint32_t gemport_id, uint32_t flow_id,
+                       const char* pkt, size_t len) {
+    sim_rx rx = { SIM_RX_PKT };
+
+    rx.intf_type = SIM_PORT_PON;
+    rx.intf_id = intf_id;
+    rx.gemport_id = gemport_id;
+    rx.flow_id = flow_id;
+    rx.len = len;
+    if (!indShards.submit_packet(intf_id, SimIndication, &rx, sizeof(rx), pkt, len,
+                                 offsetof(sim_rx, data))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    pkt_in_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool SimOlt::emit(uint32_t key, const void* rx, size_t len, const void* data, size_t data_len) {
+    if (!indShards.submit(key, SimIndication, rx, len, data, data_len, offsetof(sim_rx, data))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void SimOlt::after(std::chrono::microseconds delay, const std::function<void()>& fn) {
+    TimePoint when = std::chrono::steady_clock::now() + delay;
+    bool first = timers_.empty() || when < timers_.begin()->first;
+
+    timers_.insert(std::make_pair(when, fn));
+    if (first) {
+        cv_.notify_one();
+    }
+}
+
+void SimOlt::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    TimePoint next_tick = std::chrono::steady_clock::now();
+
+    while (!stopping_) {
+        TimePoint wake = next_tick;
+        if (!timers_.empty() && timers_.begin()->first < wake) {
+            wake = timers_.begin()->first;
+        }
+        cv_.wait_until(lock, wake);
+        if (stopping_) {
+            break;
+        }
+
+        TimePoint now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            std::function<void()> fn = timers_.begin()->second;
+            timers_.erase(timers_.begin());
+            fn();
+        }
+        if (now >= next_tick) {
+            tick(now);
+            next_tick += std::chrono::milliseconds(SIM_TICK_MS);
+            if (next_tick < now) {
+                next_tick = now + std::chrono::milliseconds(SIM_TICK_MS);
+            }
+        }
+    }
+}
+
+void SimOlt::tick(TimePoint now) {
+    uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_tick_).count();
+    // Catching up after a stall is no more than one tenth of a second's work
+    double seconds = std::min(ms, (uint64_t)100) / 1000.0;
+
+    last_tick_ = now;
+    traffic(ms);
+
+    if (los_requested_.exchange(false) ||
+        (config_.los_period && now >= next_los_)) {
+        next_los_ = now + std::chrono::seconds(config_.los_period);
+        raise_los();
+    }
+    if (dying_gasp_requested_.exchange(false) ||
+        (config_.dying_gasp_period && now >= next_dying_gasp_)) {
+        next_dying_gasp_ = now + std::chrono::seconds(config_.dying_gasp_period);
+        raise_dying_gasp();
+    }
+
+    disc_credit_ += config_.discovery_rate * seconds;
+    if (disc_credit_ >= 1) {
+        unsigned n = (unsigned)disc_credit_;
+        disc_credit_ -= n;
+        discover(n);
+    }
+
+    pkt_credit_ += config_.pkt_in_rate * seconds;
+    if (pkt_credit_ >= 1) {
+        unsigned n = (unsigned)pkt_credit_;
+        pkt_credit_ -= n;
+        generate_packets(n);
+    }
+}
+
+// Up to count ONUs not activated yet show up, taking the PONs in turn
+void SimOlt::discover(unsigned count) {
+    unsigned idle = 0;
+
+    while (count > 0 && idle < pons_.size()) {
+        uint32_t intf_id = disc_pon_;
+        Pon& pon = pons_[intf_id];
+        bool found = false;
+
+        disc_pon_ = (disc_pon_ + 1) % pons_.size();
+        for (unsigned n = 0; pon.enabled && !pon.los && n < pon.onus.size(); n++) {
+            unsigned index = pon.disc_cursor;
+            Onu& onu = pon.onus[index];
+            pon.disc_cursor = (pon.disc_cursor + 1) % pon.onus.size();
+            if (onu.state != ONU_UNDISCOVERED || !onu.powered) {
+                continue;
+            }
+
+            sim_rx rx = { SIM_RX_ONU_DISC };
+            rx.intf_id = intf_id;
+            serial_number(intf_id, index, rx.serial);
+            onu.state = ONU_DISCOVERED;
+            emit(intf_id, &rx, sizeof(rx));
+            counters_.discovered++;
+
+            // ONU ids of the xgspon range, 1 to 255, where free
+            uint32_t onu_id = index + 1;
+            if (config_.auto_activate && onu_id <= 255 &&
+                pon.by_onu_id.find(onu_id) == pon.by_onu_id.end()) {
+                onu.onu_id = onu_id;
+                pon.by_onu_id[onu_id] = index;
+                onu_up(intf_id, index);
+            }
+            found = true;
+            break;
+        }
+        if (found) {
+            count--;
+            idle = 0;
+        } else {
+            idle++;
+        }
+    }
+}
+
+// Packets from random up ONUs, on one of their trap flows if they have any
+void SimOlt::generate_packets(unsigned count) {
+    for (unsigned i = 0; i < count && !up_.empty(); i++) {
+        uint32_t up = up_[rng_() % up_.size()];
+        uint32_t intf_id = up >> 16;
+        Onu& onu = pons_[intf_id].onus[up & 0xffff];
+        uint32_t flow_id = 0;
+        uint32_t gemport_id = SIM_GEMPORT(onu.onu_id);
+        FlowEntry flow;
+
+        if (!onu.trap_flows.empty()) {
+            flow_id = onu.trap_flows[rng_() % onu.trap_flows.size()];
+            if (flow_state.find_flow(flow_id, false, &flow) && flow.gemport_id != 0) {
+                gemport_id = flow.gemport_id;
+            }
+        }
+        if (packet_in(intf_id, gemport_id, flow_id, pkt_.data(), pkt_.size())) {
+            pons_[intf_id].counters.rx_packets++;
+            pons_[intf_id].counters.rx_bytes += pkt_.size();
+        }
+    }
+}
+
+// Subscriber traffic of the up ONUs, through the PONs and evenly over the
+// enabled NNIs
+void SimOlt::traffic(uint64_t ms) {
+    uint64_t total = 0;
+    unsigned nnis = 0;
+
+    for (size_t i = 0; i < pons_.size(); i++) {
+        uint64_t packets = (uint64_t)pons_[i].up_onus * config_.onu_pps * ms / 1000;
+        PortCounters& c = pons_[i].counters;
+        c.rx_packets += packets;
+        c.rx_bytes += packets * SIM_FRAME_BYTES;
+        c.tx_packets += packets;
+        c.tx_bytes += packets * SIM_FRAME_BYTES;
+        total += packets;
+    }
+    for (size_t i = 0; i < nnis_.size(); i++) {
+        nnis += nnis_[i].enabled;
+    }
+    for (size_t i = 0; i < nnis_.size() && nnis > 0; i++) {
+        if (!nnis_[i].enabled) {
+            continue;
+        }
+        PortCounters& c = nnis_[i].counters;
+        c.rx_packets += total / nnis;
+        c.rx_bytes += total / nnis * SIM_FRAME_BYTES;
+        c.tx_packets += total / nnis;
+        c.tx_bytes += total / nnis * SIM_FRAME_BYTES;
+    }
+}
+
+// A PON loses its signal: every ONU on it goes down until it clears
+void SimOlt::raise_los() {
+    std::vector<uint32_t> candidates;
+
+    for (uint32_t i = 0; i < pons_.size(); i++) {
+        if (pons_[i].enabled && !pons_[i].los) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) {
+        return;
+    }
+
+    uint32_t intf_id = candidates[rng_() % candidates.size()];
+    Pon& pon = pons_[intf_id];
+    sim_rx rx = { SIM_RX_LOS };
+
+    std::cout << "sim: LOS on PON " << intf_id << ", " << pon.up_onus << " ONUs up" << std::endl;
+    pon.los = true;
+    counters_.los++;
+    rx.intf_id = intf_id;
+    rx.up = 1;
+    emit(intf_id, &rx, sizeof(rx));
+
+    for (unsigned i = 0; i < pon.onus.size(); i++) {
+        Onu& onu = pon.onus[i];
+        if (onu.state == ONU_UP) {
+            sim_rx alarm = { SIM_RX_ONU_ALARM };
+            alarm.intf_id = intf_id;
+            alarm.onu_id = onu.onu_id;
+            alarm.up = 1;
+            emit(intf_id, &alarm, sizeof(alarm));
+            onu_down(intf_id, i, ONU_DOWN);
+            pon.counters.errors++;
+        } else if (onu.state == ONU_DISCOVERED) {
+            onu.state = ONU_UNDISCOVERED;
+        }
+    }
+
+    after(std::chrono::seconds(config_.fault_duration), [this, intf_id]() {
+        Pon& pon = pons_[intf_id];
+        sim_rx rx = { SIM_RX_LOS };
+
+        std::cout << "sim: LOS on PON " << intf_id << " cleared" << std::endl;
+        pon.los = false;
+        rx.intf_id = intf_id;
+        emit(intf_id, &rx, sizeof(rx));
+        for (unsigned i = 0; i < pon.onus.size(); i++) {
+            Onu& onu = pon.onus[i];
+            if (onu.state != ONU_DOWN) {
+                continue;
+            }
+            sim_rx alarm = { SIM_RX_ONU_ALARM };
+            alarm.intf_id = intf_id;
+            alarm.onu_id = onu.onu_id;
+            emit(intf_id, &alarm, sizeof(alarm));
+            if (pon.enabled && onu.powered) {
+                onu_up(intf_id, i);
+            }
+        }
+    });
+}
+
+// A power cut: dying_gasp_onus up ONUs, neighbours from a random one on,
+// lose power and come back when it clears
+void SimOlt::raise_dying_gasp() {
+    std::vector<uint32_t> victims;
+
+    if (up_.empty()) {
+        return;
+    }
+
+    uint32_t first = up_[rng_() % up_.size()];
+    size_t total = pons_.size() * config_.onus;
+    size_t start = (first >> 16) * config_.onus + (first & 0xffff);
+    for (size_t n = 0; n < total && victims.size() < config_.dying_gasp_onus; n++) {
+        size_t at = (start + n) % total;
+        uint32_t intf_id = at / config_.onus;
+        unsigned index = at % config_.onus;
+        Onu& onu = pons_[intf_id].onus[index];
+        if (onu.state != ONU_UP) {
+            continue;
+        }
+
+        sim_rx rx = { SIM_RX_DYING_GASP };
+        rx.intf_id = intf_id;
+        rx.onu_id = onu.onu_id;
+        rx.up = 1;
+        emit(intf_id, &rx, sizeof(rx));
+        onu.powered = false;
+        onu_down(intf_id, index, ONU_DOWN);
+        victims.push_back((intf_id << 16) | index);
+    }
+    counters_.dying_gasps += victims.size();
+    std::cout << "sim: dying gasp of " << victims.size() << " ONUs from PON "
+              << (first >> 16) << std::endl;
+
+    after(std::chrono::seconds(config_.fault_duration), [this, victims]() {
+        for (size_t i = 0; i < victims.size(); i++) {
+            uint32_t intf_id = victims[i] >> 16;
+            unsigned index = victims[i] & 0xffff;
+            Pon& pon = pons_[intf_id];
+            Onu& onu = pon.onus[index];
+            onu.powered = true;
+            if (onu.state == ONU_DOWN && pon.enabled && !pon.los) {
+                onu_up(intf_id, index);
+            }
+        }
+    });
+}
+
+void SimOlt::get_device_info(openolt::DeviceInfo* device_info) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    device_info->set_vendor("ONF");
+    device_info->set_model("openoltsim");
+    device_info->set_hardware_version("");
+    device_info->set_firmware_version("sim");
+    device_info->set_technology("xgspon");
+    device_info->set_pon_ports(pons_.size());
+    device_info->set_onu_id_start(1);
+    device_info->set_onu_id_end(255);
+    device_info->set_alloc_id_start(1024);
+    device_info->set_alloc_id_end(16383);
+    device_info->set_gemport_id_start(1024);
+    device_info->set_gemport_id_end(65535);
+    device_info->set_flow_id_start(1);
+    device_info->set_flow_id_end(FLOW_ID_MAX);
+
+    openolt::DeviceInfo::DeviceResourceRanges* range = device_info->add_ranges();
+    openolt::DeviceInfo::DeviceResourceRanges::Pool* pool;
+    range->set_technology("xgspon");
+    for (uint32_t i = 0; i < pons_.size(); i++) {
+        range->add_intf_ids(i);
+    }
+
+    pool = range->add_pools();
+    pool->set_type(openolt::DeviceInfo::DeviceResourceRanges::Pool::ONU_ID);
+    pool->set_sharing(openolt::DeviceInfo::DeviceResourceRanges::Pool::DEDICATED_PER_INTF);
+    pool->set_start(1);
+    pool->set_end(255);
+
+    pool = range->add_pools();
+    pool->set_type(openolt::DeviceInfo::DeviceResourceRanges::Pool::ALLOC_ID);
+    pool->set_sharing(openolt::DeviceInfo::DeviceResourceRanges::Pool::SHARED_BY_ALL_INTF_SAME_TECH);
+    pool->set_start(1024);
+    pool->set_end(16383);
+
+    pool = range->add_pools();
+    pool->set_type(openolt::DeviceInfo::DeviceResourceRanges::Pool::GEMPORT_ID);
+    pool->set_sharing(openolt::DeviceInfo::DeviceResourceRanges::Pool::SHARED_BY_ALL_INTF_ALL_TECH);
+    pool->set_start(1024);
+    pool->set_end(65535);
+
+    pool = range->add_pools();
+    pool->set_type(openolt::DeviceInfo::DeviceResourceRanges::Pool::FLOW_ID);
+    pool->set_sharing(openolt::DeviceInfo::DeviceResourceRanges::Pool::SHARED_BY_ALL_INTF_ALL_TECH);
+    pool->set_start(1);
+    pool->set_end(FLOW_ID_MAX);
+}
+
+std::vector<StatsPort> SimOlt::stats_ports() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StatsPort> ports;
+
+    for (uint32_t i = 0; i < nnis_.size(); i++) {
+        StatsPort port = { SIM_PORT_NNI, i, "nni-" + std::to_string(i) };
+        ports.push_back(port);
+    }
+    for (uint32_t i = 0; i < pons_.size(); i++) {
+        StatsPort port = { SIM_PORT_PON, i, "pon-" + std::to_string(i) };
+        ports.push_back(port);
+    }
+    return ports;
+}
+
+bool SimOlt::port_stats(const StatsPort& port, openolt::PortStatistics* port_stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const PortCounters* c;
+
+    if (port.kind == SIM_PORT_NNI && port.intf_id < nnis_.size()) {
+        c = &nnis_[port.intf_id].counters;
+        port_stats->set_intf_id(SIM_NNI_PORT_NO(port.intf_id));
+    } else if (port.kind == SIM_PORT_PON && port.intf_id < pons_.size()) {
+        c = &pons_[port.intf_id].counters;
+        port_stats->set_intf_id(SIM_PON_PORT_NO(port.intf_id));
+    } else {
+        return false;
+    }
+
+    // Unicast only
+    port_stats->set_rx_bytes(c->rx_bytes);
+    port_stats->set_rx_packets(c->rx_packets);
+    port_stats->set_rx_ucast_packets(c->rx_packets);
+    port_stats->set_rx_mcast_packets(0);
+    port_stats->set_rx_bcast_packets(0);
+    port_stats->set_rx_error_packets(c->errors);
+    port_stats->set_tx_bytes(c->tx_bytes);
+    port_stats->set_tx_packets(c->tx_packets);
+    port_stats->set_tx_ucast_packets(c->tx_packets);
+    port_stats->set_tx_mcast_packets(0);
+    port_stats->set_tx_bcast_packets(0);
+    port_stats->set_tx_error_packets(0);
+    port_stats->set_rx_crc_errors(c->errors);
+    port_stats->set_bip_errors(c->errors);
+    port_stats->set_timestamp((int)time(NULL));
+    return true;
+}
+
+// The flows carry onu_pps each, since the simulator started
+void SimOlt::flow_stats(uint32_t flow_id, openolt::FlowStatistics* flow_stats) const {
+    uint64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - started_at_).count();
+    uint64_t packets = seconds * config_.onu_pps;
+
+    flow_stats->set_flow_id(flow_id);
+    flow_stats->set_rx_packets(packets);
+    flow_stats->set_rx_bytes(packets * SIM_FRAME_BYTES);
+    flow_stats->set_tx_packets(packets);
+    flow_stats->set_tx_bytes(packets * SIM_FRAME_BYTES);
+    flow_stats->set_timestamp((int)time(NULL));
+}
+
+void SimOlt::get_counters(sim_counters* counters) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    *counters = counters_;
+    counters->onus_up = up_.size();
+    counters->pkt_in = pkt_in_.load(std::memory_order_relaxed);
+    counters->dropped = dropped_.load(std::memory_order_relaxed);
+}
+
+std::string SimOlt::counters_to_str() const {
+    sim_counters c;
+    get_counters(&c);
+
+    std::ostringstream out;
+    out << "discovered " << c.discovered << " activated " << c.activated << " up " << c.onus_up
+        << " omci " << c.omci_requests << " (" << c.omci_dropped << " dropped)"
+        << " pkt in/out " << c.pkt_in << "/" << c.pkt_out
+        << " flows " << c.flows << " tconts " << c.tconts
+        << " los " << c.los << " dying gasps " << c.dying_gasps
+        << " dropped " << c.dropped;
+    return out.str();
+}
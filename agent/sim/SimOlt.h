@@ -0,0 +1,257 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_SIM_OLT_H_
+#define OPENOLT_SIM_OLT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+#include <openolt.grpc.pb.h>
+
+#include "StatsCollector.h"
+
+// The load generators run every SIM_TICK_MS
+#define SIM_TICK_MS 10
+
+// Port kinds of the StatsPorts the simulated OLT reads
+#define SIM_PORT_NNI 0
+#define SIM_PORT_PON 1
+
+// Gemport of the default service port of an ONU, used for packets that no
+// trap flow of the ONU accounts for
+#define SIM_GEMPORT(onu_id) (1024 + (onu_id))
+
+struct sim_config {
+    unsigned pons;
+    unsigned onus;              // per PON
+    unsigned nnis;
+    unsigned discovery_rate;    // ONU discoveries per second, over all PONs
+    unsigned activation_ms;     // from ActivateOnu_ to the ONU indication
+    unsigned omci_us;           // from an OMCI request to its response
+    unsigned pkt_in_rate;       // packet indications per second, over all up ONUs
+    unsigned pkt_in_size;
+    unsigned onu_pps;           // traffic of an up ONU each way, in the port statistics
+    bool auto_activate;         // activate discovered ONUs without an adapter
+    unsigned los_period;        // seconds between LOS on a random PON, 0 for never
+    unsigned dying_gasp_period; // seconds between dying gasp storms, 0 for never
+    unsigned dying_gasp_onus;   // ONUs losing power in a storm
+    unsigned fault_duration;    // seconds until a fault clears
+    unsigned seed;
+};
+
+struct sim_counters {
+    uint64_t discovered;
+    uint64_t activated;         // ONU up indications
+    uint64_t onus_up;           // up now
+    uint64_t omci_requests;
+    uint64_t omci_dropped;      // to ONUs that were not up
+    uint64_t pkt_in;
+    uint64_t pkt_out;
+    uint64_t flows;             // programmed now
+    uint64_t tconts;            // programmed now
+    uint64_t los;               // LOS faults raised
+    uint64_t dying_gasps;       // ONUs that lost power
+    uint64_t dropped;           // packet-ins the shards had no room for
+};
+
+// Models an OLT of config.pons PONs with config.onus ONUs each, in place of
+// BAL. Its indications go through indShards, one shard per PON as with
+// BAL, and are turned into protobuf on the shard workers:
+//  - olt and interface state changes when the OLT comes up or is disabled;
+//  - ONU discovery of the ONUs not activated yet, at discovery_rate;
+//  - ONU up/down, activation_ms after ActivateOnu_, or straight away on
+//    discovery with auto_activate;
+//  - an OMCI response to every OMCI request to an up ONU, omci_us later;
+//  - packet-in from random up ONUs at pkt_in_rate, on their trap flows;
+//  - LOS of a whole PON every los_period seconds, and dying gasps of
+//    dying_gasp_onus neighbouring ONUs every dying_gasp_period seconds,
+//    each clearing fault_duration seconds later. inject_los() and
+//    inject_dying_gasp() raise them on demand.
+// Flows and tconts are kept per ONU so packet-in carries the flow and
+// cookie the adapter programmed, and port statistics follow the traffic of
+// the up ONUs. A single thread runs the generators and delayed events;
+// every call holds one lock.
+class SimOlt {
+  public:
+    static sim_config default_config();
+
+    SimOlt();
+    ~SimOlt();
+
+    SimOlt(const SimOlt&) = delete;
+    SimOlt& operator=(const SimOlt&) = delete;
+
+    // Before start()
+    void configure(const sim_config& config);
+
+    // Brings the OLT, its NNIs and PONs up and starts the generators
+    void start();
+
+    Status disable();
+    Status reenable();
+    Status enable_pon(uint32_t intf_id);
+    Status disable_pon(uint32_t intf_id);
+    Status enable_nni(uint32_t intf_id);
+    Status disable_nni(uint32_t intf_id);
+
+    // The ONU is known by the serial number it was discovered with
+    Status activate_onu(uint32_t intf_id, uint32_t onu_id,
+                        const char* vendor_id, const char* vendor_specific);
+    Status deactivate_onu(uint32_t intf_id, uint32_t onu_id);
+    Status delete_onu(uint32_t intf_id, uint32_t onu_id);
+
+    Status omci_out(uint32_t intf_id, uint32_t onu_id, const uint8_t* msg, size_t len);
+    Status onu_packet_out(uint32_t intf_id, uint32_t onu_id, size_t len);
+    Status uplink_packet_out(uint32_t intf_id, size_t len);
+
+    // trap is the flow's trap_to_host action. The flow state of the agent
+    // is the caller's.
+    Status add_flow(int32_t intf_id, int32_t onu_id, uint32_t flow_id,
+                    const std::string& flow_type, bool trap);
+    Status remove_flow(uint32_t flow_id, const std::string& flow_type);
+    Status add_tconts(const openolt::Tconts* tconts);
+    Status remove_tconts(const openolt::Tconts* tconts);
+
+    // Queues a packet indication as BAL would, false if its shard is full
+    bool packet_in(uint32_t intf_id, uint32_t gemport_id, uint32_t flow_id,
+                   const char* pkt, size_t len);
+
+    // Raised by the generator thread on its next tick
+    void inject_los() { los_requested_ = true; }
+    void inject_dying_gasp() { dying_gasp_requested_ = true; }
+
+    void get_device_info(openolt::DeviceInfo* device_info) const;
+    std::vector<StatsPort> stats_ports() const;
+    bool port_stats(const StatsPort& port, openolt::PortStatistics* port_stats) const;
+    void flow_stats(uint32_t flow_id, openolt::FlowStatistics* flow_stats) const;
+
+    unsigned num_pons() const { return config_.pons; }
+    unsigned num_nnis() const { return config_.nnis; }
+
+    void get_counters(sim_counters* counters) const;
+    std::string counters_to_str() const;
+
+  private:
+    enum OnuState {
+        ONU_UNDISCOVERED,
+        ONU_DISCOVERED,
+        ONU_ACTIVATING,
+        ONU_UP,
+        ONU_DOWN,           // LOS or power loss, back up when it clears
+        ONU_DISABLED,       // deactivated
+    };
+
+    struct Onu {
+        OnuState state;
+        uint32_t onu_id;    // 0 until activated
+        bool powered;
+        size_t up_pos;      // in up_ while ONU_UP
+        uint32_t tconts;
+        std::vector<uint32_t> trap_flows;
+    };
+
+    struct PortCounters {
+        uint64_t rx_packets;
+        uint64_t rx_bytes;
+        uint64_t tx_packets;
+        uint64_t tx_bytes;
+        uint64_t errors;
+    };
+
+    struct Pon {
+        bool enabled;
+        bool los;
+        unsigned disc_cursor;
+        unsigned up_onus;
+        std::vector<Onu> onus;
+        std::map<uint32_t, unsigned> by_onu_id;
+        PortCounters counters;
+    };
+
+    struct Nni {
+        bool enabled;
+        PortCounters counters;
+    };
+
+    struct Flow {
+        uint32_t intf_id;
+        unsigned onu;
+        bool trap;
+    };
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    void run();
+    void tick(TimePoint now);
+    void after(std::chrono::microseconds delay, const std::function<void()>& fn);
+
+    void discover(unsigned count);
+    void generate_packets(unsigned count);
+    void traffic(uint64_t ms);
+    void raise_los();
+    void raise_dying_gasp();
+
+    Onu* find_onu(uint32_t intf_id, uint32_t onu_id, unsigned* index);
+    void onu_up(uint32_t intf_id, unsigned index);
+    void onu_down(uint32_t intf_id, unsigned index, OnuState state);
+    void set_pon(uint32_t intf_id, bool up);
+    void drop_trap(const Flow& flow, uint32_t flow_id);
+    void serial_number(uint32_t intf_id, unsigned index, uint8_t serial[12]) const;
+    bool emit(uint32_t key, const void* rx, size_t len, const void* data = NULL, size_t data_len = 0);
+
+    sim_config config_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool stopping_;
+    std::mt19937 rng_;
+    TimePoint started_at_;
+
+    std::vector<Pon> pons_;
+    std::vector<Nni> nnis_;
+    std::vector<uint32_t> up_;      // (intf_id << 16) | index of the up ONUs
+    std::map<uint64_t, Flow> flows_;    // (flow_id << 1) | downstream
+    std::multimap<TimePoint, std::function<void()> > timers_;
+    unsigned disc_pon_;
+    double disc_credit_;
+    double pkt_credit_;
+    std::string pkt_;
+    TimePoint last_tick_;
+    TimePoint next_los_;
+    TimePoint next_dying_gasp_;
+
+    std::atomic<bool> los_requested_;
+    std::atomic<bool> dying_gasp_requested_;
+    sim_counters counters_;
+    // Counted off the lock, packet_in() may run on any thread
+    std::atomic<uint64_t> pkt_in_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif
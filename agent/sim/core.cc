@@ -15,97 +15,272 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <signal.h>
+#include <thread>
 #include <unistd.h>
+#include <utility>
+#include <vector>
 
-#include "Queue.h"
+#include "IndicationQueue.h"
+#include "WorkerPool.h"
 #include <iostream>
 #include <sstream>
 
 #include "core.h"
 #include "state.h"
+#include "hex_codec.h"
+#include "FlowRegistry.h"
+#include "Metrics.h"
+#include "SimOlt.h"
+#include "StatsCollector.h"
 
 State state;
 
+FlowState flow_state(FLOW_ID_MAX, FLOW_TABLE_SLOTS);
+FlowRegistry flow_registry(FLOW_ID_MAX);
+
+// Stands in for BAL and the OLT, see SimOlt.h for the options below
+static SimOlt simOlt;
+
+// Number of packet indications to stream after OLT up (--ind-flood <count>),
+// used by bench/indication_bench to measure indication throughput.
+static unsigned long ind_flood = 0;
+
+// Indication streams to wait for before OLT up (--ind-subscribers <count>),
+// so that every subscriber of bench/indication_bench sees the whole flood.
+static int ind_subscribers = 1;
+
+// Goes through indShards as BAL packet indications do
+static void FloodIndications() {
+    std::string pkt(64, '\xa5');
+    unsigned long pushed = 0;
+
+    while (pushed < ind_flood) {
+        // What waits on the shards ends up on the packet-in lane too
+        ind_class_counters counters;
+        oltIndQ.get_counters(IND_CLASS_PKT_IN, &counters);
+        uint64_t pending = counters.depth;
+        for (unsigned i = 0; i < indShards.size(); i++) {
+            ind_shard_counters shard;
+            indShards.get_counters(i, &shard);
+            pending += shard.depth;
+        }
+        if (pending > IND_CLASS_PKT_IN_DEPTH * 3 / 4) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (simOlt.packet_in(pushed % 16, 1024 + pushed % 512, 1 + pushed % 16383,
+                             pkt.data(), pkt.size())) {
+            pushed++;
+        }
+    }
+    std::cout << "flooded " << pushed << " packet indications" << std::endl;
+}
+
+// SIGUSR1 raises a LOS, SIGUSR2 a dying gasp storm
+static void InjectFault(int sig) {
+    if (sig == SIGUSR1) {
+        simOlt.inject_los();
+    } else {
+        simOlt.inject_dying_gasp();
+    }
+}
+
 void* RunSim(void *) {
 
     state.activate();
 
-    while (!state.is_connected()) {
+    while (state.connected_streams() < ind_subscribers) {
         sleep(5);
     }
 
-    // Send Olt up indication
-    {
-        openolt::Indication ind;
-        openolt::OltIndication* olt_ind = new openolt::OltIndication;
-        olt_ind->set_oper_state("up");
-        ind.set_allocated_olt_ind(olt_ind);
-        std::cout << "olt indication, oper_state:" << ind.olt_ind().oper_state() << std::endl;
-        oltIndQ.push(ind);
+    simOlt.start();
+
+    if (ind_flood) {
+        FloodIndications();
     }
 
-    // TODO - Add interface and onu indication events
+    for (;;) {
+        sleep(HOUSEKEEPING_PERIOD);
+        std::cout << "Simulated OLT: " << simOlt.counters_to_str() << std::endl;
+    }
+    return NULL;
+}
+
+static void SimCounters(metrics_counters* out) {
+    sim_counters c;
+    simOlt.get_counters(&c);
+    out->push_back(std::make_pair("sim.discovered", c.discovered));
+    out->push_back(std::make_pair("sim.activated", c.activated));
+    out->push_back(std::make_pair("sim.onus_up", c.onus_up));
+    out->push_back(std::make_pair("sim.omci_requests", c.omci_requests));
+    out->push_back(std::make_pair("sim.omci_dropped", c.omci_dropped));
+    out->push_back(std::make_pair("sim.pkt_in", c.pkt_in));
+    out->push_back(std::make_pair("sim.pkt_out", c.pkt_out));
+    out->push_back(std::make_pair("sim.flows", c.flows));
+    out->push_back(std::make_pair("sim.tconts", c.tconts));
+    out->push_back(std::make_pair("sim.dropped", c.dropped));
+}
+
+static bool UintArg(int argc, char *argv[], int* i, const char* name, unsigned* value) {
+    if (strcmp(argv[*i], name) != 0 || *i + 1 >= argc) {
+        return false;
+    }
+    *value = strtoul(argv[++*i], NULL, 10);
+    return true;
 }
 
 Status Enable_(int argc, char *argv[]) {
     pthread_t simThread;
+    sim_config config = SimOlt::default_config();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ind-flood") == 0 && i + 1 < argc) {
+            ind_flood = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ind-subscribers") == 0 && i + 1 < argc) {
+            ind_subscribers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--auto-activate") == 0) {
+            config.auto_activate = true;
+        } else if (UintArg(argc, argv, &i, "--pons", &config.pons) ||
+                   UintArg(argc, argv, &i, "--onus", &config.onus) ||
+                   UintArg(argc, argv, &i, "--nnis", &config.nnis) ||
+                   UintArg(argc, argv, &i, "--discovery-rate", &config.discovery_rate) ||
+                   UintArg(argc, argv, &i, "--activation-ms", &config.activation_ms) ||
+                   UintArg(argc, argv, &i, "--omci-us", &config.omci_us) ||
+                   UintArg(argc, argv, &i, "--pkt-in-rate", &config.pkt_in_rate) ||
+                   UintArg(argc, argv, &i, "--pkt-in-size", &config.pkt_in_size) ||
+                   UintArg(argc, argv, &i, "--onu-pps", &config.onu_pps) ||
+                   UintArg(argc, argv, &i, "--los-period", &config.los_period) ||
+                   UintArg(argc, argv, &i, "--dying-gasp-period", &config.dying_gasp_period) ||
+                   UintArg(argc, argv, &i, "--dying-gasp-onus", &config.dying_gasp_onus) ||
+                   UintArg(argc, argv, &i, "--fault-duration", &config.fault_duration) ||
+                   UintArg(argc, argv, &i, "--seed", &config.seed)) {
+            continue;
+        }
+    }
+    simOlt.configure(config);
+    metrics.add_source(SimCounters);
+
+    signal(SIGUSR1, InjectFault);
+    signal(SIGUSR2, InjectFault);
 
     pthread_create(&simThread, NULL, RunSim, NULL);
     return Status::OK;
 }
 
 Status Disable_() {
-    return Status::OK;
+    Status status = simOlt.disable();
+    if (status.ok()) {
+        state.deactivate();
+    }
+    return status;
 }
 
 Status Reenable_() {
-    return Status::OK;
+    Status status = simOlt.reenable();
+    if (status.ok()) {
+        state.activate();
+    }
+    return status;
 }
 
 Status EnablePonIf_(uint32_t intf_id) {
-    return Status::OK;
+    return simOlt.enable_pon(intf_id);
 }
 
 Status DisableUplinkIf_(uint32_t intf_id) {
-    return Status::OK;
+    return simOlt.disable_nni(intf_id);
 }
 
 Status EnableUplinkIf_(uint32_t intf_id) {
-    return Status::OK;
+    return simOlt.enable_nni(intf_id);
 }
 
 Status DisablePonIf_(uint32_t intf_id) {
-    return Status::OK;
+    return simOlt.disable_pon(intf_id);
 }
 
 Status ActivateOnu_(uint32_t intf_id, uint32_t onu_id,
     const char *vendor_id, const char *vendor_specific, uint32_t pir) {
-    return Status::OK;
+    return simOlt.activate_onu(intf_id, onu_id, vendor_id, vendor_specific);
 }
 
 Status DeactivateOnu_(uint32_t intf_id, uint32_t onu_id,
     const char *vendor_id, const char *vendor_specific) {
-    return Status::OK;
+    return simOlt.deactivate_onu(intf_id, onu_id);
 }
 
 Status DeleteOnu_(uint32_t intf_id, uint32_t onu_id,
     const char *vendor_id, const char *vendor_specific) {
-    return Status::OK;;
+    return simOlt.delete_onu(intf_id, onu_id);
 }
 
-Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string pkt) {
-    return Status::OK;
+#define MAX_OMCI_MSG_LENGTH 44
+Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string& pkt, bool raw) {
+    static thread_local uint8_t omci_frame[MAX_OMCI_MSG_LENGTH];
+    size_t len = std::min(raw ? pkt.size() : pkt.size() / 2, (size_t)MAX_OMCI_MSG_LENGTH);
+
+    if (raw) {
+        return simOlt.omci_out(intf_id, onu_id, (const uint8_t *)pkt.data(), len);
+    }
+    if (!hex_decode(pkt.data(), len, omci_frame)) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid hex OMCI message");
+    }
+    return simOlt.omci_out(intf_id, onu_id, omci_frame, len);
 }
 
-Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string pkt) {
-    return Status::OK;
+Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string& pkt) {
+    uint32_t gemport_id;
+
+    if (port_no > 0 && !flow_state.gemport_of_port(port_no, &gemport_id)) {
+        return grpc::Status(grpc::StatusCode::NOT_FOUND, "no flow for port_no");
+    }
+    return simOlt.onu_packet_out(intf_id, onu_id, pkt.size());
 }
 
-Status UplinkPacketOut_(uint32_t intf_id, const std::string pkt) {
-    return Status::OK;
+Status UplinkPacketOut_(uint32_t intf_id, const std::string& pkt) {
+    return simOlt.uplink_packet_out(intf_id, pkt.size());
+}
+
+uint32_t GetPortNum_(uint32_t flow_id) {
+    return flow_state.port_of_flow(flow_id);
+}
+
+// The flow state is kept as the real agent does, the simulated OLT keeps
+// the flows of each ONU
+static Status FlowSet(int32_t access_intf_id, int32_t onu_id, uint32_t port_no,
+                      uint32_t flow_id, const std::string& flow_type, int32_t gemport_id,
+                      const ::openolt::Action& action, uint64_t cookie) {
+    Status status = simOlt.add_flow(access_intf_id, onu_id, flow_id, flow_type,
+                                    action.cmd().trap_to_host());
+    if (!status.ok()) {
+        flow_registry.remove(flow_id, flow_type == "downstream");
+        return status;
+    }
+    flow_registry.add(flow_id, flow_type == "downstream");
+    if (gemport_id >= 0 && port_no != 0) {
+        FlowState::Update update(flow_state);
+        update.add_flow(flow_id, flow_type == "downstream", port_no, gemport_id, cookie);
+    }
+    return status;
+}
+
+static Status FlowClear(uint32_t flow_id, const std::string& flow_type) {
+    Status status = simOlt.remove_flow(flow_id, flow_type);
+    flow_registry.remove(flow_id, flow_type == "downstream");
+    if (status.ok()) {
+        FlowState::Update(flow_state).remove_flow(flow_id, flow_type == "downstream");
+    }
+    return status;
 }
 
 Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t port_no,
@@ -113,7 +288,7 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
                 int32_t alloc_id, int32_t network_intf_id,
                 int32_t gemport_id, const ::openolt::Classifier& classifier,
                 const ::openolt::Action& action, int32_t priority_value, uint64_t cookie) {
-    return Status::OK;
+    return FlowSet(access_intf_id, onu_id, port_no, flow_id, flow_type, gemport_id, action, cookie);
 }
 
 Status SchedAdd_(int intf_id, int onu_id, int agg_port_id) {
@@ -125,12 +300,140 @@ Status SchedRemove_(int intf_id, int onu_id, int agg_port_id) {
 }
 
 Status FlowRemove_(uint32_t flow_id, const std::string flow_type) {
+    return FlowClear(flow_id, flow_type);
+}
+
+// Partitioned by access interface as in the real agent
+static WorkerPool flow_workers(FLOW_WORKERS);
+
+static unsigned flow_shard(const openolt::Flow& flow) {
+    return flow.access_intf_id() >= 0 ? flow.access_intf_id() : 0;
+}
+
+static void flow_batch_result(const openolt::Flow& flow, const Status& status,
+                              openolt::FlowResult* result) {
+    result->set_flow_id(flow.flow_id());
+    result->set_flow_type(flow.flow_type());
+    result->set_code(status.error_code());
+    result->set_message(status.error_message());
+}
+
+// As in the real agent, a flow repeated in a batch fails after its first
+// occurrence
+static void flow_batch_validate(const openolt::Flows* flows, std::vector<Status>& status) {
+    std::set<std::pair<uint32_t, std::string> > seen;
+
+    for (int i = 0; i < flows->flows_size(); i++) {
+        const openolt::Flow& flow = flows->flows(i);
+        if (!seen.insert(std::make_pair(flow.flow_id(), flow.flow_type())).second) {
+            status[i] = Status(grpc::StatusCode::INVALID_ARGUMENT, "flow repeated in batch");
+        }
+    }
+}
+
+Status FlowAddBatch_(const openolt::Flows* flows, openolt::FlowResults* results) {
+    int n = flows->flows_size();
+    std::vector<Status> status(n);
+
+    flow_batch_validate(flows, status);
+    flow_workers.run(n,
+        [&](size_t i) { return flow_shard(flows->flows(i)); },
+        [&](size_t i) {
+            const openolt::Flow& flow = flows->flows(i);
+            if (!status[i].ok()) {
+                return;
+            }
+            status[i] = FlowSet(flow.access_intf_id(), flow.onu_id(), flow.port_no(),
+                                flow.flow_id(), flow.flow_type(), flow.gemport_id(),
+                                flow.action(), flow.cookie());
+        });
+
+    for (int i = 0; i < n; i++) {
+        flow_batch_result(flows->flows(i), status[i], results->add_results());
+    }
     return Status::OK;
 }
 
+Status FlowRemoveBatch_(const openolt::Flows* flows, openolt::FlowResults* results) {
+    int n = flows->flows_size();
+    std::vector<Status> status(n);
+
+    flow_batch_validate(flows, status);
+    flow_workers.run(n,
+        [&](size_t i) { return flow_shard(flows->flows(i)); },
+        [&](size_t i) {
+            if (!status[i].ok()) {
+                return;
+            }
+            status[i] = FlowClear(flows->flows(i).flow_id(), flows->flows(i).flow_type());
+        });
+
+    for (int i = 0; i < n; i++) {
+        flow_batch_result(flows->flows(i), status[i], results->add_results());
+    }
+    return Status::OK;
+}
+
+// The ports of a collection round, none while Voltha is not connected or
+// the OLT is not up
+static std::vector<StatsPort> stats_ports() {
+    if (!state.is_connected() || !state.is_activated()) {
+        return std::vector<StatsPort>();
+    }
+    return simOlt.stats_ports();
+}
+
+static StatsCollector stats_collector(STATS_WORKERS, STATS_DEADLINE_MS, stats_ports,
+    [](const StatsPort& port, openolt::PortStatistics* port_stats) {
+        return simOlt.port_stats(port, port_stats);
+    });
+
 void stats_collection() {
+    stats_collector.trigger();
+}
+
+// As the real agent, a slice of the flows every FLOW_STATS_PERIOD_MS. The
+// simulated reads take no time, so the slice runs on the scheduler's thread.
+void flow_stats_sweep() {
+    static uint32_t cursor = 0;
+
+    if (!state.is_connected() || !state.is_activated()) {
+        return;
+    }
+
+    std::vector<FlowKey> flows;
+    flows.reserve(FLOW_STATS_SLICE);
+    flow_registry.scan(&cursor, FLOW_STATS_SCAN, FLOW_STATS_SLICE, &flows);
+
+    std::vector<IndicationPtr> inds;
+    inds.reserve(flows.size());
+    for (size_t i = 0; i < flows.size(); i++) {
+        IndicationPtr ind = oltIndQ.get(openolt::Indication::kFlowStats);
+        simOlt.flow_stats(flows[i].flow_id, ind->mutable_flow_stats());
+        inds.push_back(std::move(ind));
+    }
+    if (!inds.empty()) {
+        oltIndQ.push_batch(inds);
+    }
 }
 
 Status GetDeviceInfo_(openolt::DeviceInfo* deviceInfo) {
+    simOlt.get_device_info(deviceInfo);
     return Status::OK;
 }
+
+Status CreateTconts_(const openolt::Tconts *tconts) {
+    return simOlt.add_tconts(tconts);
+}
+
+Status RemoveTconts_(const openolt::Tconts *tconts) {
+    return simOlt.remove_tconts(tconts);
+}
+
+unsigned NumNniIf_() {
+    return simOlt.num_nnis();
+}
+
+unsigned NumPonIf_() {
+    return simOlt.num_pons();
+}
@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bal_metrics.h"
+
+#include <atomic>
+#include <string>
+
+#include "Metrics.h"
+
+enum bal_call {
+    BAL_CFG_SET,
+    BAL_CFG_GET,
+    BAL_CFG_CLEAR,
+    BAL_STAT_GET,
+    BAL_PKT_SEND,
+    BAL_CALL_MAX
+};
+
+// Indexed by object for the cfg and stat calls, by destination type for
+// bal_pkt_send()
+#define BAL_METRIC_KEYS 16
+
+// Histogram and counter ids, registered on first use. Threads racing to
+// register one get the same ids.
+struct BalMetric {
+    std::atomic<bool> registered;
+    std::atomic<int> latency;
+    std::atomic<int> errors;
+};
+
+static BalMetric bal_metrics[BAL_CALL_MAX][BAL_METRIC_KEYS];
+
+static const char* call_name(bal_call call) {
+    switch (call) {
+        case BAL_CFG_SET: return "cfg_set";
+        case BAL_CFG_GET: return "cfg_get";
+        case BAL_CFG_CLEAR: return "cfg_clear";
+        case BAL_STAT_GET: return "stat_get";
+        case BAL_PKT_SEND: return "pkt_send";
+        default: return "unknown";
+    }
+}
+
+static const char* obj_name(unsigned obj) {
+    switch (obj) {
+        case BCMBAL_OBJ_ID_ACCESS_TERMINAL: return "access_terminal";
+        case BCMBAL_OBJ_ID_FLOW: return "flow";
+        case BCMBAL_OBJ_ID_GROUP: return "group";
+        case BCMBAL_OBJ_ID_INTERFACE: return "interface";
+        case BCMBAL_OBJ_ID_PACKET: return "packet";
+        case BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL: return "subscriber_terminal";
+        case BCMBAL_OBJ_ID_TM_QUEUE: return "tm_queue";
+        case BCMBAL_OBJ_ID_TM_SCHED: return "tm_sched";
+        default: return "other";
+    }
+}
+
+static const char* dest_name(unsigned dest) {
+    switch (dest) {
+        case BCMBAL_DEST_TYPE_NNI: return "nni";
+        case BCMBAL_DEST_TYPE_SUB_TERM: return "sub_term";
+        case BCMBAL_DEST_TYPE_SVC_PORT: return "svc_port";
+        case BCMBAL_DEST_TYPE_HOST: return "host";
+        case BCMBAL_DEST_TYPE_ITU_OMCI_CHANNEL: return "omci";
+        case BCMBAL_DEST_TYPE_IEEE_OAM_CHANNEL: return "oam";
+        default: return "other";
+    }
+}
+
+class BalTimer : public MetricsTimer {
+  public:
+    explicit BalTimer(const BalMetric& metric) :
+        MetricsTimer(metric.latency.load(std::memory_order_relaxed)),
+        errors_(metric.errors.load(std::memory_order_relaxed)) {}
+
+    bcmos_errno done(bcmos_errno err) {
+        if (err != BCM_ERR_OK) {
+            metrics.add(errors_);
+        }
+        return err;
+    }
+
+  private:
+    int errors_;
+};
+
+static BalMetric& bal_metric(bal_call call, unsigned key) {
+    BalMetric& metric = bal_metrics[call][key < BAL_METRIC_KEYS ? key : BAL_METRIC_KEYS - 1];
+
+    if (!metric.registered.load(std::memory_order_acquire)) {
+        std::string name = std::string("bal.") + call_name(call) + "." +
+            (call == BAL_PKT_SEND ? dest_name(key) : obj_name(key));
+        metric.errors.store(metrics.counter(name + ".errors"), std::memory_order_relaxed);
+        metric.latency.store(metrics.histogram(name), std::memory_order_relaxed);
+        metric.registered.store(true, std::memory_order_release);
+    }
+    return metric;
+}
+
+bcmos_errno bal_cfg_set(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    BalTimer timer(bal_metric(BAL_CFG_SET, objinfo->obj_type));
+    return timer.done(bcmbal_cfg_set(access_term_id, objinfo));
+}
+
+bcmos_errno bal_cfg_get(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    BalTimer timer(bal_metric(BAL_CFG_GET, objinfo->obj_type));
+    return timer.done(bcmbal_cfg_get(access_term_id, objinfo));
+}
+
+bcmos_errno bal_cfg_clear(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo) {
+    BalTimer timer(bal_metric(BAL_CFG_CLEAR, objinfo->obj_type));
+    return timer.done(bcmbal_cfg_clear(access_term_id, objinfo));
+}
+
+bcmos_errno bal_stat_get(bcmbal_access_id access_term_id, bcmbal_stat *objinfo,
+                         bcmos_bool clear_on_read) {
+    BalTimer timer(bal_metric(BAL_STAT_GET, objinfo->obj_type));
+    return timer.done(bcmbal_stat_get(access_term_id, objinfo, clear_on_read));
+}
+
+bcmos_errno bal_pkt_send(bcmbal_access_id access_term_id, bcmbal_dest dest,
+                         const char *packet_to_send, uint16_t packet_len) {
+    BalTimer timer(bal_metric(BAL_PKT_SEND, dest.type));
+    return timer.done(bcmbal_pkt_send(access_term_id, dest, packet_to_send, packet_len));
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_BAL_METRICS_H_
+#define OPENOLT_BAL_METRICS_H_
+
+#include <cstdint>
+
+extern "C"
+{
+#include <bcmos_system.h>
+#include <bal_api.h>
+#include <bal_api_end.h>
+}
+
+// The BAL calls of the agent, timed into the bal.<call>.<object> histograms
+// of Metrics, e.g. bal.cfg_set.flow, and counted into bal.<call>.<object>.errors
+// when they fail. Packets are keyed by destination, e.g. bal.pkt_send.omci.
+bcmos_errno bal_cfg_set(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bal_cfg_get(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bal_cfg_clear(bcmbal_access_id access_term_id, bcmbal_cfg *objinfo);
+bcmos_errno bal_stat_get(bcmbal_access_id access_term_id, bcmbal_stat *objinfo,
+                         bcmos_bool clear_on_read);
+bcmos_errno bal_pkt_send(bcmbal_access_id access_term_id, bcmbal_dest dest,
+                         const char *packet_to_send, uint16_t packet_len);
+
+#endif
@@ -19,19 +19,30 @@
 #include <memory>
 #include <string>
 
-#include "Queue.h"
+#include "IndicationQueue.h"
 #include <iostream>
 #include <sstream>
 #include <chrono>
+#include <set>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "device.h"
 #include "core.h"
 #include "indications.h"
 #include "stats_collection.h"
 #include "error_format.h"
+#include "bal_metrics.h"
 #include "state.h"
 #include "utils.h"
+#include "hex_codec.h"
+#include "PktBufPool.h"
+#include "WorkerPool.h"
+#include "FlowState.h"
+#include "FlowRegistry.h"
+#include "OnuTracer.h"
+#include "fast_log.h"
 
 extern "C"
 {
@@ -73,11 +84,22 @@ const std::string downstream = "downstream";
 
 State state;
 
-static std::map<uint32_t, uint32_t> flowid_to_port; // For mapping upstream flows to logical ports
-static std::map<uint32_t, uint32_t> flowid_to_gemport; // For mapping downstream flows into gemports
-static std::map<uint32_t, std::set<uint32_t> > port_to_flows; // For mapping logical ports to downstream flows
-static std::map<uint32_t, uint32_t> port_to_alloc;
-static bcmos_fastlock flow_lock;
+// Flow to logical port and gemport mappings, logical port to alloc id
+FlowState flow_state(FLOW_ID_MAX, FLOW_TABLE_SLOTS);
+
+// Every flow BAL holds, for the flow statistics sweep
+FlowRegistry flow_registry(FLOW_ID_MAX);
+
+// Submits batched flow requests to BAL, partitioned by access interface
+static WorkerPool flow_workers(FLOW_WORKERS);
+
+// Staging for packet-out payloads that are not aligned for bcmbal_pkt_send(),
+// created on first use and only if PKT_OUT_ALIGN asks for more than bytes
+static PktBufPool* pkt_out_pool() {
+    static PktBufPool* pool = PKT_OUT_ALIGN > 1 ?
+        new PktBufPool(PKT_OUT_POOL_SIZE, PKT_OUT_MAX_LENGTH, PKT_OUT_ALIGN) : NULL;
+    return pool;
+}
 
 #define MIN_ALLOC_ID_GPON 256
 #define MIN_ALLOC_ID_XGSPON 1024
@@ -130,7 +152,7 @@ Status GetDeviceInfo_(openolt::DeviceInfo* device_info) {
         device_info->set_gemport_id_start(1024);
         device_info->set_gemport_id_end(65535);
         device_info->set_flow_id_start(1);
-        device_info->set_flow_id_end(16383);
+        device_info->set_flow_id_end(FLOW_ID_MAX);
     }
     else if (board_technology == "gpon") {
         device_info->set_onu_id_start(1);
@@ -140,7 +162,7 @@ Status GetDeviceInfo_(openolt::DeviceInfo* device_info) {
         device_info->set_gemport_id_start(256);
         device_info->set_gemport_id_end(4095);
         device_info->set_flow_id_start(1);
-        device_info->set_flow_id_end(16383);
+        device_info->set_flow_id_end(FLOW_ID_MAX);
     }
 
     std::map<std::string, openolt::DeviceInfo::DeviceResourceRanges*> ranges;
@@ -231,7 +253,7 @@ Status Enable_(int argc, char *argv[]) {
 
         vendor_init();
         bcmbal_init(argc, argv, NULL);
-        bcmos_fastlock_init(&flow_lock, 0);
+        fast_log_init();
 
         BCM_LOG(INFO, openolt_log_id, "Enable OLT - %s-%s\n", VENDOR_ID, MODEL_ID);
 
@@ -247,13 +269,11 @@ Status Enable_(int argc, char *argv[]) {
         key.access_term_id = DEFAULT_ATERM_ID;
         BCMBAL_CFG_INIT(&acc_term_obj, access_terminal, key);
         BCMBAL_CFG_PROP_SET(&acc_term_obj, access_terminal, admin_state, BCMBAL_STATE_UP);
-        bcmos_errno err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(acc_term_obj.hdr));
+        bcmos_errno err = bal_cfg_set(DEFAULT_ATERM_ID, &(acc_term_obj.hdr));
         if (err) {
             BCM_LOG(ERROR, openolt_log_id, "Failed to enable OLT\n");
             return bcm_to_grpc_err(err, "Failed to enable OLT");
         }
-
-        init_stats();
     }
 
     //If already enabled, generate an extra indication ????
@@ -283,12 +303,10 @@ Status Disable_() {
     Status status = DisableUplinkIf_(0);
     if (status.ok()) {
         state.deactivate();
-        openolt::Indication ind;
-        openolt::OltIndication* olt_ind = new openolt::OltIndication;
-        olt_ind->set_oper_state("down");
-        ind.set_allocated_olt_ind(olt_ind);
+        IndicationPtr ind = oltIndQ.get(openolt::Indication::kOltInd);
+        ind->mutable_olt_ind()->set_oper_state("down");
         BCM_LOG(INFO, openolt_log_id, "Disable OLT, add an extra indication\n");
-        oltIndQ.push(ind);
+        oltIndQ.push(std::move(ind));
     }
     return status;
 
@@ -298,12 +316,10 @@ Status Reenable_() {
     Status status = EnableUplinkIf_(0);
     if (status.ok()) {
         state.activate();
-        openolt::Indication ind;
-        openolt::OltIndication* olt_ind = new openolt::OltIndication;
-        olt_ind->set_oper_state("up");
-        ind.set_allocated_olt_ind(olt_ind);
+        IndicationPtr ind = oltIndQ.get(openolt::Indication::kOltInd);
+        ind->mutable_olt_ind()->set_oper_state("up");
         BCM_LOG(INFO, openolt_log_id, "Reenable OLT, add an extra indication\n");
-        oltIndQ.push(ind);
+        oltIndQ.push(std::move(ind));
     }
     return status;
 }
@@ -318,7 +334,7 @@ Status EnablePonIf_(uint32_t intf_id) {
     BCMBAL_CFG_INIT(&interface_obj, interface, interface_key);
 
     BCMBAL_CFG_PROP_GET(&interface_obj, interface, admin_state);
-    bcmos_errno err = bcmbal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    bcmos_errno err = bal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err == BCM_ERR_OK && interface_obj.data.admin_state == BCMBAL_STATE_UP) {
         BCM_LOG(DEBUG, openolt_log_id, "PON interface: %d already enabled\n", intf_id);
         return Status::OK;
@@ -326,7 +342,7 @@ Status EnablePonIf_(uint32_t intf_id) {
 
     BCMBAL_CFG_PROP_SET(&interface_obj, interface, admin_state, BCMBAL_STATE_UP);
 
-    err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    err = bal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to enable PON interface: %d\n", intf_id);
         return bcm_to_grpc_err(err, "Failed to enable PON interface");
@@ -345,7 +361,7 @@ Status DisableUplinkIf_(uint32_t intf_id) {
     BCMBAL_CFG_INIT(&interface_obj, interface, interface_key);
     BCMBAL_CFG_PROP_SET(&interface_obj, interface, admin_state, BCMBAL_STATE_DOWN);
 
-    bcmos_errno err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    bcmos_errno err = bal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to disable Uplink interface: %d\n", intf_id);
         return bcm_to_grpc_err(err, "Failed to disable Uplink interface");
@@ -365,7 +381,7 @@ Status ProbeDeviceCapabilities_() {
     BCMBAL_CFG_PROP_GET(&acc_term_obj, access_terminal, topology);
     BCMBAL_CFG_PROP_GET(&acc_term_obj, access_terminal, sw_version);
     BCMBAL_CFG_PROP_GET(&acc_term_obj, access_terminal, conn_id);
-    bcmos_errno err = bcmbal_cfg_get(DEFAULT_ATERM_ID, &(acc_term_obj.hdr));
+    bcmos_errno err = bal_cfg_get(DEFAULT_ATERM_ID, &(acc_term_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to query OLT\n");
         return bcm_to_grpc_err(err, "Failed to query OLT");
@@ -422,7 +438,7 @@ Status ProbePonIfTechnology_() {
         BCMBAL_CFG_PROP_GET(&interface_obj, interface, admin_state);
         BCMBAL_CFG_PROP_GET(&interface_obj, interface, transceiver_type);
 
-        bcmos_errno err = bcmbal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+        bcmos_errno err = bal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
         if (err != BCM_ERR_OK) {
             intf_technologies[intf_id] = UNKNOWN_TECH;
             if(err != BCM_ERR_RANGE) BCM_LOG(ERROR, openolt_log_id, "Failed to get PON config: %d\n", intf_id);
@@ -468,7 +484,7 @@ Status EnableUplinkIf_(uint32_t intf_id) {
     BCMBAL_CFG_INIT(&interface_obj, interface, interface_key);
 
     BCMBAL_CFG_PROP_GET(&interface_obj, interface, admin_state);
-    bcmos_errno err = bcmbal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    bcmos_errno err = bal_cfg_get(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err == BCM_ERR_OK && interface_obj.data.admin_state == BCMBAL_STATE_UP) {
         BCM_LOG(DEBUG, openolt_log_id, "Uplink interface: %d already enabled\n", intf_id);
         return Status::OK;
@@ -476,7 +492,7 @@ Status EnableUplinkIf_(uint32_t intf_id) {
 
     BCMBAL_CFG_PROP_SET(&interface_obj, interface, admin_state, BCMBAL_STATE_UP);
 
-    err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    err = bal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to enable Uplink interface: %d\n", intf_id);
         return bcm_to_grpc_err(err, "Failed to enable Uplink interface");
@@ -495,7 +511,7 @@ Status DisablePonIf_(uint32_t intf_id) {
     BCMBAL_CFG_INIT(&interface_obj, interface, interface_key);
     BCMBAL_CFG_PROP_SET(&interface_obj, interface, admin_state, BCMBAL_STATE_DOWN);
 
-    bcmos_errno err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
+    bcmos_errno err = bal_cfg_set(DEFAULT_ATERM_ID, &(interface_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to disable PON interface: %d\n", intf_id);
         return bcm_to_grpc_err(err, "Failed to disable PON interface");
@@ -514,6 +530,7 @@ Status ActivateOnu_(uint32_t intf_id, uint32_t onu_id,
 
     BCM_LOG(INFO, openolt_log_id,  "Enabling ONU %d on PON %d : vendor id %s, vendor specific %s, pir %d\n",
         onu_id, intf_id, vendor_id, vendor_specific_to_str(vendor_specific).c_str(), pir);
+    onuTracer.activate(intf_id, onu_id, vendor_id, vendor_specific);
 
     subs_terminal_key.sub_term_id = onu_id;
     subs_terminal_key.intf_id = intf_id;
@@ -534,7 +551,7 @@ Status ActivateOnu_(uint32_t intf_id, uint32_t onu_id,
 
     BCMBAL_CFG_PROP_SET(&sub_term_obj, subscriber_terminal, admin_state, BCMBAL_STATE_UP);
 
-    bcmos_errno err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(sub_term_obj.hdr));
+    bcmos_errno err = bal_cfg_set(DEFAULT_ATERM_ID, &(sub_term_obj.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id, "Failed to enable ONU %d on PON %d\n", onu_id, intf_id);
         return bcm_to_grpc_err(err, "Failed to enable ONU");
@@ -557,7 +574,7 @@ Status DeactivateOnu_(uint32_t intf_id, uint32_t onu_id,
 
     BCMBAL_CFG_PROP_SET(&sub_term_obj, subscriber_terminal, admin_state, BCMBAL_STATE_DOWN);
 
-    if (bcmbal_cfg_set(DEFAULT_ATERM_ID, &(sub_term_obj.hdr))) {
+    if (bal_cfg_set(DEFAULT_ATERM_ID, &(sub_term_obj.hdr))) {
         BCM_LOG(ERROR, openolt_log_id,  "Failed to deactivate ONU %d on PON %d\n", onu_id, intf_id);
         return Status(grpc::StatusCode::INTERNAL, "Failed to deactivate ONU");
     }
@@ -570,6 +587,7 @@ Status DeleteOnu_(uint32_t intf_id, uint32_t onu_id,
 
     BCM_LOG(INFO, openolt_log_id,  "DeleteOnu ONU %d on PON %d : vendor id %s, vendor specific %s\n",
         onu_id, intf_id, vendor_id, vendor_specific_to_str(vendor_specific).c_str());
+    onuTracer.trace(intf_id, onu_id, ONU_STAGE_DOWN);
 
     // Need to deactivate before removing it (BAL rules)
 
@@ -600,7 +618,7 @@ Status DeleteOnu_(uint32_t intf_id, uint32_t onu_id,
 
     BCMBAL_CFG_INIT(&cfg, subscriber_terminal, key);
 
-    err = bcmbal_cfg_clear(DEFAULT_ATERM_ID, &cfg.hdr);
+    err = bal_cfg_clear(DEFAULT_ATERM_ID, &cfg.hdr);
     if (err != BCM_ERR_OK)
     {
        BCM_LOG(ERROR, openolt_log_id, "Failed to clear information for BAL subscriber_terminal_id %d, Interface ID %d\n",
@@ -611,9 +629,10 @@ Status DeleteOnu_(uint32_t intf_id, uint32_t onu_id,
     return Status::OK;;
 }
 
-#define MAX_CHAR_LENGTH  20
 #define MAX_OMCI_MSG_LENGTH 44
-Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string pkt) {
+Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string& pkt, bool raw) {
+    // Hex OMCI messages are decoded here; bcmbal_pkt_send() copies the frame
+    static thread_local uint8_t omci_frame[MAX_OMCI_MSG_LENGTH];
     bcmbal_u8_list_u32_max_2048 buf; /* A structure with a msg pointer and length value */
     bcmos_errno err = BCM_ERR_OK;
 
@@ -625,66 +644,49 @@ Status OmciMsgOut_(uint32_t intf_id, uint32_t onu_id, const std::string pkt) {
     proxy_pkt_dest.u.itu_omci_channel.intf_id = intf_id;
 
     // ???
-    if ((pkt.size()/2) > MAX_OMCI_MSG_LENGTH) {
+    size_t len = raw ? pkt.size() : pkt.size()/2;
+    if (len > MAX_OMCI_MSG_LENGTH) {
         buf.len = MAX_OMCI_MSG_LENGTH;
     } else {
-        buf.len = pkt.size()/2;
+        buf.len = len;
     }
 
-    /* Send the OMCI packet using the BAL remote proxy API */
-    uint16_t idx1 = 0;
-    uint16_t idx2 = 0;
-    uint8_t arraySend[buf.len];
-    char str1[MAX_CHAR_LENGTH];
-    char str2[MAX_CHAR_LENGTH];
-    memset(&arraySend, 0, buf.len);
-
-    for (idx1=0,idx2=0; idx1<((buf.len)*2); idx1++,idx2++) {
-       sprintf(str1,"%c", pkt[idx1]);
-       sprintf(str2,"%c", pkt[++idx1]);
-       strcat(str1,str2);
-       arraySend[idx2] = strtol(str1, NULL, 16);
+    if (raw) {
+        buf.val = (uint8_t *)pkt.data();
+    } else {
+        if (!hex_decode(pkt.data(), buf.len, omci_frame)) {
+            BCM_LOG(ERROR, omci_log_id, "Invalid hex OMCI message to ONU %d on PON %d\n", onu_id, intf_id);
+            return bcm_to_grpc_err(BCM_ERR_PARM, "Invalid hex OMCI message");
+        }
+        buf.val = omci_frame;
     }
 
-    buf.val = (uint8_t *)malloc((buf.len)*sizeof(uint8_t));
-    memcpy(buf.val, (uint8_t *)arraySend, buf.len);
+    onuTracer.trace(intf_id, onu_id, ONU_STAGE_OMCI_OUT);
 
-    err = bcmbal_pkt_send(0, proxy_pkt_dest, (const char *)(buf.val), buf.len);
+    /* Send the OMCI packet using the BAL remote proxy API */
+    err = bal_pkt_send(0, proxy_pkt_dest, (const char *)(buf.val), buf.len);
 
     if (err) {
         BCM_LOG(ERROR, omci_log_id, "Error sending OMCI message to ONU %d on PON %d\n", onu_id, intf_id);
     } else {
-        BCM_LOG(DEBUG, omci_log_id, "OMCI request msg of length %d sent to ONU %d on PON %d : %s\n",
-            buf.len, onu_id, intf_id, pkt.c_str());
+        BCM_LOG(DEBUG, omci_log_id, "OMCI request msg of length %d sent to ONU %d on PON %d%s%s\n",
+            buf.len, onu_id, intf_id, raw ? "" : " : ", raw ? "" : pkt.c_str());
     }
 
-    free(buf.val);
-
     return Status::OK;
 }
 
-Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string pkt) {
+Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const std::string& pkt) {
     bcmos_errno err = BCM_ERR_OK;
     bcmbal_dest proxy_pkt_dest;
-    bcmbal_u8_list_u32_max_2048 buf;
 
     if (port_no > 0) {
         bool found = false;
         uint32_t gemport_id;
 
-        bcmos_fastlock_lock(&flow_lock);
         // Map the port_no to one of the flows that owns it to find a gemport_id for that flow.
         // Pick any flow that is mapped with the same port_no.
-        std::map<uint32_t, std::set<uint32_t> >::const_iterator it = port_to_flows.find(port_no);
-        if (it != port_to_flows.end() && !it->second.empty()) {
-            uint32_t flow_id = *(it->second.begin()); // Pick any flow_id out of the bag set
-            std::map<uint32_t, uint32_t>::const_iterator fit = flowid_to_gemport.find(flow_id);
-            if (fit != flowid_to_gemport.end()) {
-                found = true;
-                gemport_id = fit->second;
-            }
-        }
-        bcmos_fastlock_unlock(&flow_lock, 0);
+        found = flow_state.gemport_of_port(port_no, &gemport_id);
 
         if (!found) {
             BCM_LOG(ERROR, openolt_log_id, "Packet out failed to find destination for ONU %d port_no %u on PON %d\n",
@@ -695,83 +697,92 @@ Status OnuPacketOut_(uint32_t intf_id, uint32_t onu_id, uint32_t port_no, const
         proxy_pkt_dest.type = BCMBAL_DEST_TYPE_SVC_PORT;
         proxy_pkt_dest.u.svc_port.svc_port_id = gemport_id;
         proxy_pkt_dest.u.svc_port.intf_id = intf_id;
-        BCM_LOG(INFO, openolt_log_id, "Packet out of length %d sent to gemport %d on pon %d port_no %u\n",
+        FAST_LOG(INFO, openolt_log_id, "Packet out of length %d sent to gemport %d on pon %d port_no %u\n",
             pkt.size(), gemport_id, intf_id, port_no);
     }
     else {
         proxy_pkt_dest.type = BCMBAL_DEST_TYPE_SUB_TERM,
         proxy_pkt_dest.u.sub_term.sub_term_id = onu_id;
         proxy_pkt_dest.u.sub_term.intf_id = intf_id;
-        BCM_LOG(INFO, openolt_log_id, "Packet out of length %d sent to onu %d on pon %d\n",
+        FAST_LOG(INFO, openolt_log_id, "Packet out of length %d sent to onu %d on pon %d\n",
             pkt.size(), onu_id, intf_id);
     }
 
-    buf.len = pkt.size();
-    buf.val = (uint8_t *)malloc((buf.len)*sizeof(uint8_t));
-    memcpy(buf.val, (uint8_t *)pkt.data(), buf.len);
-
-    err = bcmbal_pkt_send(0, proxy_pkt_dest, (const char *)(buf.val), buf.len);
-
-    free(buf.val);
+    PktOutData data(pkt_out_pool(), pkt);
+    err = bal_pkt_send(0, proxy_pkt_dest, data.data(), data.size());
+    if (err != BCM_ERR_OK) {
+        FAST_LOG(ERROR, openolt_log_id, "Packet out to ONU %d port_no %u on PON %d failed, err %d\n",
+            onu_id, port_no, intf_id, err);
+        return bcm_to_grpc_err(err, "Packet out failed");
+    }
 
     return Status::OK;
 }
 
-Status UplinkPacketOut_(uint32_t intf_id, const std::string pkt) {
+Status UplinkPacketOut_(uint32_t intf_id, const std::string& pkt) {
     bcmos_errno err = BCM_ERR_OK;
     bcmbal_dest proxy_pkt_dest;
-    bcmbal_u8_list_u32_max_2048 buf;
 
     proxy_pkt_dest.type = BCMBAL_DEST_TYPE_NNI,
     proxy_pkt_dest.u.nni.intf_id = intf_id;
 
-    buf.len = pkt.size();
-    buf.val = (uint8_t *)malloc((buf.len)*sizeof(uint8_t));
-    memcpy(buf.val, (uint8_t *)pkt.data(), buf.len);
-
-    err = bcmbal_pkt_send(0, proxy_pkt_dest, (const char *)(buf.val), buf.len);
-
-    BCM_LOG(INFO, openolt_log_id, "Packet out of length %d sent through uplink port %d\n",
-        buf.len, intf_id);
+    PktOutData data(pkt_out_pool(), pkt);
+    err = bal_pkt_send(0, proxy_pkt_dest, data.data(), data.size());
+    if (err != BCM_ERR_OK) {
+        FAST_LOG(ERROR, openolt_log_id, "Packet out through uplink port %d failed, err %d\n",
+            intf_id, err);
+        return bcm_to_grpc_err(err, "Packet out failed");
+    }
 
-    free(buf.val);
+    FAST_LOG(INFO, openolt_log_id, "Packet out of length %d sent through uplink port %d\n",
+        data.size(), intf_id);
 
     return Status::OK;
 }
 
 uint32_t GetPortNum_(uint32_t flow_id)
 {
-    bcmos_fastlock_lock(&flow_lock);
-    uint32_t port_no = 0;
-    std::map<uint32_t, uint32_t >::const_iterator it = flowid_to_port.find(flow_id);
-    if (it != flowid_to_port.end()) {
-        port_no = it->second;
-    }
-    bcmos_fastlock_unlock(&flow_lock, 0);
-    return port_no;
+    return flow_state.port_of_flow(flow_id);
 }
 
-Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t port_no,
-                uint32_t flow_id, const std::string flow_type,
-                int32_t alloc_id, int32_t network_intf_id,
-                int32_t gemport_id, const ::openolt::Classifier& classifier,
-                const ::openolt::Action& action, int32_t priority_value, uint64_t cookie) {
-    bcmos_errno err;
-    bcmbal_flow_cfg cfg;
-    bcmbal_flow_key key = { };
-
-    BCM_LOG(INFO, openolt_log_id, "flow add - intf_id %d, onu_id %d, uni_id %d, port_no %u, flow_id %d, flow_type %s, gemport_id %d, network_intf_id %d, cookie %llu\n",
-        access_intf_id, onu_id, uni_id, port_no, flow_id, flow_type.c_str(), gemport_id, network_intf_id, cookie);
-
-    key.flow_id = flow_id;
+static Status mk_flow_key(uint32_t flow_id, const std::string& flow_type, bcmbal_flow_key* key) {
+    key->flow_id = flow_id;
     if (flow_type.compare("upstream") == 0 ) {
-        key.flow_type = BCMBAL_FLOW_TYPE_UPSTREAM;
+        key->flow_type = BCMBAL_FLOW_TYPE_UPSTREAM;
     } else if (flow_type.compare("downstream") == 0) {
-        key.flow_type = BCMBAL_FLOW_TYPE_DOWNSTREAM;
+        key->flow_type = BCMBAL_FLOW_TYPE_DOWNSTREAM;
     } else {
         BCM_LOG(WARNING, openolt_log_id, "Invalid flow type %s\n", flow_type.c_str());
         return bcm_to_grpc_err(BCM_ERR_PARM, "Invalid flow type");
     }
+    return Status::OK;
+}
+
+// Records the port_no and gemport of a new flow
+static void flow_map_add(FlowState::Update& update, const bcmbal_flow_key& key,
+                         int32_t gemport_id, uint32_t port_no, uint64_t cookie) {
+    if (gemport_id >= 0 && port_no != 0) {
+        if (!update.add_flow(key.flow_id, key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM,
+                             port_no, gemport_id, cookie)) {
+            BCM_LOG(ERROR, openolt_log_id, "flow_id %d port_no %u not mapped, flow id out of range or flow state full\n",
+                key.flow_id, port_no);
+        }
+    }
+}
+
+// Forgets the port_no and gemport of a removed flow
+static void flow_map_remove(FlowState::Update& update, const bcmbal_flow_key& key) {
+    update.remove_flow(key.flow_id, key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM);
+}
+
+// Programs a flow whose key is valid and whose mappings are recorded
+static Status flow_cfg_set(const bcmbal_flow_key& key, int32_t access_intf_id, int32_t onu_id,
+                           int32_t uni_id, uint32_t port_no,
+                           int32_t alloc_id, int32_t network_intf_id,
+                           int32_t gemport_id, const ::openolt::Classifier& classifier,
+                           const ::openolt::Action& action, int32_t priority_value, uint64_t cookie) {
+    bcmos_errno err;
+    bcmbal_flow_cfg cfg;
 
     BCMBAL_CFG_INIT(&cfg, flow, key);
 
@@ -790,18 +801,6 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
     if (gemport_id >= 0) {
         BCMBAL_CFG_PROP_SET(&cfg, flow, svc_port_id, gemport_id);
     }
-    if (gemport_id >= 0 && port_no != 0) {
-        bcmos_fastlock_lock(&flow_lock);
-        if (key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM) {
-            port_to_flows[port_no].insert(key.flow_id);
-            flowid_to_gemport[key.flow_id] = gemport_id;
-        }
-        else
-        {
-            flowid_to_port[key.flow_id] = port_no;
-        }
-        bcmos_fastlock_unlock(&flow_lock, 0);
-    }
     if (priority_value >= 0) {
         BCMBAL_CFG_PROP_SET(&cfg, flow, priority, priority_value);
     }
@@ -810,37 +809,37 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         bcmbal_classifier val = { };
 
         if (classifier.o_tpid()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify o_tpid 0x%04x\n", classifier.o_tpid());
+            FAST_LOG(DEBUG, openolt_log_id, "classify o_tpid 0x%04x\n", classifier.o_tpid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, o_tpid, classifier.o_tpid());
         }
 
         if (classifier.o_vid()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify o_vid %d\n", classifier.o_vid());
+            FAST_LOG(DEBUG, openolt_log_id, "classify o_vid %d\n", classifier.o_vid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, o_vid, classifier.o_vid());
         }
 
         if (classifier.i_tpid()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify i_tpid 0x%04x\n", classifier.i_tpid());
+            FAST_LOG(DEBUG, openolt_log_id, "classify i_tpid 0x%04x\n", classifier.i_tpid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, i_tpid, classifier.i_tpid());
         }
 
         if (classifier.i_vid()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify i_vid %d\n", classifier.i_vid());
+            FAST_LOG(DEBUG, openolt_log_id, "classify i_vid %d\n", classifier.i_vid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, i_vid, classifier.i_vid());
         }
 
         if (classifier.o_pbits()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify o_pbits 0x%x\n", classifier.o_pbits());
+            FAST_LOG(DEBUG, openolt_log_id, "classify o_pbits 0x%x\n", classifier.o_pbits());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, o_pbits, classifier.o_pbits());
         }
 
         if (classifier.i_pbits()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify i_pbits 0x%x\n", classifier.i_pbits());
+            FAST_LOG(DEBUG, openolt_log_id, "classify i_pbits 0x%x\n", classifier.i_pbits());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, i_pbits, classifier.i_pbits());
         }
 
         if (classifier.eth_type()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify ether_type 0x%04x\n", classifier.eth_type());
+            FAST_LOG(DEBUG, openolt_log_id, "classify ether_type 0x%04x\n", classifier.eth_type());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, ether_type, classifier.eth_type());
         }
 
@@ -855,7 +854,7 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         */
 
         if (classifier.ip_proto()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify ip_proto %d\n", classifier.ip_proto());
+            FAST_LOG(DEBUG, openolt_log_id, "classify ip_proto %d\n", classifier.ip_proto());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, ip_proto, classifier.ip_proto());
         }
 
@@ -870,17 +869,17 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         */
 
         if (classifier.src_port()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify src_port %d\n", classifier.src_port());
+            FAST_LOG(DEBUG, openolt_log_id, "classify src_port %d\n", classifier.src_port());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, src_port, classifier.src_port());
         }
 
         if (classifier.dst_port()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify dst_port %d\n", classifier.dst_port());
+            FAST_LOG(DEBUG, openolt_log_id, "classify dst_port %d\n", classifier.dst_port());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, dst_port, classifier.dst_port());
         }
 
         if (!classifier.pkt_tag_type().empty()) {
-            BCM_LOG(DEBUG, openolt_log_id, "classify tag_type %s\n", classifier.pkt_tag_type().c_str());
+            FAST_LOG(DEBUG, openolt_log_id, "classify tag_type %s\n", classifier.pkt_tag_type().c_str());
             if (classifier.pkt_tag_type().compare("untagged") == 0) {
                 BCMBAL_ATTRIBUTE_PROP_SET(&val, classifier, pkt_tag_type, BCMBAL_PKT_TAG_TYPE_UNTAGGED);
             } else if (classifier.pkt_tag_type().compare("single_tag") == 0) {
@@ -899,47 +898,47 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         const ::openolt::ActionCmd& cmd = action.cmd();
 
         if (cmd.add_outer_tag()) {
-            BCM_LOG(INFO, openolt_log_id, "action add o_tag\n");
+            FAST_LOG(INFO, openolt_log_id, "action add o_tag\n");
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, cmds_bitmask, BCMBAL_ACTION_CMD_ID_ADD_OUTER_TAG);
         }
 
         if (cmd.remove_outer_tag()) {
-            BCM_LOG(INFO, openolt_log_id, "action pop o_tag\n");
+            FAST_LOG(INFO, openolt_log_id, "action pop o_tag\n");
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, cmds_bitmask, BCMBAL_ACTION_CMD_ID_REMOVE_OUTER_TAG);
         }
 
         if (cmd.trap_to_host()) {
-            BCM_LOG(INFO, openolt_log_id, "action trap-to-host\n");
+            FAST_LOG(INFO, openolt_log_id, "action trap-to-host\n");
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, cmds_bitmask, BCMBAL_ACTION_CMD_ID_TRAP_TO_HOST);
         }
 
         if (action.o_vid()) {
-            BCM_LOG(INFO, openolt_log_id, "action o_vid=%d\n", action.o_vid());
+            FAST_LOG(INFO, openolt_log_id, "action o_vid=%d\n", action.o_vid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, o_vid, action.o_vid());
         }
 
         if (action.o_pbits()) {
-            BCM_LOG(INFO, openolt_log_id, "action o_pbits=0x%x\n", action.o_pbits());
+            FAST_LOG(INFO, openolt_log_id, "action o_pbits=0x%x\n", action.o_pbits());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, o_pbits, action.o_pbits());
         }
 
         if (action.o_tpid()) {
-            BCM_LOG(INFO, openolt_log_id, "action o_tpid=0x%04x\n", action.o_tpid());
+            FAST_LOG(INFO, openolt_log_id, "action o_tpid=0x%04x\n", action.o_tpid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, o_tpid, action.o_tpid());
         }
 
         if (action.i_vid()) {
-            BCM_LOG(INFO, openolt_log_id, "action i_vid=%d\n", action.i_vid());
+            FAST_LOG(INFO, openolt_log_id, "action i_vid=%d\n", action.i_vid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, i_vid, action.i_vid());
         }
 
         if (action.i_pbits()) {
-            BCM_LOG(DEBUG, openolt_log_id, "action i_pbits=0x%x\n", action.i_pbits());
+            FAST_LOG(DEBUG, openolt_log_id, "action i_pbits=0x%x\n", action.i_pbits());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, i_pbits, action.i_pbits());
         }
 
         if (action.i_tpid()) {
-            BCM_LOG(DEBUG, openolt_log_id, "action i_tpid=0x%04x\n", action.i_tpid());
+            FAST_LOG(DEBUG, openolt_log_id, "action i_tpid=0x%04x\n", action.i_tpid());
             BCMBAL_ATTRIBUTE_PROP_SET(&val, action, i_tpid, action.i_tpid());
         }
 
@@ -951,10 +950,7 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         if (key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM) {
             bcmbal_tm_queue_ref val = { };
             val.sched_id = mk_sched_id(access_intf_id, onu_id, "downstream");
-            uint32_t alloc_id;
-            bcmos_fastlock_lock(&flow_lock);
-            alloc_id = port_to_alloc[port_no];
-            bcmos_fastlock_unlock(&flow_lock, 0);
+            uint32_t alloc_id = flow_state.alloc_of_port(port_no);
             val.queue_id = mk_queue_id(access_intf_id, onu_id, uni_id, port_no, alloc_id);
             BCMBAL_CFG_PROP_SET(&cfg, flow, queue, val);
         } else if (key.flow_type == BCMBAL_FLOW_TYPE_UPSTREAM) {
@@ -972,57 +968,180 @@ Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t
         }
     }
 
-    err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(cfg.hdr));
+    err = bal_cfg_set(DEFAULT_ATERM_ID, &(cfg.hdr));
     if (err) {
         BCM_LOG(ERROR, openolt_log_id,  "Flow add failed\n");
         return bcm_to_grpc_err(err, "flow add failed");
     }
+    if (access_intf_id >= 0 && onu_id >= 0) {
+        onuTracer.trace(access_intf_id, onu_id, ONU_STAGE_FLOW);
+    }
 
-    // register_new_flow(key);
+    // Registered only once BAL has it; a failed re-add or modify leaves a
+    // flow that is already registered in the sweep
+    flow_registry.add(key.flow_id, key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM);
 
     return Status::OK;
 }
 
-Status FlowRemove_(uint32_t flow_id, const std::string flow_type) {
-
+static Status flow_cfg_clear(const bcmbal_flow_key& key, const std::string& flow_type) {
     bcmbal_flow_cfg cfg;
+
+    BCMBAL_CFG_INIT(&cfg, flow, key);
+
+    // Dropped even if BAL fails to clear it, which the sweep would keep
+    // failing to read
+    flow_registry.remove(key.flow_id, key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM);
+
+    bcmos_errno err = bal_cfg_clear(DEFAULT_ATERM_ID, &cfg.hdr);
+    if (err) {
+        BCM_LOG(ERROR, openolt_log_id, "Error %d while removing flow %d, %s\n",
+            err, key.flow_id, flow_type.c_str());
+        return Status(grpc::StatusCode::INTERNAL, "Failed to remove flow");
+    }
+
+    FAST_LOG(INFO, openolt_log_id, "Flow %d, %s removed\n", key.flow_id, flow_type.c_str());
+    return Status::OK;
+}
+
+Status FlowAdd_(int32_t access_intf_id, int32_t onu_id, int32_t uni_id, uint32_t port_no,
+                uint32_t flow_id, const std::string flow_type,
+                int32_t alloc_id, int32_t network_intf_id,
+                int32_t gemport_id, const ::openolt::Classifier& classifier,
+                const ::openolt::Action& action, int32_t priority_value, uint64_t cookie) {
     bcmbal_flow_key key = { };
 
-    key.flow_id = (bcmbal_flow_id) flow_id;
-    key.flow_id = flow_id;
-    if (flow_type.compare("upstream") == 0 ) {
-        key.flow_type = BCMBAL_FLOW_TYPE_UPSTREAM;
-    } else if (flow_type.compare("downstream") == 0) {
-        key.flow_type = BCMBAL_FLOW_TYPE_DOWNSTREAM;
-    } else {
-        BCM_LOG(WARNING, openolt_log_id, "Invalid flow type %s\n", flow_type.c_str());
-        return bcm_to_grpc_err(BCM_ERR_PARM, "Invalid flow type");
+    FAST_LOG(INFO, openolt_log_id, "flow add - intf_id %d, onu_id %d, uni_id %d, port_no %u, flow_id %d, flow_type %s, gemport_id %d, network_intf_id %d, cookie %llu\n",
+        access_intf_id, onu_id, uni_id, port_no, flow_id, flow_type.c_str(), gemport_id, network_intf_id, cookie);
+
+    Status status = mk_flow_key(flow_id, flow_type, &key);
+    if (!status.ok()) {
+        return status;
+    }
+
+    {
+        FlowState::Update update(flow_state);
+        flow_map_add(update, key, gemport_id, port_no, cookie);
     }
 
-    bcmos_fastlock_lock(&flow_lock);
-    uint32_t port_no = flowid_to_port[key.flow_id];
-    if (key.flow_type == BCMBAL_FLOW_TYPE_DOWNSTREAM) {
-        flowid_to_gemport.erase(key.flow_id);
-        port_to_flows[port_no].erase(key.flow_id);
-        if (port_to_flows[port_no].empty()) port_to_flows.erase(port_no);
+    return flow_cfg_set(key, access_intf_id, onu_id, uni_id, port_no, alloc_id, network_intf_id,
+                        gemport_id, classifier, action, priority_value, cookie);
+}
+
+Status FlowRemove_(uint32_t flow_id, const std::string flow_type) {
+    bcmbal_flow_key key = { };
+
+    Status status = mk_flow_key(flow_id, flow_type, &key);
+    if (!status.ok()) {
+        return status;
     }
-    else
+
     {
-        flowid_to_port.erase(key.flow_id);
+        FlowState::Update update(flow_state);
+        flow_map_remove(update, key);
     }
-    bcmos_fastlock_unlock(&flow_lock, 0);
 
-    BCMBAL_CFG_INIT(&cfg, flow, key);
+    return flow_cfg_clear(key, flow_type);
+}
 
+// Batched FlowAdd_/FlowRemove_: every flow is validated first, the mappings
+// of the valid ones are updated in a single flow state update, then the BAL
+// requests go out on flow_workers, partitioned by access interface. A flow
+// repeated in a batch is rejected after its first occurrence, which could
+// otherwise race it on another worker.
+static void flow_batch_result(const openolt::Flow& flow, const Status& status,
+                              openolt::FlowResult* result) {
+    result->set_flow_id(flow.flow_id());
+    result->set_flow_type(flow.flow_type());
+    result->set_code(status.error_code());
+    result->set_message(status.error_message());
+}
 
-    bcmos_errno err = bcmbal_cfg_clear(DEFAULT_ATERM_ID, &cfg.hdr);
-    if (err) {
-        BCM_LOG(ERROR, openolt_log_id, "Error %d while removing flow %d, %s\n",
-            err, flow_id, flow_type.c_str());
-        return Status(grpc::StatusCode::INTERNAL, "Failed to remove flow");
+static unsigned flow_shard(const openolt::Flow& flow) {
+    return flow.access_intf_id() >= 0 ? flow.access_intf_id() : 0;
+}
+
+static void flow_batch_validate(const openolt::Flows* flows, std::vector<bcmbal_flow_key>& keys,
+                                std::vector<Status>& status) {
+    std::set<std::pair<uint32_t, int> > seen;
+
+    for (int i = 0; i < flows->flows_size(); i++) {
+        const openolt::Flow& flow = flows->flows(i);
+        memset(&keys[i], 0, sizeof(keys[i]));
+        status[i] = mk_flow_key(flow.flow_id(), flow.flow_type(), &keys[i]);
+        if (status[i].ok() && !seen.insert(std::make_pair(keys[i].flow_id, (int)keys[i].flow_type)).second) {
+            status[i] = Status(grpc::StatusCode::INVALID_ARGUMENT, "flow repeated in batch");
+        }
+    }
+}
+
+Status FlowAddBatch_(const openolt::Flows* flows, openolt::FlowResults* results) {
+    int n = flows->flows_size();
+    std::vector<bcmbal_flow_key> keys(n);
+    std::vector<Status> status(n);
+
+    BCM_LOG(INFO, openolt_log_id, "flow add batch of %d flows\n", n);
+
+    flow_batch_validate(flows, keys, status);
+
+    {
+        FlowState::Update update(flow_state);
+        for (int i = 0; i < n; i++) {
+            if (status[i].ok()) {
+                flow_map_add(update, keys[i], flows->flows(i).gemport_id(), flows->flows(i).port_no(),
+                             flows->flows(i).cookie());
+            }
+        }
+    }
+
+    flow_workers.run(n,
+        [&](size_t i) { return flow_shard(flows->flows(i)); },
+        [&](size_t i) {
+            const openolt::Flow& flow = flows->flows(i);
+            if (status[i].ok()) {
+                status[i] = flow_cfg_set(keys[i], flow.access_intf_id(), flow.onu_id(),
+                                         flow.uni_id(), flow.port_no(), flow.alloc_id(),
+                                         flow.network_intf_id(), flow.gemport_id(),
+                                         flow.classifier(), flow.action(), flow.priority(),
+                                         flow.cookie());
+            }
+        });
+
+    for (int i = 0; i < n; i++) {
+        flow_batch_result(flows->flows(i), status[i], results->add_results());
     }
+    return Status::OK;
+}
+
+Status FlowRemoveBatch_(const openolt::Flows* flows, openolt::FlowResults* results) {
+    int n = flows->flows_size();
+    std::vector<bcmbal_flow_key> keys(n);
+    std::vector<Status> status(n);
 
-    BCM_LOG(INFO, openolt_log_id, "Flow %d, %s removed\n", flow_id, flow_type.c_str());
+    BCM_LOG(INFO, openolt_log_id, "flow remove batch of %d flows\n", n);
+
+    flow_batch_validate(flows, keys, status);
+
+    {
+        FlowState::Update update(flow_state);
+        for (int i = 0; i < n; i++) {
+            if (status[i].ok()) {
+                flow_map_remove(update, keys[i]);
+            }
+        }
+    }
+
+    flow_workers.run(n,
+        [&](size_t i) { return flow_shard(flows->flows(i)); },
+        [&](size_t i) {
+            if (status[i].ok()) {
+                status[i] = flow_cfg_clear(keys[i], flows->flows(i).flow_type());
+            }
+        });
+
+    for (int i = 0; i < n; i++) {
+        flow_batch_result(flows->flows(i), status[i], results->add_results());
+    }
     return Status::OK;
 }
 
@@ -1062,16 +1181,17 @@ Status SchedAdd_(std::string direction, uint32_t intf_id, uint32_t onu_id, uint3
             BCMBAL_CFG_PROP_SET(&cfg, tm_queue, rate, rate);
         }
 
-        err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &cfg.hdr);
+        err = bal_cfg_set(DEFAULT_ATERM_ID, &cfg.hdr);
         if (err) {
             BCM_LOG(ERROR, openolt_log_id, "Failed to create subscriber downstream tm queue, id %d, sched_id %d, intf_id %d, onu_id %d, uni_id %d, port_no %u, alt_id %d\n",
                     key.id, key.sched_id, intf_id, onu_id, uni_id, port_no, alloc_id);
             return bcm_to_grpc_err(err, "Failed to create subscriber downstream tm queue");
         }
 
-        bcmos_fastlock_lock(&flow_lock);
-        port_to_alloc[port_no] = alloc_id;
-        bcmos_fastlock_unlock(&flow_lock, 0);
+        if (!FlowState::Update(flow_state).set_alloc(port_no, alloc_id)) {
+            BCM_LOG(ERROR, openolt_log_id, "flow state full, port_no %u alloc_id %d not mapped\n",
+                port_no, alloc_id);
+        }
 
         BCM_LOG(INFO, openolt_log_id, "Create downstream sched, id %d, intf_id %d, onu_id %d, uni_id %d, port_no %u, alt_id %d\n",
                 key.id,intf_id,onu_id,uni_id,port_no,alloc_id);
@@ -1112,7 +1232,7 @@ Status SchedAdd_(std::string direction, uint32_t intf_id, uint32_t onu_id, uint3
             BCMBAL_CFG_PROP_SET(&cfg, tm_sched, rate, rate);
         }
 
-        err = bcmbal_cfg_set(DEFAULT_ATERM_ID, &(cfg.hdr));
+        err = bal_cfg_set(DEFAULT_ATERM_ID, &(cfg.hdr));
         if (err) {
             BCM_LOG(ERROR, openolt_log_id, "Failed to create upstream DBA sched, id %d, intf_id %d, onu_id %d, uni_id %d, port_no %u, alloc_id %d\n",
                     key.id, intf_id, onu_id,uni_id,port_no,alloc_id);
@@ -1140,6 +1260,7 @@ Status CreateTconts_(const openolt::Tconts *tconts) {
     openolt::SchedulingPolicy sched_policy;
     openolt::TrafficShapingInfo traffic_shaping_info;
 
+    onuTracer.trace(intf_id, onu_id, ONU_STAGE_TCONTS);
     for (int i = 0; i < tconts->tconts_size(); i++) {
         openolt::Tcont tcont = tconts->tconts(i);
         if (tcont.direction() == openolt::Direction::UPSTREAM) {
@@ -1203,7 +1324,7 @@ Status SchedRemove_(std::string direction, int intf_id, int onu_id, int uni_id,
 
         BCMBAL_CFG_INIT(&tm_cfg_us, tm_sched, tm_key_us);
 
-        err = bcmbal_cfg_clear(DEFAULT_ATERM_ID, &(tm_cfg_us.hdr));
+        err = bal_cfg_clear(DEFAULT_ATERM_ID, &(tm_cfg_us.hdr));
         if (err) {
             BCM_LOG(ERROR, openolt_log_id, "Failed to remove upstream DBA sched, id %d, intf_id %d, onu_id %d\n",
                 tm_key_us.id, intf_id, onu_id);
@@ -1224,16 +1345,14 @@ Status SchedRemove_(std::string direction, int intf_id, int onu_id, int uni_id,
 
 	    BCMBAL_CFG_INIT(&queue_cfg, tm_queue, queue_key);
 
-	    err = bcmbal_cfg_clear(DEFAULT_ATERM_ID, &(queue_cfg.hdr));
+	    err = bal_cfg_clear(DEFAULT_ATERM_ID, &(queue_cfg.hdr));
 	    if (err) {
 		    BCM_LOG(ERROR, openolt_log_id, "Failed to remove downstream tm queue, id %d, sched_id %d, intf_id %d, onu_id %d, uni_id %d, port_no %u, alt_id %d\n",
 				    queue_key.id, queue_key.sched_id, intf_id, onu_id, uni_id, port_no, alloc_id);
 		    return Status(grpc::StatusCode::INTERNAL, "Failed to remove downstream tm queue");
 	    }
 
-        bcmos_fastlock_lock(&flow_lock);
-        port_to_alloc.erase(port_no);
-        bcmos_fastlock_unlock(&flow_lock, 0);
+        FlowState::Update(flow_state).remove_alloc(port_no);
 
 	    BCM_LOG(INFO, openolt_log_id, "Remove upstream DBA sched, id %d, sched_id %d, intf_id %d, onu_id %d, uni_id %d, port_no %u, alt_id %d\n",
 			    queue_key.id, queue_key.sched_id, intf_id, onu_id, uni_id, port_no, alloc_id);
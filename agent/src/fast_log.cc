@@ -0,0 +1,44 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fast_log.h"
+
+static void fast_log_sink(int level, uintptr_t log_id, const char* text) {
+    dev_log_id id = (dev_log_id)log_id;
+
+    switch (level) {
+        case DEV_LOG_LEVEL_FATAL:
+            BCM_LOG(FATAL, id, "%s", text);
+            break;
+        case DEV_LOG_LEVEL_ERROR:
+            BCM_LOG(ERROR, id, "%s", text);
+            break;
+        case DEV_LOG_LEVEL_WARNING:
+            BCM_LOG(WARNING, id, "%s", text);
+            break;
+        case DEV_LOG_LEVEL_INFO:
+            BCM_LOG(INFO, id, "%s", text);
+            break;
+        default:
+            BCM_LOG(DEBUG, id, "%s", text);
+            break;
+    }
+}
+
+void fast_log_init() {
+    fastLog.set_sink(fast_log_sink);
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2018 Open Networking Foundation
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENOLT_SRC_FAST_LOG_H_
+#define OPENOLT_SRC_FAST_LOG_H_
+
+#include "FastLog.h"
+
+extern "C"
+{
+#include <bcmos_system.h>
+#include <bcm_dev_log_task.h>
+}
+
+// BCM_LOG for per packet and per flow messages. Same levels and log ids,
+// but the arguments are recorded raw and the message formatted and written
+// by the thread of fastLog, and each statement logs at most FAST_LOG_RATE
+// messages per second. Arguments must be numbers or C strings. Errors and
+// other rare messages stay with BCM_LOG.
+#define FAST_LOG(level, id, fmt, ...) \
+    do { \
+        if (fast_log_enabled(id, DEV_LOG_LEVEL_##level)) { \
+            static FastLogSite fast_log_site(DEV_LOG_LEVEL_##level, (uintptr_t)(id), fmt); \
+            fastLog.log(fast_log_site, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+static inline bool fast_log_enabled(dev_log_id id, bcm_dev_log_level level) {
+    bcm_dev_log_level print, save;
+    return bcm_dev_log_id_get_level(id, &print, &save) == BCM_ERR_OK && (level <= print || level <= save);
+}
+
+// Has fastLog write through BCM_LOG
+void fast_log_init();
+
+#endif
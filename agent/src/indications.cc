@@ -20,7 +20,10 @@
 #include "stats_collection.h"
 #include "translation.h"
 #include "state.h"
+#include "OnuTracer.h"
+#include "fast_log.h"
 
+#include <cstddef>
 #include <string>
 
 extern "C"
@@ -32,13 +35,13 @@ extern "C"
 
 using grpc::Status;
 
-extern Queue<openolt::Indication> oltIndQ;
+extern IndicationQueue oltIndQ;
 //Queue<openolt::Indication*> oltIndQ;
 
 
 bool subscribed = false;
 
-bcmos_errno OmciIndication(bcmbal_obj *obj);
+static bcmos_errno OmciRx(bcmbal_obj *obj);
 
 std::string bcmbal_to_grpc_intf_type(bcmbal_intf_type intf_type)
 {
@@ -51,8 +54,8 @@ std::string bcmbal_to_grpc_intf_type(bcmbal_intf_type intf_type)
 }
 
 bcmos_errno OltOperIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::OltIndication* olt_ind = new openolt::OltIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kOltInd);
+    openolt::OltIndication* olt_ind = ind->mutable_olt_ind();
     Status status;
 
     bcmbal_access_terminal_oper_status_change *acc_term_ind = (bcmbal_access_terminal_oper_status_change *)obj;
@@ -70,13 +73,12 @@ bcmos_errno OltOperIndication(bcmbal_obj *obj) {
     } else {
         olt_ind->set_oper_state("down");
     }
-    ind.set_allocated_olt_ind(olt_ind);
 
     BCM_LOG(INFO, openolt_log_id, "Olt oper status indication, admin_state: %s oper_state: %s\n",
             admin_state.c_str(),
             olt_ind->oper_state().c_str());
 
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
 
     // Enable all PON interfaces. 
     // 
@@ -106,7 +108,7 @@ bcmos_errno OltOperIndication(bcmbal_obj *obj) {
         ind_subgroup = BCMBAL_IND_SUBGROUP(packet, itu_omci_channel_rx);
         cb_cfg.p_object_key_info = NULL;
         cb_cfg.p_subgroup = &ind_subgroup;
-        cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OmciIndication;
+        cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OmciRx;
         bcmbal_subscribe_ind(0, &cb_cfg);
     }
 
@@ -122,9 +124,8 @@ bcmos_errno OltOperIndication(bcmbal_obj *obj) {
 }
 
 bcmos_errno LosIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::LosIndication* los_ind = new openolt::LosIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::LosIndication* los_ind = ind->mutable_alarm_ind()->mutable_los_ind();
 
     bcmbal_interface_los* bcm_los_ind = (bcmbal_interface_los *) obj;
     int intf_id = interface_key_to_port_no(bcm_los_ind->key);
@@ -136,16 +137,13 @@ bcmos_errno LosIndication(bcmbal_obj *obj) {
     los_ind->set_intf_id(intf_id);
     los_ind->set_status(status);
 
-    alarm_ind->set_allocated_los_ind(los_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno IfIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::IntfIndication* intf_ind = new openolt::IntfIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kIntfInd);
+    openolt::IntfIndication* intf_ind = ind->mutable_intf_ind();
 
     BCM_LOG(INFO, openolt_log_id, "intf indication, intf_id: %d\n",
         ((bcmbal_interface_oper_status_change *)obj)->key.intf_id );
@@ -156,16 +154,15 @@ bcmos_errno IfIndication(bcmbal_obj *obj) {
     } else {
         intf_ind->set_oper_state("down");
     }
-    ind.set_allocated_intf_ind(intf_ind);
 
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
 
     return BCM_ERR_OK;
 }
 
 bcmos_errno IfOperIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::IntfOperIndication* intf_oper_ind = new openolt::IntfOperIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kIntfOperInd);
+    openolt::IntfOperIndication* intf_oper_ind = ind->mutable_intf_oper_ind();
     bcmbal_interface_oper_status_change* bcm_if_oper_ind = (bcmbal_interface_oper_status_change *) obj;
 
     intf_oper_ind->set_type(bcmbal_to_grpc_intf_type(bcm_if_oper_ind->key.intf_type));
@@ -183,16 +180,13 @@ bcmos_errno IfOperIndication(bcmbal_obj *obj) {
         intf_oper_ind->oper_state().c_str(),
         bcm_if_oper_ind->data.admin_state);
 
-    ind.set_allocated_intf_oper_ind(intf_oper_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuAlarmIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuAlarmIndication* onu_alarm_ind = new openolt::OnuAlarmIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuAlarmIndication* onu_alarm_ind = ind->mutable_alarm_ind()->mutable_onu_alarm_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &((bcmbal_subscriber_terminal_sub_term_alarm*)obj)->key;
@@ -210,17 +204,13 @@ bcmos_errno OnuAlarmIndication(bcmbal_obj *obj) {
     onu_alarm_ind->set_lopc_miss_status(alarm_status_to_string(alarms->lopc_miss));
     onu_alarm_ind->set_lopc_mic_error_status(alarm_status_to_string(alarms->lopc_mic_error));
 
-    alarm_ind->set_allocated_onu_alarm_ind(onu_alarm_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuDyingGaspIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::DyingGaspIndication* dg_ind = new openolt::DyingGaspIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::DyingGaspIndication* dg_ind = ind->mutable_alarm_ind()->mutable_dying_gasp_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_dgi*)obj)->key);
@@ -236,17 +226,14 @@ bcmos_errno OnuDyingGaspIndication(bcmbal_obj *obj) {
     dg_ind->set_onu_id(key->sub_term_id);
     dg_ind->set_status(alarm_status_to_string(data->dgi_status));
 
-    alarm_ind->set_allocated_dying_gasp_ind(dg_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
-bcmos_errno OnuDiscoveryIndication(bcmbal_cfg *obj) {
-    openolt::Indication ind;
-    openolt::OnuDiscIndication* onu_disc_ind = new openolt::OnuDiscIndication;
-    openolt::SerialNumber* serial_number = new openolt::SerialNumber;
+bcmos_errno OnuDiscoveryIndication(bcmbal_obj *obj) {
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kOnuDiscInd);
+    openolt::OnuDiscIndication* onu_disc_ind = ind->mutable_onu_disc_ind();
+    openolt::SerialNumber* serial_number = onu_disc_ind->mutable_serial_number();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_sub_term_disc*)obj)->key);
@@ -262,17 +249,17 @@ bcmos_errno OnuDiscoveryIndication(bcmbal_cfg *obj) {
     onu_disc_ind->set_intf_id(key->intf_id);
     serial_number->set_vendor_id(reinterpret_cast<const char *>(in_serial_number->vendor_id), 4);
     serial_number->set_vendor_specific(reinterpret_cast<const char *>(in_serial_number->vendor_specific), 8);
-    onu_disc_ind->set_allocated_serial_number(serial_number);
-    ind.set_allocated_onu_disc_ind(onu_disc_ind);
 
-    oltIndQ.push(ind);
+    onuTracer.discovered(key->intf_id, reinterpret_cast<const char *>(in_serial_number->vendor_id),
+        reinterpret_cast<const char *>(in_serial_number->vendor_specific));
+    oltIndQ.push(std::move(ind));
 
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::OnuIndication* onu_ind = new openolt::OnuIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kOnuInd);
+    openolt::OnuIndication* onu_ind = ind->mutable_onu_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_oper_status_change*)obj)->key);
@@ -295,16 +282,17 @@ bcmos_errno OnuIndication(bcmbal_obj *obj) {
     } else {
         onu_ind->set_admin_state("down");
     }
+    // Traced here only, OnuOperIndication sees the same transitions
+    onuTracer.trace(key->intf_id, key->sub_term_id,
+        data->new_oper_status == BCMBAL_STATUS_UP ? ONU_STAGE_UP : ONU_STAGE_DOWN);
 
-    ind.set_allocated_onu_ind(onu_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuOperIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::OnuIndication* onu_ind = new openolt::OnuIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kOnuInd);
+    openolt::OnuIndication* onu_ind = ind->mutable_onu_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_oper_status_change*)obj)->key);
@@ -325,18 +313,16 @@ bcmos_errno OnuOperIndication(bcmbal_obj *obj) {
         onu_ind->set_admin_state("down");
     }
 
-    ind.set_allocated_onu_ind(onu_ind);
-
     BCM_LOG(INFO, openolt_log_id, "onu oper state indication, intf_id %d, onu_id %d, old oper state %d, new oper state %s, admin_state %s\n",
         key->intf_id, key->sub_term_id, data->old_oper_status, onu_ind->oper_state().c_str(), onu_ind->admin_state().c_str());
 
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OmciIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::OmciIndication* omci_ind = new openolt::OmciIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kOmciInd);
+    openolt::OmciIndication* omci_ind = ind->mutable_omci_ind();
     bcmbal_packet_itu_omci_channel_rx *in =
         (bcmbal_packet_itu_omci_channel_rx *)obj;
 
@@ -346,17 +332,17 @@ bcmos_errno OmciIndication(bcmbal_obj *obj) {
 
     omci_ind->set_intf_id(in->key.packet_send_dest.u.itu_omci_channel.intf_id);
     omci_ind->set_onu_id(in->key.packet_send_dest.u.itu_omci_channel.sub_term_id);
-    omci_ind->set_pkt(in->data.pkt.val, in->data.pkt.len);
+    omci_ind->mutable_pkt()->assign((const char *)in->data.pkt.val, in->data.pkt.len);
+    onuTracer.trace(omci_ind->intf_id(), omci_ind->onu_id(), ONU_STAGE_OMCI_IN);
 
-    ind.set_allocated_omci_ind(omci_ind);
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
 
     return BCM_ERR_OK;
 }
 
 bcmos_errno PacketIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::PacketIndication* pkt_ind = new openolt::PacketIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kPktInd);
+    openolt::PacketIndication* pkt_ind = ind->mutable_pkt_ind();
     bcmbal_packet_bearer_channel_rx *in = (bcmbal_packet_bearer_channel_rx *)obj;
 
     uint32_t port_no = GetPortNum_(in->data.flow_id);
@@ -364,16 +350,14 @@ bcmos_errno PacketIndication(bcmbal_obj *obj) {
     pkt_ind->set_intf_id(in->data.intf_id);
     pkt_ind->set_gemport_id(in->data.svc_port);
     pkt_ind->set_flow_id(in->data.flow_id);
-    pkt_ind->set_pkt(in->data.pkt.val, in->data.pkt.len);
+    pkt_ind->mutable_pkt()->assign((const char *)in->data.pkt.val, in->data.pkt.len);
     pkt_ind->set_port_no(port_no);
     pkt_ind->set_cookie(in->data.flow_cookie);
 
-    ind.set_allocated_pkt_ind(pkt_ind);
-
-    BCM_LOG(INFO, openolt_log_id, "packet indication, intf_type %s, intf_id %d, svc_port %d, flow_id %d port_no %d cookie %llu\n",
+    FAST_LOG(INFO, openolt_log_id, "packet indication, intf_type %s, intf_id %d, svc_port %d, flow_id %d port_no %d cookie %llu\n",
         pkt_ind->intf_type().c_str(), in->data.intf_id, in->data.svc_port, in->data.flow_id, port_no, in->data.flow_cookie);
 
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
 
     return BCM_ERR_OK;
 }
@@ -409,9 +393,8 @@ bcmos_errno McastGroupIndication(bcmbal_obj *obj) {
 }
 
 bcmos_errno OnuStartupFailureIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuStartupFailureIndication* sufi_ind = new openolt::OnuStartupFailureIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuStartupFailureIndication* sufi_ind = ind->mutable_alarm_ind()->mutable_onu_startup_fail_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_sufi*)obj)->key);
@@ -426,17 +409,13 @@ bcmos_errno OnuStartupFailureIndication(bcmbal_obj *obj) {
     sufi_ind->set_onu_id(key->sub_term_id);
     sufi_ind->set_status(alarm_status_to_string(data->sufi_status));
 
-    alarm_ind->set_allocated_onu_startup_fail_ind(sufi_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuSignalDegradeIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuSignalDegradeIndication* sdi_ind = new openolt::OnuSignalDegradeIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuSignalDegradeIndication* sdi_ind = ind->mutable_alarm_ind()->mutable_onu_signal_degrade_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_sdi*)obj)->key);
@@ -452,17 +431,13 @@ bcmos_errno OnuSignalDegradeIndication(bcmbal_obj *obj) {
     sdi_ind->set_status(alarm_status_to_string(data->sdi_status));
     sdi_ind->set_inverse_bit_error_rate(data->ber);
 
-    alarm_ind->set_allocated_onu_signal_degrade_ind(sdi_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuDriftOfWindowIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuDriftOfWindowIndication* dowi_ind = new openolt::OnuDriftOfWindowIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuDriftOfWindowIndication* dowi_ind = ind->mutable_alarm_ind()->mutable_onu_drift_of_window_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_dowi*)obj)->key);
@@ -479,17 +454,13 @@ bcmos_errno OnuDriftOfWindowIndication(bcmbal_obj *obj) {
     dowi_ind->set_drift(data->drift_value);
     dowi_ind->set_new_eqd(data->new_eqd);
 
-    alarm_ind->set_allocated_onu_drift_of_window_ind(dowi_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuLossOfOmciChannelIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuLossOfOmciChannelIndication* looci_ind = new openolt::OnuLossOfOmciChannelIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuLossOfOmciChannelIndication* looci_ind = ind->mutable_alarm_ind()->mutable_onu_loss_omci_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_looci*)obj)->key);
@@ -504,17 +475,13 @@ bcmos_errno OnuLossOfOmciChannelIndication(bcmbal_obj *obj) {
     looci_ind->set_onu_id(key->sub_term_id);
     looci_ind->set_status(alarm_status_to_string(data->looci_status));
 
-    alarm_ind->set_allocated_onu_loss_omci_ind(looci_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuSignalsFailureIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuSignalsFailureIndication* sfi_ind = new openolt::OnuSignalsFailureIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuSignalsFailureIndication* sfi_ind = ind->mutable_alarm_ind()->mutable_onu_signals_fail_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_sfi*)obj)->key);
@@ -531,17 +498,13 @@ bcmos_errno OnuSignalsFailureIndication(bcmbal_obj *obj) {
     sfi_ind->set_status(alarm_status_to_string(data->sfi_status));
     sfi_ind->set_inverse_bit_error_rate(data->ber);
 
-    alarm_ind->set_allocated_onu_signals_fail_ind(sfi_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuTransmissionInterferenceWarningIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuTransmissionInterferenceWarning* tiwi_ind = new openolt::OnuTransmissionInterferenceWarning;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuTransmissionInterferenceWarning* tiwi_ind = ind->mutable_alarm_ind()->mutable_onu_tiwi_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_tiwi*)obj)->key);
@@ -557,17 +520,13 @@ bcmos_errno OnuTransmissionInterferenceWarningIndication(bcmbal_obj *obj) {
     tiwi_ind->set_status(alarm_status_to_string(data->tiwi_status));
     tiwi_ind->set_drift(data->drift_value);
 
-    alarm_ind->set_allocated_onu_tiwi_ind(tiwi_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuActivationFailureIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuActivationFailureIndication* activation_fail_ind = new openolt::OnuActivationFailureIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuActivationFailureIndication* activation_fail_ind = ind->mutable_alarm_ind()->mutable_onu_activation_fail_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_sub_term_act_fail*)obj)->key);
@@ -579,17 +538,13 @@ bcmos_errno OnuActivationFailureIndication(bcmbal_obj *obj) {
     activation_fail_ind->set_intf_id(key->intf_id);
     activation_fail_ind->set_onu_id(key->sub_term_id);
 
-    alarm_ind->set_allocated_onu_activation_fail_ind(activation_fail_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
-
-    oltIndQ.push(ind);
+    oltIndQ.push(std::move(ind));
     return BCM_ERR_OK;
 }
 
 bcmos_errno OnuProcessingErrorIndication(bcmbal_obj *obj) {
-    openolt::Indication ind;
-    openolt::AlarmIndication* alarm_ind = new openolt::AlarmIndication;
-    openolt::OnuProcessingErrorIndication* onu_proc_error_ind = new openolt::OnuProcessingErrorIndication;
+    IndicationPtr ind = oltIndQ.get(openolt::Indication::kAlarmInd);
+    openolt::OnuProcessingErrorIndication* onu_proc_error_ind = ind->mutable_alarm_ind()->mutable_onu_processing_error_ind();
 
     bcmbal_subscriber_terminal_key *key =
         &(((bcmbal_subscriber_terminal_processing_error*)obj)->key);
@@ -601,10 +556,62 @@ bcmos_errno OnuProcessingErrorIndication(bcmbal_obj *obj) {
     onu_proc_error_ind->set_intf_id(key->intf_id);
     onu_proc_error_ind->set_onu_id(key->sub_term_id);
 
-    alarm_ind->set_allocated_onu_processing_error_ind(onu_proc_error_ind);
-    ind.set_allocated_alarm_ind(alarm_ind);
+    oltIndQ.push(std::move(ind));
+    return BCM_ERR_OK;
+}
+
+// BAL calls the callbacks registered below on its own threads. They only
+// copy the BAL object, and the packet it carries if any, to the indication
+// shard of the PON it concerns; the handlers above run on the shard's
+// worker, so the indications of a PON keep their order. Packet-in goes on
+// the shard's packet ring, behind every other kind of indication.
+template <bcmos_errno (*Handler)(bcmbal_obj *)>
+static void RunHandler(void *obj) {
+    Handler((bcmbal_obj *)obj);
+}
+
+// Interfaces and subscriber terminals carry the PON in their key
+template <typename T>
+static unsigned IntfShard(const T *obj) {
+    return obj->key.intf_id;
+}
+
+// OLT wide indications, or those with no PON to go by
+template <typename T>
+static unsigned OltShard(const T *obj) {
+    return 0;
+}
 
-    oltIndQ.push(ind);
+template <typename T, unsigned (*Shard)(const T *), bcmos_errno (*Handler)(bcmbal_obj *)>
+static bcmos_errno Rx(bcmbal_obj *obj) {
+    if (!indShards.submit(Shard((const T *)obj), RunHandler<Handler>, obj, sizeof(T))) {
+        FAST_LOG(ERROR, openolt_log_id, "indication lost, no memory to queue it, obj_type %d\n",
+            obj->obj_type);
+    }
+    return BCM_ERR_OK;
+}
+
+static bcmos_errno OmciRx(bcmbal_obj *obj) {
+    bcmbal_packet_itu_omci_channel_rx *in = (bcmbal_packet_itu_omci_channel_rx *)obj;
+
+    if (!indShards.submit(in->key.packet_send_dest.u.itu_omci_channel.intf_id,
+                          RunHandler<OmciIndication>, in, sizeof(*in), in->data.pkt.val, in->data.pkt.len,
+                          offsetof(bcmbal_packet_itu_omci_channel_rx, data.pkt.val))) {
+        FAST_LOG(ERROR, openolt_log_id, "omci indication lost, no memory to queue it, intf_id %d\n",
+            in->key.packet_send_dest.u.itu_omci_channel.intf_id);
+    }
+    return BCM_ERR_OK;
+}
+
+static bcmos_errno PacketRx(bcmbal_obj *obj) {
+    bcmbal_packet_bearer_channel_rx *in = (bcmbal_packet_bearer_channel_rx *)obj;
+
+    if (!indShards.submit_packet(in->data.intf_id,
+                                 RunHandler<PacketIndication>, in, sizeof(*in), in->data.pkt.val, in->data.pkt.len,
+                                 offsetof(bcmbal_packet_bearer_channel_rx, data.pkt.val))) {
+        FAST_LOG(WARNING, openolt_log_id, "packet indication dropped, intf_id %d shard full\n",
+            in->data.intf_id);
+    }
     return BCM_ERR_OK;
 }
 
@@ -622,7 +629,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_ACCESS_TERMINAL;
     ind_subgroup = bcmbal_access_terminal_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OltOperIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_access_terminal_oper_status_change, OltShard, OltOperIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Olt operations state change indication subscribe failed");
     }
@@ -631,7 +638,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_INTERFACE;
     ind_subgroup = bcmbal_interface_auto_id_los;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)LosIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_interface_los, IntfShard, LosIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "LOS indication subscribe failed");
     }
@@ -640,7 +647,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_INTERFACE;
     ind_subgroup = bcmbal_interface_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)IfIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_interface_oper_status_change, IntfShard, IfIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Interface indication subscribe failed");
     }
@@ -649,7 +656,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_INTERFACE;
     ind_subgroup = bcmbal_interface_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)IfOperIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_interface_oper_status_change, IntfShard, IfOperIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Interface operations state change indication subscribe failed");
     }
@@ -658,7 +665,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sub_term_alarm;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuAlarmIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sub_term_alarm, IntfShard, OnuAlarmIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu alarm indication subscribe failed");
     }
@@ -667,7 +674,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_dgi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuDyingGaspIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_dgi, IntfShard, OnuDyingGaspIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu dying-gasp indication subscribe failed");
     }
@@ -676,7 +683,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sub_term_disc;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuDiscoveryIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sub_term_disc, IntfShard, OnuDiscoveryIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu discovery indication subscribe failed");
     }
@@ -685,7 +692,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_oper_status_change, IntfShard, OnuIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu indication subscribe failed");
     }
@@ -693,7 +700,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuOperIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_oper_status_change, IntfShard, OnuOperIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu operational state change indication subscribe failed");
     }
@@ -702,7 +709,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_PACKET;
     ind_subgroup = bcmbal_packet_auto_id_bearer_channel_rx;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)PacketIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)PacketRx;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Packet indication subscribe failed");
     }
@@ -711,7 +718,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_FLOW;
     ind_subgroup = bcmbal_flow_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)FlowOperIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_flow_oper_status_change, OltShard, FlowOperIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Flow operational state change indication subscribe failed");
     }
@@ -720,7 +727,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_FLOW;
     ind_subgroup = bcmbal_flow_auto_id_ind;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)FlowIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_flow_ind, OltShard, FlowIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Flow indication subscribe failed");
     }
@@ -729,7 +736,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_TM_QUEUE;
     ind_subgroup = bcmbal_tm_queue_auto_id_ind;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)TmQIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_tm_queue_ind, OltShard, TmQIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Traffic mgmt queue indication subscribe failed");
     }
@@ -739,7 +746,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_TM_SCHED;
     ind_subgroup = bcmbal_tm_sched_auto_id_oper_status_change;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)TmSchedIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_tm_sched_oper_status_change, OltShard, TmSchedIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Traffic mgmt queue indication subscribe failed");
     }
@@ -749,7 +756,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_GROUP;
     ind_subgroup = bcmbal_group_auto_id_ind;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)McastGroupIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_group_ind, OltShard, McastGroupIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "Multicast group indication subscribe failed");
     }
@@ -760,7 +767,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sufi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuStartupFailureIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sufi, IntfShard, OnuStartupFailureIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu startup failure indication subscribe failed");
     }
@@ -769,7 +776,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sdi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuSignalDegradeIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sdi, IntfShard, OnuSignalDegradeIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu sdi indication subscribe failed");
     }
@@ -778,7 +785,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_dowi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuDriftOfWindowIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_dowi, IntfShard, OnuDriftOfWindowIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu dowi indication subscribe failed");
     }
@@ -787,7 +794,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_looci;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuLossOfOmciChannelIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_looci, IntfShard, OnuLossOfOmciChannelIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu looci indication subscribe failed");
     }
@@ -796,7 +803,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sfi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuSignalsFailureIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sfi, IntfShard, OnuSignalsFailureIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu sfi indication subscribe failed");
     }
@@ -805,7 +812,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_tiwi;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuTransmissionInterferenceWarningIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_tiwi, IntfShard, OnuTransmissionInterferenceWarningIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu tiwi indication subscribe failed");
     }
@@ -814,7 +821,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_sub_term_act_fail;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuActivationFailureIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_sub_term_act_fail, IntfShard, OnuActivationFailureIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu activation falaire indication subscribe failed");
     }
@@ -823,7 +830,7 @@ Status SubscribeIndication() {
     cb_cfg.obj_type = BCMBAL_OBJ_ID_SUBSCRIBER_TERMINAL;
     ind_subgroup = bcmbal_subscriber_terminal_auto_id_processing_error;
     cb_cfg.p_subgroup = &ind_subgroup;
-    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)OnuProcessingErrorIndication;
+    cb_cfg.ind_cb_hdlr = (f_bcmbal_ind_handler)Rx<bcmbal_subscriber_terminal_processing_error, IntfShard, OnuProcessingErrorIndication>;
     if (BCM_ERR_OK != bcmbal_subscribe_ind(DEFAULT_ATERM_ID, &cb_cfg)) {
         return Status(grpc::StatusCode::INTERNAL, "onu processing error indication subscribe failed");
     }
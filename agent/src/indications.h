@@ -20,13 +20,15 @@
 
 #include <grpc++/grpc++.h>
 #include <openolt.grpc.pb.h>
-#include "Queue.h"
+#include "IndicationQueue.h"
+#include "IndicationShards.h"
 
 extern "C" {
     #include <bcm_dev_log_task.h>
 }
 
-extern Queue<openolt::Indication> oltIndQ;
+extern IndicationQueue oltIndQ;
+extern IndicationShards indShards;
 extern grpc::Status SubscribeIndication();
 extern dev_log_id openolt_log_id;
 extern dev_log_id omci_log_id;
@@ -17,12 +17,19 @@
 
 #include "stats_collection.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unistd.h>
 
 #include <openolt.grpc.pb.h>
 #include "indications.h"
 #include "core.h"
 #include "translation.h"
+#include "bal_metrics.h"
+#include "StatsCollector.h"
+#include "FlowRegistry.h"
+#include "fast_log.h"
 
 extern "C"
 {
@@ -32,17 +39,10 @@ extern "C"
 #include <flow_fsm.h>
 }
 
-//FIXME
-#define FLOWS_COUNT 100
+// Flows programmed through this agent, see core.cc
+extern FlowRegistry flow_registry;
 
-bcmbal_flow_key* flows_keys = new bcmbal_flow_key[FLOWS_COUNT];
-
-void init_stats() {
-    memset(flows_keys, 0, FLOWS_COUNT * sizeof(bcmbal_flow_key));
-}
-
-openolt::PortStatistics* get_default_port_statistics() {
-    openolt::PortStatistics* port_stats = new openolt::PortStatistics;
+void set_default_port_statistics(openolt::PortStatistics* port_stats) {
     port_stats->set_intf_id(-1);
     port_stats->set_rx_bytes(-1);
     port_stats->set_rx_packets(-1);
@@ -58,37 +58,30 @@ openolt::PortStatistics* get_default_port_statistics() {
     port_stats->set_tx_error_packets(-1);
     port_stats->set_rx_crc_errors(-1);
     port_stats->set_bip_errors(-1);
-
-    return port_stats;
 }
 
-#if 0
-openolt::FlowStatistics* get_default_flow_statistics() {
-    openolt::FlowStatistics* flow_stats = new openolt::FlowStatistics;
+void set_default_flow_statistics(openolt::FlowStatistics* flow_stats) {
     flow_stats->set_flow_id(-1);
     flow_stats->set_rx_bytes(-1);
     flow_stats->set_rx_packets(-1);
     flow_stats->set_tx_bytes(-1);
     flow_stats->set_tx_packets(-1);
-
-    return flow_stats;
 }
-#endif
 
-openolt::PortStatistics* collectPortStatistics(bcmbal_interface_key key) {
+bcmos_errno collectPortStatistics(bcmbal_interface_key key, openolt::PortStatistics* port_stats) {
 
     bcmos_errno err;
     bcmbal_interface_stat stat;     /**< declare main API struct */
     bcmos_bool clear_on_read = false;
 
-    openolt::PortStatistics* port_stats = get_default_port_statistics();
+    set_default_port_statistics(port_stats);
 
     /* init the API struct */
     BCMBAL_STAT_INIT(&stat, interface, key);
     BCMBAL_STAT_PROP_GET(&stat, interface, all_properties);
 
     /* call API */
-    err = bcmbal_stat_get(DEFAULT_ATERM_ID, &stat.hdr, clear_on_read);
+    err = bal_stat_get(DEFAULT_ATERM_ID, &stat.hdr, clear_on_read);
     if (err == BCM_ERR_OK)
     {
         //std::cout << "Interface statistics retrieved"
@@ -119,19 +112,18 @@ openolt::PortStatistics* collectPortStatistics(bcmbal_interface_key key) {
     time(&now);
     port_stats->set_timestamp((int)now);
 
-    return port_stats;
-
+    return err;
 }
 
-#if 0
-openolt::FlowStatistics* collectFlowStatistics(bcmbal_flow_id flow_id, bcmbal_flow_type flow_type) {
+bcmos_errno collectFlowStatistics(bcmbal_flow_id flow_id, bcmbal_flow_type flow_type,
+                                  openolt::FlowStatistics* flow_stats) {
 
     bcmos_errno err;
     bcmbal_flow_stat stat;     /**< declare main API struct */
     bcmbal_flow_key key = { }; /**< declare key */
     bcmos_bool clear_on_read = false;
 
-    openolt::FlowStatistics* flow_stats = get_default_flow_statistics();
+    set_default_flow_statistics(flow_stats);
     //Key
     key.flow_id = flow_id;
     key.flow_type = flow_type;
@@ -140,111 +132,143 @@ openolt::FlowStatistics* collectFlowStatistics(bcmbal_flow_id flow_id, bcmbal_fl
     BCMBAL_STAT_INIT(&stat, flow, key);
     BCMBAL_STAT_PROP_GET(&stat, flow, all_properties);
 
-    err = bcmbal_stat_get(DEFAULT_ATERM_ID, &stat.hdr, clear_on_read);
+    err = bal_stat_get(DEFAULT_ATERM_ID, &stat.hdr, clear_on_read);
 
     if (err == BCM_ERR_OK)
     {
-        std::cout << "Flow statistics retrieved"
-                  << " flow_id:" << flow_id
-                  << " flow_type:" << flow_type << std::endl;
-
         flow_stats->set_rx_bytes(stat.data.rx_bytes);
         flow_stats->set_rx_packets(stat.data.rx_packets);
         flow_stats->set_tx_bytes(stat.data.tx_bytes);
         flow_stats->set_tx_packets(stat.data.tx_packets);
 
     } else {
-        std::cout   << "ERROR: Failed to retrieve flow statistics"
-                    << " flow_id:" << flow_id
-                    << " flow_type:" << flow_type << std::endl;
+        FAST_LOG(ERROR, openolt_log_id, "Failed to retrieve flow statistics, flow_id %d, flow_type %d\n",
+            (int)flow_id, (int)flow_type);
     }
 
-    return flow_stats;
+    flow_stats->set_flow_id(flow_id);
+    time_t now;
+    time(&now);
+    flow_stats->set_timestamp((int)now);
+
+    return err;
 }
-#endif
 
 
-void stats_collection() {
+static std::vector<StatsPort> stats_ports();
+static bool collect_port_stats(const StatsPort& port, openolt::PortStatistics* port_stats);
+
+// Reads port statistics on STATS_WORKERS threads of its own
+static StatsCollector stats_collector(STATS_WORKERS, STATS_DEADLINE_MS,
+                                      stats_ports, collect_port_stats);
+
+// The ports of a collection round, none while Voltha is not connected or
+// the OLT is not up
+static std::vector<StatsPort> stats_ports() {
+    std::vector<StatsPort> ports;
 
     if (!state.is_connected()) {
         BCM_LOG(INFO, openolt_log_id, "Voltha is not connected, do not collect stats\n");
-        return;
+        return ports;
     }
     if (!state.is_activated()) {
         BCM_LOG(INFO, openolt_log_id, "The OLT is not up, do not collect stats\n");
-        return;
+        return ports;
     }
 
-
     BCM_LOG(DEBUG, openolt_log_id, "Collecting statistics\n");
+    BCM_LOG(DEBUG, openolt_log_id, "Statistics collection: %s\n", stats_collector.timing_to_str().c_str());
+    BCM_LOG(DEBUG, openolt_log_id, "Indication queue: %s\n", oltIndQ.counters_to_str().c_str());
 
     //Ports statistics
 
     //Uplink ports
     for (int i = 0; i < NumNniIf_(); i++) {
-        bcmbal_interface_key nni_interface;
-        nni_interface.intf_type = BCMBAL_INTF_TYPE_NNI;
-        nni_interface.intf_id = i;
-
-        openolt::PortStatistics* port_stats = collectPortStatistics(nni_interface);
-
-        openolt::Indication ind;
-        ind.set_allocated_port_stats(port_stats);
-        oltIndQ.push(ind);
+        StatsPort port = { BCMBAL_INTF_TYPE_NNI, (uint32_t)i, "nni-" + std::to_string(i) };
+        ports.push_back(port);
     }
     //Pon ports
     for (int i = 0; i < NumPonIf_(); i++) {
-        bcmbal_interface_key pon_interface;
-        pon_interface.intf_type = BCMBAL_INTF_TYPE_PON;
-        pon_interface.intf_id = i;
+        StatsPort port = { BCMBAL_INTF_TYPE_PON, (uint32_t)i, "pon-" + std::to_string(i) };
+        ports.push_back(port);
+    }
 
-        openolt::PortStatistics* port_stats = collectPortStatistics(pon_interface);
+    return ports;
+}
+
+static bool collect_port_stats(const StatsPort& port, openolt::PortStatistics* port_stats) {
+    bcmbal_interface_key key;
+    key.intf_type = (bcmbal_intf_type)port.kind;
+    key.intf_id = port.intf_id;
+
+    return collectPortStatistics(key, port_stats) == BCM_ERR_OK;
+}
+
+// Starts a collection round without waiting for it. The scheduler calls
+// this every COLLECTION_PERIOD seconds.
+void stats_collection() {
+    stats_collector.trigger();
+}
+
+// Reads the statistics of the next slice of flows, at most FLOW_STATS_SLICE
+// flows out of FLOW_STATS_SCAN flow_registry entries, and publishes them as
+// one batch, so the cost per slice stays flat however many flows there are;
+// a full sweep of the flows takes proportionally more slices.
+static void flow_stats_slice() {
+    static uint32_t cursor = 0;
+
+    if (!state.is_connected() || !state.is_activated()) {
+        return;
+    }
 
-        openolt::Indication ind;
-        ind.set_allocated_port_stats(port_stats);
-        oltIndQ.push(ind);
+    std::vector<FlowKey> flows;
+    flows.reserve(FLOW_STATS_SLICE);
+    flow_registry.scan(&cursor, FLOW_STATS_SCAN, FLOW_STATS_SLICE, &flows);
+
+    std::vector<IndicationPtr> inds;
+    inds.reserve(flows.size());
+    for (size_t i = 0; i < flows.size(); i++) {
+        IndicationPtr ind = oltIndQ.get(openolt::Indication::kFlowStats);
+        bcmos_errno err = collectFlowStatistics(flows[i].flow_id,
+            flows[i].downstream ? BCMBAL_FLOW_TYPE_DOWNSTREAM : BCMBAL_FLOW_TYPE_UPSTREAM,
+            ind->mutable_flow_stats());
+        if (err == BCM_ERR_OK) {
+            inds.push_back(std::move(ind));
+        }
     }
 
-    //Flows statistics
-    // flow_inst *current_entry = NULL;
-    //
-    // TAILQ_FOREACH(current_entry,
-    //               &FLOW_FSM_FLOW_LIST_CTX_PTR->active_flow_list,
-    //               flow_inst_next) {
-    // int flows_measurements = 0;
-    //
-    // for (int i = 0; i < FLOWS_COUNT; i++) {
-    //
-    //     // bcmbal_flow_id flow_id = current_entry->api_req_flow_info.key.flow_id;
-    //     // bcmbal_flow_type flow_type = current_entry->api_req_flow_info.key.flow_type;
-    //
-    //     if (flows_keys[i].flow_id != 0) {
-    //         openolt::FlowStatistics* flow_stats = collectFlowStatistics(flows_keys[i].flow_id, flows_keys[i].flow_type);
-    //         if (flow_stats->rx_packets() == -1) {
-    //             //It Failed
-    //             flows_keys[i].flow_id = 0;
-    //         } else {
-    //             flow_stats->set_flow_id(flows_keys[i].flow_id);
-    //             time(&now);
-    //             flow_stats->set_timestamp((int)now);
-    //             openolt::Indication ind;
-    //             ind.set_allocated_flow_stats(flow_stats);
-    //             oltIndQ.push(ind);
-    //             flows_measurements ++;
-    //         }
-    //     }
-    //
-    // }
-    // std::cout << "Stats of " << flows_measurements << " flows retrieved" << std::endl;
+    if (!inds.empty()) {
+        BCM_LOG(DEBUG, openolt_log_id, "Statistics of %d flows retrieved\n", (int)inds.size());
+        oltIndQ.push_batch(inds);
+    }
+}
 
+// The slices are read on a thread of their own: a slice is up to
+// FLOW_STATS_SLICE blocking BAL reads, too long for the scheduler's thread
+static std::mutex flow_stats_mutex;
+static std::condition_variable flow_stats_cv;
+static bool flow_stats_triggered = false;
+
+static void flow_stats_run() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(flow_stats_mutex);
+            flow_stats_cv.wait(lock, []() { return flow_stats_triggered; });
+            flow_stats_triggered = false;
+        }
+        flow_stats_slice();
+    }
 }
 
-/* Storing flow keys, temporary */
-// void register_new_flow(bcmbal_flow_key key) {
-//     for (int i = 0; i < FLOWS_COUNT; i++) {
-//         if (flows_keys[i].flow_id == 0) {
-//             flows_keys[i] = key;
-//             break;
-//         }
-//     }
-// }
+// Starts the next slice, or has it start right after the running one,
+// without waiting. The scheduler calls this every FLOW_STATS_PERIOD_MS.
+void flow_stats_sweep() {
+    static std::once_flag started;
+    std::call_once(started, []() { std::thread(flow_stats_run).detach(); });
+
+    {
+        std::lock_guard<std::mutex> lock(flow_stats_mutex);
+        flow_stats_triggered = true;
+    }
+    flow_stats_cv.notify_one();
+}
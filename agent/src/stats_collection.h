@@ -25,15 +25,12 @@ extern "C"
 #include <bal_model_types.h>
 }
 
-void init_stats();
 void stop_collecting_statistics();
-openolt::PortStatistics* get_default_port_statistics();
-openolt::PortStatistics* collectPortStatistics(bcmbal_interface_key key);
-#if 0
-openolt::FlowStatistics* get_default_flow_statistics();
-openolt::FlowStatistics* collectFlowStatistics(bcmbal_flow_id flow_id, bcmbal_flow_type flow_type);
-void register_new_flow(bcmbal_flow_key key);
-#endif
+void set_default_port_statistics(openolt::PortStatistics* port_stats);
+bcmos_errno collectPortStatistics(bcmbal_interface_key key, openolt::PortStatistics* port_stats);
+void set_default_flow_statistics(openolt::FlowStatistics* flow_stats);
+bcmos_errno collectFlowStatistics(bcmbal_flow_id flow_id, bcmbal_flow_type flow_type,
+                                  openolt::FlowStatistics* flow_stats);
 
 
 #endif